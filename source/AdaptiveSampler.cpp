@@ -0,0 +1,117 @@
+#include "AdaptiveSampler.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace dae
+{
+	namespace
+	{
+		//Luminance added to the denominator of the relative error so near-black pixels do not chase zero noise
+		constexpr float ErrorLuminanceBias = 0.1f;
+	}
+
+	void AdaptiveSampler::BeginFrame(int width, int height)
+	{
+		m_Width = width;
+		m_Height = height;
+
+		m_Pixels.assign(size_t(width) * height, PixelStatistics{});
+		m_Tiles.clear();
+
+		const int tileSize = std::max(m_Settings.tileSize, 1);
+		for (int y{}; y < height; y += tileSize)
+		{
+			for (int x{}; x < width; x += tileSize)
+			{
+				m_Tiles.push_back(Tile{ x, y, std::min(tileSize, width - x), std::min(tileSize, height - y) });
+			}
+		}
+
+		m_ActiveTileCount = m_Tiles.size();
+	}
+
+	void AdaptiveSampler::AddSample(int px, int py, const ColorRGB& sample)
+	{
+		PixelStatistics& pixel = m_Pixels[px + (py * m_Width)];
+		++pixel.sampleCount;
+
+		const float invCount = 1.f / pixel.sampleCount;
+		pixel.mean += (sample - pixel.mean) * invCount;
+
+		//Welford update on luminance, the quantity the noise threshold is expressed in
+		const float luminance = sample.GetLuminance();
+		const float delta = luminance - pixel.luminanceMean;
+		pixel.luminanceMean += delta * invCount;
+		pixel.luminanceM2 += delta * (luminance - pixel.luminanceMean);
+	}
+
+	void AdaptiveSampler::EndPass()
+	{
+		m_ActiveTileCount = 0;
+
+		for (Tile& tile : m_Tiles)
+		{
+			if (tile.isConverged)
+				continue;
+
+			tile.sampleCount += GetSamplesThisPass(tile);
+
+			if (tile.sampleCount >= m_Settings.maxSamples)
+			{
+				tile.isConverged = true;
+				continue;
+			}
+
+			if (tile.sampleCount >= m_Settings.minSamples)
+			{
+				float maxError{};
+				for (int py{ tile.y }; py < tile.y + tile.height && maxError < m_Settings.noiseThreshold; ++py)
+				{
+					for (int px{ tile.x }; px < tile.x + tile.width; ++px)
+					{
+						maxError = std::max(maxError, GetRelativeError(m_Pixels[px + (py * m_Width)]));
+					}
+				}
+
+				tile.isConverged = maxError < m_Settings.noiseThreshold;
+			}
+
+			if (!tile.isConverged)
+				++m_ActiveTileCount;
+		}
+	}
+
+	uint32_t AdaptiveSampler::GetSamplesThisPass(const Tile& tile) const
+	{
+		if (tile.sampleCount == 0)
+			return std::max(m_Settings.minSamples, 1u);
+
+		return std::min(std::max(m_Settings.samplesPerPass, 1u), m_Settings.maxSamples - tile.sampleCount);
+	}
+
+	float AdaptiveSampler::GetAverageSamplesPerPixel() const
+	{
+		if (m_Pixels.empty())
+			return 0.f;
+
+		uint64_t totalSamples{};
+		for (const PixelStatistics& pixel : m_Pixels)
+		{
+			totalSamples += pixel.sampleCount;
+		}
+
+		return totalSamples / float(m_Pixels.size());
+	}
+
+	float AdaptiveSampler::GetRelativeError(const PixelStatistics& pixel) const
+	{
+		if (pixel.sampleCount < 2)
+			return FLT_MAX;
+
+		const float variance = pixel.luminanceM2 / (pixel.sampleCount - 1);
+		const float standardError = sqrtf(variance / pixel.sampleCount);
+
+		return standardError / (pixel.luminanceMean + ErrorLuminanceBias);
+	}
+}
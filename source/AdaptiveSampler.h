@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Math.h"
+
+namespace dae
+{
+	/**
+	 * \brief Keeps an online (Welford) variance estimate per pixel and decides, per screen tile,
+	 * whether more samples are needed. A tile stops receiving samples once the relative standard error
+	 * of every pixel inside it drops below the noise threshold (or the sample cap is reached).
+	 */
+	class AdaptiveSampler final
+	{
+	public:
+		struct Settings
+		{
+			int tileSize{ 16 };
+			uint32_t minSamples{ 4 };
+			uint32_t maxSamples{ 64 };
+			uint32_t samplesPerPass{ 4 };
+			float noiseThreshold{ 0.02f }; //relative standard error of the pixel luminance
+		};
+
+		struct Tile
+		{
+			int x{};
+			int y{};
+			int width{};
+			int height{};
+
+			uint32_t sampleCount{};
+			bool isConverged{ false };
+		};
+
+		AdaptiveSampler() = default;
+		~AdaptiveSampler() = default;
+
+		AdaptiveSampler(const AdaptiveSampler&) = delete;
+		AdaptiveSampler(AdaptiveSampler&&) noexcept = delete;
+		AdaptiveSampler& operator=(const AdaptiveSampler&) = delete;
+		AdaptiveSampler& operator=(AdaptiveSampler&&) noexcept = delete;
+
+		void BeginFrame(int width, int height);
+		void AddSample(int px, int py, const ColorRGB& sample);
+		void EndPass();
+
+		bool IsFrameConverged() const { return m_ActiveTileCount == 0; }
+		uint32_t GetSamplesThisPass(const Tile& tile) const;
+		ColorRGB GetMean(int px, int py) const { return m_Pixels[px + (py * m_Width)].mean; }
+		float GetAverageSamplesPerPixel() const;
+
+		const std::vector<Tile>& GetTiles() const { return m_Tiles; }
+		Settings& GetSettings() { return m_Settings; }
+
+	private:
+		struct PixelStatistics
+		{
+			ColorRGB mean{};
+			float luminanceMean{};
+			float luminanceM2{};
+			uint32_t sampleCount{};
+		};
+
+		float GetRelativeError(const PixelStatistics& pixel) const;
+
+		Settings m_Settings{};
+
+		std::vector<PixelStatistics> m_Pixels{};
+		std::vector<Tile> m_Tiles{};
+		size_t m_ActiveTileCount{};
+
+		int m_Width{};
+		int m_Height{};
+	};
+}
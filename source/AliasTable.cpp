@@ -0,0 +1,89 @@
+#include "AliasTable.h"
+
+#include <algorithm>
+
+namespace dae
+{
+	void AliasTable::Build(const std::vector<float>& weights)
+	{
+		m_Slots.clear();
+		m_Probabilities.clear();
+
+		double totalWeight{};
+		for (const float weight : weights)
+		{
+			totalWeight += std::max(weight, 0.f);
+		}
+
+		if (totalWeight <= 0.0)
+			return;
+
+		const uint32_t count = uint32_t(weights.size());
+		m_Slots.resize(count);
+		m_Probabilities.resize(count);
+
+		// weights scaled so the average slot holds exactly 1
+		std::vector<double> scaled(count);
+		std::vector<uint32_t> small{};
+		std::vector<uint32_t> large{};
+		for (uint32_t i{}; i < count; ++i)
+		{
+			m_Probabilities[i] = float(std::max(weights[i], 0.f) / totalWeight);
+			scaled[i] = std::max(weights[i], 0.f) / totalWeight * count;
+
+			if (scaled[i] < 1.0)
+				small.push_back(i);
+			else
+				large.push_back(i);
+		}
+
+		// every underfull slot is topped up by a large one, which then may become underfull itself
+		while (!small.empty() && !large.empty())
+		{
+			const uint32_t smallIndex = small.back();
+			small.pop_back();
+			const uint32_t largeIndex = large.back();
+			large.pop_back();
+
+			m_Slots[smallIndex] = Slot{ float(scaled[smallIndex]), largeIndex };
+
+			scaled[largeIndex] -= 1.0 - scaled[smallIndex];
+			if (scaled[largeIndex] < 1.0)
+				small.push_back(largeIndex);
+			else
+				large.push_back(largeIndex);
+		}
+
+		// whatever is left is full up to rounding
+		for (const uint32_t index : large)
+		{
+			m_Slots[index] = Slot{ 1.f, index };
+		}
+
+		for (const uint32_t index : small)
+		{
+			m_Slots[index] = Slot{ 1.f, index };
+		}
+	}
+
+	uint32_t AliasTable::Sample(float u, float& probability) const
+	{
+		const float scaled = u * m_Slots.size();
+		const uint32_t slotIndex = std::min(uint32_t(scaled), uint32_t(m_Slots.size() - 1));
+		const Slot& slot = m_Slots[slotIndex];
+
+		const uint32_t index = scaled - slotIndex < slot.threshold ? slotIndex : slot.alias;
+		probability = m_Probabilities[index];
+		return index;
+	}
+
+	uint32_t AliasTable::Sample(float u, float v, float& probability) const
+	{
+		const uint32_t slotIndex = std::min(uint32_t(u * m_Slots.size()), uint32_t(m_Slots.size() - 1));
+		const Slot& slot = m_Slots[slotIndex];
+
+		const uint32_t index = v < slot.threshold ? slotIndex : slot.alias;
+		probability = m_Probabilities[index];
+		return index;
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace dae
+{
+	/**
+	 * \brief Picks an index with a probability proportional to its weight in constant time (Walker's alias
+	 * method, built with Vose's algorithm). Every slot holds its own index and an alias: a uniform number picks
+	 * the slot, its fraction decides between the two.
+	 */
+	class AliasTable final
+	{
+	public:
+		AliasTable() = default;
+		~AliasTable() = default;
+
+		AliasTable(const AliasTable&) = delete;
+		AliasTable(AliasTable&&) noexcept = delete;
+		AliasTable& operator=(const AliasTable&) = delete;
+		AliasTable& operator=(AliasTable&&) noexcept = delete;
+
+		//Negative weights count as 0, the table stays empty when all are
+		void Build(const std::vector<float>& weights);
+
+		bool IsEmpty() const { return m_Slots.empty(); }
+
+		/**
+		 * \param u uniform random number in [0, 1)
+		 * \param probability chance of the returned index being picked
+		 */
+		uint32_t Sample(float u, float& probability) const;
+		//Like Sample, with a second number choosing between slot and alias, for tables too large for the fraction of u to resolve it
+		uint32_t Sample(float u, float v, float& probability) const;
+		float GetProbability(uint32_t index) const { return m_Probabilities[index]; }
+
+	private:
+		struct Slot
+		{
+			float threshold{ 1.f }; //the slot's own index is picked below this fraction, the alias above
+			uint32_t alias{};
+		};
+
+		std::vector<Slot> m_Slots{};
+		std::vector<float> m_Probabilities{};
+	};
+}
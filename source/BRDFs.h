@@ -1,5 +1,8 @@
 #pragma once
+#include <bit>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
 #include "Math.h"
 
 namespace dae
@@ -11,14 +14,14 @@ namespace dae
 		 * \param cd Diffuse Color
 		 * \return Lambert Diffuse Color
 		 */
-		static ColorRGB Lambert(float kd, const ColorRGB& cd)
+		inline ColorRGB Lambert(float kd, const ColorRGB& cd)
 		{
-			return kd * cd / M_PI;
+			return kd * cd / PI;
 		}
 
-		static ColorRGB Lambert(const ColorRGB& kd, const ColorRGB& cd)
+		inline ColorRGB Lambert(const ColorRGB& kd, const ColorRGB& cd)
 		{
-			return kd * cd / M_PI;
+			return kd * cd / PI;
 		}
 
 		/**
@@ -30,7 +33,7 @@ namespace dae
 		 * \param n Normal of the Surface
 		 * \return Phong Specular Color
 		 */
-		static ColorRGB Phong(float ks, float exp, const Vector3& l, const Vector3& v, const Vector3& n)
+		inline ColorRGB Phong(float ks, float exp, const Vector3& l, const Vector3& v, const Vector3& n)
 		{
 			const auto reflect = l - (2 * Vector3::Dot(n, l)) * n;
 			const float cosAlpha = Vector3::Dot(reflect, v);
@@ -46,7 +49,7 @@ namespace dae
 		 * \param f0 Base reflectivity of a surface based on IOR (Indices Of Refrection), this is different for Dielectrics (Non-Metal) and Conductors (Metal)
 		 * \return
 		 */
-		static ColorRGB FresnelFunction_Schlick(const Vector3& h, const Vector3& v, const ColorRGB& f0)
+		inline ColorRGB FresnelFunction_Schlick(const Vector3& h, const Vector3& v, const ColorRGB& f0)
 		{
 			return { f0 + (ColorRGB { 1,1,1 } - f0) * powf((1 - Vector3::Dot(h, v)), 5) };
 		}
@@ -58,12 +61,12 @@ namespace dae
 		 * \param roughness Roughness of the material
 		 * \return BRDF Normal Distribution Term using Trowbridge-Reitz GGX
 		 */
-		static float NormalDistribution_GGX(const Vector3& n, const Vector3& h, float roughness)
+		inline float NormalDistribution_GGX(const Vector3& n, const Vector3& h, float roughness)
 		{
 			float alphaSquared = roughness * roughness * roughness * roughness;
 			float dotSquared = Vector3::Dot(n, h) * Vector3::Dot(n, h);
 
-			return { alphaSquared / (float(M_PI) * powf(dotSquared * (alphaSquared - 1) + 1, 2)) };
+			return { alphaSquared / (PI * powf(dotSquared * (alphaSquared - 1) + 1, 2)) };
 		}
 
 
@@ -74,7 +77,7 @@ namespace dae
 		 * \param roughness Roughness of the material
 		 * \return BRDF Geometry Term using SchlickGGX
 		 */
-		static float GeometryFunction_SchlickGGX(const Vector3& n, const Vector3& v, float roughness)
+		inline float GeometryFunction_SchlickGGX(const Vector3& n, const Vector3& v, float roughness)
 		{
 			float dot = Vector3::Dot(n, v);
 			float k = powf(roughness + 1, 2) / 8;
@@ -90,11 +93,163 @@ namespace dae
 		 * \param roughness Roughness of the material
 		 * \return BRDF Geometry Term using Smith (> SchlickGGX(n,v,roughness) * SchlickGGX(n,l,roughness))
 		 */
-		static float GeometryFunction_Smith(const Vector3& n, const Vector3& v, const Vector3& l, float roughness)
+		inline float GeometryFunction_Smith(const Vector3& n, const Vector3& v, const Vector3& l, float roughness)
 		{
 			float k = powf(roughness + 1, 2) / 8;
 
 			return { GeometryFunction_SchlickGGX(n, v, k) * GeometryFunction_SchlickGGX(n, l, k) };
 		}
+
+		//How materials evaluate their BRDF
+		enum class Precision
+		{
+			Exact = 0, //The functions above
+			Fast = 1, //Fast:: below, with terms that only depend on the material precomputed by it
+			Max = 2
+		};
+
+		/**
+		 * \brief The functions above with powf replaced, and the terms that only depend on the material taken as
+		 * parameters, within the error bounds below
+		 */
+		namespace Fast
+		{
+			//Relative error of the functions below, a few roundings apart from the exact ones
+			constexpr float RELATIVE_ERROR{ 1e-5f };
+			//Relative error of Pow and with it Phong, the exponent scales the error of the logarithm
+			constexpr float POW_RELATIVE_ERROR{ 1e-4f };
+			//Results below this are compared absolutely
+			constexpr float ABSOLUTE_ERROR{ 1e-30f };
+
+			/**
+			 * \brief powf as exp2(exponent * log2(x)) with polynomials. It selects instead of branching, so loops over it
+			 * vectorize. Results below 2^-125 flush to 0, and so do denormal x
+			 * \param x Base, negative only with an integral exponent like powf
+			 * \param exponent Exponent in [0, 2^16)
+			 */
+			inline float Pow(float x, float exponent)
+			{
+				// |x| = m * 2^e with m in [sqrt(0.5), sqrt(2))
+				const uint32_t bits = std::bit_cast<uint32_t>(x) & 0x7FFFFFFF;
+				const bool isAboveSqrt2 = (bits & 0x007FFFFF) > 0x003504F3;
+				const float m = std::bit_cast<float>((bits & 0x007FFFFF) | (isAboveSqrt2 ? 0x3F000000u : 0x3F800000u));
+				const int e = int(bits >> 23) - (isAboveSqrt2 ? 126 : 127);
+
+				// ln(m) = 2 atanh(t) with |t| <= 0.172, the series is done after t^7
+				const float t = (m - 1.f) / (m + 1.f);
+				const float t2 = t * t;
+				const float lnM = 2.f * t * (1.f + t2 * (1.f / 3.f + t2 * (1.f / 5.f + t2 * (1.f / 7.f))));
+				const float y = exponent * (float(e) + lnM * 1.44269504f);
+
+				// 2^y = 2^n * e^z with z = (y - n) ln(2) in [-0.347, 0.347], the series is done after z^5
+				const int n = int(y + 16384.5f) - 16384;
+				const float z = (y - float(n)) * 0.693147181f;
+				const float expZ = 1.f + z * (1.f + z * (1.f / 2.f + z * (1.f / 6.f + z * (1.f / 24.f + z * (1.f / 120.f)))));
+				const uint32_t scaleBits = (n < -125) ? 0u : (n > 127) ? 0x7F800000u : uint32_t(n + 127) << 23;
+				uint32_t resultBits = std::bit_cast<uint32_t>(expZ * std::bit_cast<float>(scaleBits));
+
+				resultBits = (bits < 0x00800000) ? 0u : resultBits;
+				resultBits = (exponent == 0.f) ? 0x3F800000u : resultBits;
+
+				// negative bases keep their sign for odd exponents and have no real power for fractional ones
+				const int integral = int(exponent);
+				const uint32_t sign = std::bit_cast<uint32_t>(x) & 0x80000000u;
+				resultBits |= (integral & 1) ? sign : 0u;
+				resultBits = ((sign != 0) & (float(integral) != exponent)) ? 0x7FC00000u : resultBits;
+				return std::bit_cast<float>(resultBits);
+			}
+
+			inline ColorRGB Phong(float ks, float exp, const Vector3& l, const Vector3& v, const Vector3& n)
+			{
+				const auto reflect = l - (2 * Vector3::Dot(n, l)) * n;
+				const float reflection = ks * Pow(Vector3::Dot(reflect, v), exp);
+				return ColorRGB(reflection, reflection, reflection);
+			}
+
+			inline ColorRGB FresnelFunction_Schlick(const Vector3& h, const Vector3& v, const ColorRGB& f0)
+			{
+				const float x = 1 - Vector3::Dot(h, v);
+				const float x2 = x * x;
+				return f0 + (x2 * x2 * x) * (ColorRGB{ 1,1,1 } - f0);
+			}
+
+			//alphaSquared is roughness^4
+			inline float NormalDistribution_GGX(const Vector3& n, const Vector3& h, float alphaSquared)
+			{
+				const float dot = Vector3::Dot(n, h);
+				const float denominator = dot * dot * (alphaSquared - 1) + 1;
+
+				return alphaSquared / (PI * denominator * denominator);
+			}
+
+			//k as GeometryFunction_Smith ends up using it, see GetGeometryK
+			inline float GeometryFunction_Smith(const Vector3& n, const Vector3& v, const Vector3& l, float k)
+			{
+				const float dotV = Vector3::Dot(n, v);
+				const float dotL = Vector3::Dot(n, l);
+
+				return dotV / (dotV * (1 - k) + k) * (dotL / (dotL * (1 - k) + k));
+			}
+
+			//GeometryFunction_Smith remaps roughness to k and SchlickGGX remaps that k once more
+			inline float GetGeometryK(float roughness)
+			{
+				const float k = (roughness + 1) * (roughness + 1) / 8;
+				return (k + 1) * (k + 1) / 8;
+			}
+
+			/**
+			 * \brief Sweeps every approximation against the exact function it replaces
+			 * \return true when all of them stay within their error bound, the BRDFTests ctest checks it
+			 */
+			inline bool AreWithinErrorBounds()
+			{
+				const auto isWithin = [](float approximation, float exact, float relativeError)
+				{
+					if (std::isnan(exact))
+						return std::isnan(approximation);
+
+					return fabsf(approximation - exact) <= relativeError * fabsf(exact) + ABSOLUTE_ERROR;
+				};
+
+				// cosines of both signs, as Phong raises them
+				for (int i{ -1000 }; i <= 1000; ++i)
+				{
+					const float x = i / 1000.f;
+					for (const float exponent : { 0.f, 1.f, 2.f, 5.f, 20.f, 60.f, 128.f, 0.5f, 7.3f, 64.5f })
+					{
+						if (!isWithin(Pow(x, exponent), float(pow(double(x), double(exponent))), POW_RELATIVE_ERROR))
+							return false;
+					}
+				}
+
+				const Vector3 n{ 0.f, 1.f, 0.f };
+				const ColorRGB f0{ 0.04f, 0.5f, 0.972f };
+
+				for (int i{}; i <= 1000; ++i)
+				{
+					// cosines from grazing to head on, as the direction's angle to the normal
+					const float angle = 0.5f * PI * i / 1000.f;
+					const Vector3 direction{ sinf(angle), cosf(angle), 0.f };
+					const Vector3 other{ -sinf(0.5f * angle), cosf(0.5f * angle), 0.f };
+
+					const ColorRGB fresnel = Fast::FresnelFunction_Schlick(direction, n, f0);
+					const ColorRGB exactFresnel = BRDF::FresnelFunction_Schlick(direction, n, f0);
+					if (!isWithin(fresnel.r, exactFresnel.r, RELATIVE_ERROR) || !isWithin(fresnel.g, exactFresnel.g, RELATIVE_ERROR) || !isWithin(fresnel.b, exactFresnel.b, RELATIVE_ERROR))
+						return false;
+
+					for (const float roughness : { 0.05f, 0.1f, 0.3f, 0.6f, 1.f })
+					{
+						if (!isWithin(Fast::NormalDistribution_GGX(n, direction, roughness * roughness * roughness * roughness), BRDF::NormalDistribution_GGX(n, direction, roughness), RELATIVE_ERROR))
+							return false;
+
+						if (!isWithin(Fast::GeometryFunction_Smith(n, direction, other, GetGeometryK(roughness)), BRDF::GeometryFunction_Smith(n, direction, other, roughness), RELATIVE_ERROR))
+							return false;
+					}
+				}
+
+				return true;
+			}
+		}
 	}
 }
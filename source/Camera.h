@@ -1,14 +1,68 @@
 #pragma once
 #include <cassert>
+#ifndef RAYTRACER_HEADLESS
 #include <SDL_keyboard.h>
 #include <SDL_mouse.h>
+#endif
 
 #include "Math.h"
+#include "DataTypes.h"
 #include "Timer.h"
 #include <iostream>
 
 namespace dae
 {
+	//Snapshot of the camera for a single frame, used to generate primary rays
+	struct CameraFrame
+	{
+		Matrix cameraToWorld{};
+		Matrix worldToCamera{};
+		Vector3 origin{};
+		float aspectRatio{ 1.f };
+		float fov{ 1.f };
+		int width{};
+		int height{};
+
+		/**
+		 * \brief Generates a normalized primary ray through a point on the image plane
+		 * \param x horizontal position in pixels (pixel centers lie at px + 0.5)
+		 * \param y vertical position in pixels (pixel centers lie at py + 0.5)
+		 * \return view ray
+		 */
+		Ray GetViewRay(float x, float y) const
+		{
+			const float xcs = ((2 * x / width) - 1) * aspectRatio * fov;
+			const float ycs = (1 - (2 * y / height)) * fov;
+
+			const Vector3 rayDirection = cameraToWorld.TransformVector(xcs, ycs, 1.f);
+			return Ray{ origin, rayDirection.Normalized() };
+		}
+
+		/**
+		 * \brief Projects a world space point onto the image plane, inverse of GetViewRay
+		 * \param point world space position
+		 * \param x horizontal position in pixels
+		 * \param y vertical position in pixels
+		 * \param depth distance along the camera's forward axis
+		 * \return false if the point lies behind the camera
+		 */
+		bool Project(const Vector3& point, float& x, float& y, float& depth) const
+		{
+			const Vector3 cameraPoint = worldToCamera.TransformPoint(point);
+			if (cameraPoint.z <= FLT_EPSILON)
+				return false;
+
+			const float xcs = cameraPoint.x / cameraPoint.z;
+			const float ycs = cameraPoint.y / cameraPoint.z;
+
+			x = (xcs / (aspectRatio * fov) + 1) * 0.5f * width;
+			y = (1 - ycs / fov) * 0.5f * height;
+			depth = cameraPoint.z;
+
+			return true;
+		}
+	};
+
 	struct Camera
 	{
 		Camera() = default;
@@ -44,10 +98,22 @@ namespace dae
 			return cameraToWorld;
 		}
 
+		CameraFrame GetFrame(int width, int height) const
+		{
+			return CameraFrame{ cameraToWorld, Matrix::Inverse(cameraToWorld), origin, width / float(height), tanf(fovAngle / 2), width, height };
+		}
+
 		void Update(Timer* pTimer)
 		{
-			const float deltaTime = pTimer->GetElapsed();
+#ifndef RAYTRACER_HEADLESS
+			HandleInput(pTimer->GetElapsed());
+#endif
+			CalculateCameraToWorld();
+		}
 
+#ifndef RAYTRACER_HEADLESS
+		void HandleInput(float deltaTime)
+		{
 			// Get current keyboard state
 			const uint8_t* pKeyboardState = SDL_GetKeyboardState(nullptr);
 
@@ -81,8 +147,7 @@ namespace dae
 
 				forward = Matrix::CreateRotation(totalPitch, totalYaw, 0.0f).TransformVector(Vector3::UnitZ);
 			}
-
-			CalculateCameraToWorld();
 		}
+#endif
 	};
 }
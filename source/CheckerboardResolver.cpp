@@ -0,0 +1,117 @@
+#include "CheckerboardResolver.h"
+
+#include <algorithm>
+
+#include "Camera.h"
+
+namespace dae
+{
+	void CheckerboardResolver::BeginFrame(int width, int height)
+	{
+		if (m_GBuffer.GetWidth() != width || m_GBuffer.GetHeight() != height)
+		{
+			m_GBuffer.Resize(width, height);
+			m_HasHistory = false;
+		}
+	}
+
+	void CheckerboardResolver::EndFrame()
+	{
+		m_FrameParity ^= 1;
+		m_HasHistory = true;
+	}
+
+	ColorRGB CheckerboardResolver::Reconstruct(int px, int py, const CameraFrame& cameraFrame) const
+	{
+		// left, right, up, down: all of them were traced this frame
+		const GBufferTexel* neighbors[4]{
+			px > 0 ? &m_GBuffer.At(px - 1, py) : nullptr,
+			px < m_GBuffer.GetWidth() - 1 ? &m_GBuffer.At(px + 1, py) : nullptr,
+			py > 0 ? &m_GBuffer.At(px, py - 1) : nullptr,
+			py < m_GBuffer.GetHeight() - 1 ? &m_GBuffer.At(px, py + 1) : nullptr
+		};
+
+		const GBufferTexel& history = m_GBuffer.At(px, py);
+
+		float x{}, y{}, historyDepth{};
+		const bool hasReference = m_HasHistory && history.didHit
+			&& cameraFrame.Project(history.position, x, y, historyDepth)
+			&& fabsf(x - (px + 0.5f)) < m_Settings.maxReprojectionOffset
+			&& fabsf(y - (py + 0.5f)) < m_Settings.maxReprojectionOffset;
+
+		if (!hasReference)
+			return InterpolateDirectional(neighbors);
+
+		// temporal: last frame's hit still lands on this pixel and belongs to the same surface as a neighbor
+		ColorRGB weightedColor{};
+		float totalWeight{};
+		bool matchesNeighbor{ false };
+
+		for (const GBufferTexel* pNeighbor : neighbors)
+		{
+			if (!pNeighbor || !pNeighbor->didHit || pNeighbor->materialIndex != history.materialIndex)
+				continue;
+
+			matchesNeighbor |= IsSameSurface(*pNeighbor, history, historyDepth);
+
+			// spatial weights, used when the history turns out to be unusable
+			const float depthWeight = expf(-fabsf(pNeighbor->depth - historyDepth) / (m_Settings.depthTolerance * historyDepth));
+			const float normalWeight = powf(std::max(Vector3::Dot(pNeighbor->normal, history.normal), 0.f), m_Settings.normalPower);
+			const float weight = depthWeight * normalWeight;
+
+			weightedColor += pNeighbor->color * weight;
+			totalWeight += weight;
+		}
+
+		if (matchesNeighbor)
+			return history.color;
+
+		if (totalWeight > FLT_EPSILON)
+			return weightedColor / totalWeight;
+
+		return InterpolateDirectional(neighbors);
+	}
+
+	bool CheckerboardResolver::IsSameSurface(const GBufferTexel& texel, const GBufferTexel& reference, float referenceDepth) const
+	{
+		return texel.materialIndex == reference.materialIndex
+			&& fabsf(texel.depth - referenceDepth) < m_Settings.depthTolerance * referenceDepth
+			&& Vector3::Dot(texel.normal, reference.normal) > m_Settings.minNormalCosine;
+	}
+
+	ColorRGB CheckerboardResolver::InterpolateDirectional(const GBufferTexel* neighbors[4]) const
+	{
+		// interpolate along the axis whose two neighbors agree best, so the average never straddles an edge
+		float axisError[2]{ FLT_MAX, FLT_MAX };
+		for (int axis{}; axis < 2; ++axis)
+		{
+			const GBufferTexel* pFirst = neighbors[axis * 2];
+			const GBufferTexel* pSecond = neighbors[axis * 2 + 1];
+			if (!pFirst || !pSecond)
+				continue;
+
+			axisError[axis] = fabsf(pFirst->depth - pSecond->depth) / std::min(pFirst->depth, pSecond->depth)
+				+ (pFirst->materialIndex != pSecond->materialIndex || pFirst->didHit != pSecond->didHit ? 1.f : 0.f);
+		}
+
+		if (axisError[0] < FLT_MAX || axisError[1] < FLT_MAX)
+		{
+			const int axis = axisError[0] <= axisError[1] ? 0 : 1;
+			return ColorRGB::Lerp(neighbors[axis * 2]->color, neighbors[axis * 2 + 1]->color, 0.5f);
+		}
+
+		// image border: average whatever neighbors exist
+		ColorRGB color{};
+		int count{};
+		for (int i{}; i < 4; ++i)
+		{
+			if (!neighbors[i])
+				continue;
+
+			color += neighbors[i]->color;
+			++count;
+		}
+
+		return count > 0 ? color / float(count) : color;
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+
+#include "GBuffer.h"
+
+namespace dae
+{
+	struct CameraFrame;
+
+	/**
+	 * \brief Checkerboard rendering: only half the pixels are traced each frame, alternating the pattern.
+	 * A missing pixel was traced the frame before, so its old texel is reused when it still reprojects onto
+	 * the pixel and agrees with its freshly traced neighbors. Otherwise it is interpolated from those neighbors,
+	 * weighted by depth, normal and material similarity so edges are not blurred.
+	 */
+	class CheckerboardResolver final
+	{
+	public:
+		struct Settings
+		{
+			float maxReprojectionOffset{ 0.75f }; //pixels the history hit may have moved and still be reused
+			float depthTolerance{ 0.05f }; //relative depth difference still considered the same surface
+			float minNormalCosine{ 0.9f }; //normals closer than this are considered the same surface
+			float normalPower{ 8.f }; //sharpness of the normal weight during spatial reconstruction
+		};
+
+		CheckerboardResolver() = default;
+		~CheckerboardResolver() = default;
+
+		CheckerboardResolver(const CheckerboardResolver&) = delete;
+		CheckerboardResolver(CheckerboardResolver&&) noexcept = delete;
+		CheckerboardResolver& operator=(const CheckerboardResolver&) = delete;
+		CheckerboardResolver& operator=(CheckerboardResolver&&) noexcept = delete;
+
+		void BeginFrame(int width, int height);
+		void EndFrame();
+		void Invalidate() { m_HasHistory = false; }
+
+		bool IsTracedThisFrame(int px, int py) const { return ((px + py + m_FrameParity) & 1) == 0; }
+
+		//Traced pixels are written here, missing pixels still hold the texel traced last frame
+		GBufferTexel& At(int px, int py) { return m_GBuffer.At(px, py); }
+
+		//Fills in a pixel that was not traced this frame, all traced pixels must be stored first
+		ColorRGB Reconstruct(int px, int py, const CameraFrame& cameraFrame) const;
+
+		Settings& GetSettings() { return m_Settings; }
+
+	private:
+		Settings m_Settings{};
+
+		GBuffer m_GBuffer{};
+		uint32_t m_FrameParity{};
+		bool m_HasHistory{ false };
+
+		bool IsSameSurface(const GBufferTexel& texel, const GBufferTexel& reference, float referenceDepth) const;
+		ColorRGB InterpolateDirectional(const GBufferTexel* neighbors[4]) const;
+	};
+}
@@ -1,5 +1,7 @@
 #pragma once
 #include <cassert>
+#include <cfloat>
+#include <cstdint>
 
 #include "Math.h"
 #include "vector"
@@ -12,7 +14,7 @@ namespace dae
 		Vector3 origin{};
 		float radius{};
 
-		unsigned char materialIndex{ 0 };
+		uint32_t materialIndex{ 0 };
 	};
 
 	struct Plane
@@ -20,7 +22,7 @@ namespace dae
 		Vector3 origin{};
 		Vector3 normal{};
 
-		unsigned char materialIndex{ 0 };
+		uint32_t materialIndex{ 0 };
 	};
 
 	enum class TriangleCullMode
@@ -51,7 +53,7 @@ namespace dae
 		Vector3 normal{};
 
 		TriangleCullMode cullMode{};
-		unsigned char materialIndex{};
+		uint32_t materialIndex{};
 	};
 
 	struct TriangleMesh
@@ -76,7 +78,8 @@ namespace dae
 		std::vector<Vector3> positions{};
 		std::vector<Vector3> normals{};
 		std::vector<int> indices{};
-		unsigned char materialIndex{};
+		uint32_t materialIndex{};
+		std::vector<uint32_t> materialIndices{}; //per triangle, e.g. OBJ usemtl groups, empty gives every triangle materialIndex
 
 		TriangleCullMode cullMode{TriangleCullMode::BackFaceCulling};
 
@@ -116,11 +119,19 @@ namespace dae
 
 			normals.push_back(triangle.normal);
 
+			if (!materialIndices.empty())
+				materialIndices.push_back(triangle.materialIndex);
+
 			//Not ideal, but making sure all vertices are updated
 			if(!ignoreTransformUpdate)
 				UpdateTransforms();
 		}
 
+		uint32_t GetMaterialIndex(size_t triangleIndex) const
+		{
+			return materialIndices.empty() ? materialIndex : materialIndices[triangleIndex];
+		}
+
 		void CalculateNormals()
 		{
 			normals.clear();
@@ -153,7 +164,7 @@ namespace dae
 			//Transform Normals (normals > transformedNormals)
 			for (size_t i = 0; i < normals.size(); i++)
 			{
-				transformedNormals.emplace_back(finalTransform.TransformPoint(normals[i].Normalized()));
+				transformedNormals.emplace_back(finalTransform.TransformVector(normals[i].Normalized()));
 			}
 		}
 	};
@@ -162,15 +173,24 @@ namespace dae
 	enum class LightType
 	{
 		Point,
-		Directional
+		Directional,
+		Rect, //Emits from the side direction points to, spanned by origin +- halfExtentU +- halfExtentV
+		Disk, //Emits from the side direction points to
+		Sphere
 	};
 
+	//Area lights emit intensity times color as radiance from every point of their surface
 	struct Light
 	{
 		Vector3 origin{};
 		Vector3 direction{};
 		ColorRGB color{};
 		float intensity{};
+		float influenceRadius{}; //point lights give no radiance beyond it, 0 never cuts off
+
+		Vector3 halfExtentU{}; //rectangle lights
+		Vector3 halfExtentV{};
+		float radius{}; //disk and sphere lights
 
 		LightType type{};
 	};
@@ -185,14 +205,34 @@ namespace dae
 		float max{ FLT_MAX };
 	};
 
+	//Rays that share their origin, such as the shadow rays of one shading point, traced together by Scene::GetOcclusionMask.
+	//Directions are stored per component like the wavefront queues, only the first count entries are used
+	struct RayPacket
+	{
+		static constexpr uint32_t maxSize{ 16 };
+
+		Vector3 origin{};
+		float directionX[maxSize];
+		float directionY[maxSize];
+		float directionZ[maxSize];
+		float max[maxSize];
+		uint32_t lightIndex[maxSize]; //Light a shadow ray goes to, picks its OccluderCache entry
+
+		float min{ 0.0001f };
+		uint32_t count{};
+	};
+
 	struct HitRecord
 	{
 		Vector3 origin{};
 		Vector3 normal{};
 		float t = FLT_MAX;
 
-		bool didHit{ false };
-		unsigned char materialIndex{ 0 };
+		//Share one word, so a 32 bit material index keeps the record at 32 bytes
+		uint32_t didHit : 1 { false };
+		uint32_t materialIndex : 31 { 0 };
 	};
+
+	static_assert(sizeof(HitRecord) == 32, "HitRecord is copied per sample and per tile texel, keep it at 32 bytes");
 #pragma endregion
 }
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+namespace dae
+{
+	/**
+	 * \brief Picks the internal render resolution for the next frame from a frame time budget.
+	 * Keeps a smoothed cost per traced pixel and a smoothed fixed cost of the frame, the upscale to the full resolution,
+	 * and sizes the next frame so both together are expected to land on the target.
+	 */
+	class DynamicResolution final
+	{
+	public:
+		struct Settings
+		{
+			float targetFrameTime{ 1.f / 30.f }; //seconds
+			float minScale{ 0.25f };
+			float maxScale{ 1.f };
+			float costSmoothing{ 0.25f }; //weight of the newest measurement in the cost average
+			float maxScaleStep{ 0.1f }; //largest change of the scale between two frames
+		};
+
+		float GetScale() const { return m_Scale; }
+		Settings& GetSettings() { return m_Settings; }
+
+		/**
+		 * \param renderTime time spent tracing the last frame, in seconds
+		 * \param upscaleTime time spent upscaling it to the full resolution, in seconds. It does not shrink with the scale
+		 * \param renderedPixelCount pixels traced for that frame
+		 * \param fullPixelCount pixels at a scale of 1
+		 */
+		void Update(float renderTime, float upscaleTime, int renderedPixelCount, int fullPixelCount)
+		{
+			if (renderedPixelCount <= 0 || fullPixelCount <= 0)
+				return;
+
+			const float costPerPixel = renderTime / renderedPixelCount;
+			const bool hasHistory = m_CostPerPixel > 0.f;
+			m_CostPerPixel = hasHistory ? m_CostPerPixel + (costPerPixel - m_CostPerPixel) * m_Settings.costSmoothing : costPerPixel;
+			m_UpscaleTime = hasHistory ? m_UpscaleTime + (upscaleTime - m_UpscaleTime) * m_Settings.costSmoothing : upscaleTime;
+
+			// scale applies to both axes, so the pixel budget maps to its square root
+			const float budgetPixels = std::max(m_Settings.targetFrameTime - m_UpscaleTime, 0.f) / m_CostPerPixel;
+			const float desiredScale = sqrtf(budgetPixels / fullPixelCount);
+
+			m_Scale = std::clamp(desiredScale, m_Scale - m_Settings.maxScaleStep, m_Scale + m_Settings.maxScaleStep);
+			m_Scale = std::clamp(m_Scale, m_Settings.minScale, m_Settings.maxScale);
+		}
+
+	private:
+		Settings m_Settings{};
+
+		float m_Scale{ 1.f };
+		float m_CostPerPixel{};
+		float m_UpscaleTime{};
+	};
+}
@@ -0,0 +1,161 @@
+#include "EnvironmentMap.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+
+namespace dae
+{
+	bool EnvironmentMap::LoadPFM(const std::string& filename)
+	{
+		std::ifstream file(filename, std::ios::binary);
+		if (!file)
+			return false;
+
+		std::string magic;
+		int width{}, height{};
+		float scale{};
+		file >> magic >> width >> height >> scale;
+
+		// only color maps, the single whitespace after the scale ends the header
+		if (!file || magic != "PF" || width <= 0 || height <= 0)
+			return false;
+		file.get();
+
+		static_assert(sizeof(ColorRGB) == 3 * sizeof(float), "ColorRGB rows are read as raw float triplets");
+
+		std::vector<ColorRGB> texels(size_t(width) * height);
+		for (int row{ height - 1 }; row >= 0; --row)
+		{
+			file.read(reinterpret_cast<char*>(&texels[size_t(row) * width]), sizeof(ColorRGB) * width);
+		}
+
+		if (!file)
+			return false;
+
+		// a positive scale marks big-endian data
+		if (scale > 0.f && std::endian::native == std::endian::little)
+		{
+			for (ColorRGB& texel : texels)
+			{
+				for (float* pChannel : { &texel.r, &texel.g, &texel.b })
+				{
+					const uint32_t bits = std::bit_cast<uint32_t>(*pChannel);
+					*pChannel = std::bit_cast<float>((bits >> 24) | ((bits >> 8) & 0xFF00u) | ((bits << 8) & 0xFF0000u) | (bits << 24));
+				}
+			}
+		}
+
+		SetImage(width, height, std::move(texels));
+		return true;
+	}
+
+	void EnvironmentMap::CreateSky(int width, int height, const Vector3& sunDirection, float sunAngularRadius, const ColorRGB& sunRadiance,
+		const ColorRGB& zenithRadiance, const ColorRGB& horizonRadiance, const ColorRGB& groundRadiance)
+	{
+		const Vector3 toSun = sunDirection.Normalized();
+		const float cosSunRadius = cosf(sunAngularRadius);
+
+		std::vector<ColorRGB> texels(size_t(width) * height);
+		for (int y{}; y < height; ++y)
+		{
+			for (int x{}; x < width; ++x)
+			{
+				const Vector3 direction = GetDirection(PI_2 * (x + 0.5f) / width - PI, PI * (y + 0.5f) / height);
+
+				ColorRGB& texel = texels[size_t(y) * width + x];
+				if (direction.y < 0.f)
+				{
+					texel = groundRadiance;
+					continue;
+				}
+
+				// most of the change happens close to the horizon
+				const float blend = sqrtf(direction.y);
+				texel = (1.f - blend) * horizonRadiance + blend * zenithRadiance;
+
+				if (Vector3::Dot(direction, toSun) >= cosSunRadius)
+				{
+					texel += sunRadiance;
+				}
+			}
+		}
+
+		SetImage(width, height, std::move(texels));
+	}
+
+	void EnvironmentMap::SetImage(int width, int height, std::vector<ColorRGB> texels)
+	{
+		m_Width = width;
+		m_Height = height;
+		m_Texels = std::move(texels);
+
+		BuildAliasTable();
+	}
+
+	void EnvironmentMap::Clear()
+	{
+		m_Width = 0;
+		m_Height = 0;
+		m_Texels.clear();
+		m_AliasTable.Build({});
+	}
+
+	ColorRGB EnvironmentMap::GetRadiance(const Vector3& direction) const
+	{
+		if (m_Texels.empty())
+			return {};
+
+		const Vector3 unitDirection = direction.Normalized();
+		const float phi = atan2f(unitDirection.z, unitDirection.x);
+		const float theta = acosf(std::clamp(unitDirection.y, -1.f, 1.f));
+
+		const int x = std::clamp(static_cast<int>((phi + PI) / PI_2 * m_Width), 0, m_Width - 1);
+		const int y = std::clamp(static_cast<int>(theta / PI * m_Height), 0, m_Height - 1);
+		return m_Texels[size_t(y) * m_Width + x];
+	}
+
+	bool EnvironmentMap::Sample(float u, float v, float s, float t, Vector3& direction, float& pdf) const
+	{
+		if (m_AliasTable.IsEmpty())
+			return false;
+
+		float probability{};
+		const uint32_t texelIndex = m_AliasTable.Sample(u, v, probability);
+		const int x = static_cast<int>(texelIndex % m_Width);
+		const int y = static_cast<int>(texelIndex / m_Width);
+
+		const float theta = PI * (y + t) / m_Height;
+		direction = GetDirection(PI_2 * (x + s) / m_Width - PI, theta);
+
+		// uniform within the texel's rectangle of angles, which covers sin(theta) of solid angle per unit of it
+		const float sinTheta = sinf(theta);
+		pdf = sinTheta > 0.f ? probability * m_Width * m_Height / (PI_2 * PI * sinTheta) : 0.f;
+		return true;
+	}
+
+	void EnvironmentMap::BuildAliasTable()
+	{
+		// brightest channel like the light hierarchy, times the solid angle of the texel's row
+		std::vector<float> weights(m_Texels.size());
+		for (int y{}; y < m_Height; ++y)
+		{
+			const float sinTheta = sinf(PI * (y + 0.5f) / m_Height);
+			for (int x{}; x < m_Width; ++x)
+			{
+				const ColorRGB& texel = m_Texels[size_t(y) * m_Width + x];
+				weights[size_t(y) * m_Width + x] = std::max({ texel.r, texel.g, texel.b }) * sinTheta;
+			}
+		}
+
+		m_AliasTable.Build(weights);
+	}
+
+	Vector3 EnvironmentMap::GetDirection(float phi, float theta)
+	{
+		const float sinTheta = sinf(theta);
+		return { sinTheta * cosf(phi), cosf(theta), sinTheta * sinf(phi) };
+	}
+}
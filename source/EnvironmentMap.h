@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "Math.h"
+#include "AliasTable.h"
+
+namespace dae
+{
+	/**
+	 * \brief HDR radiance arriving from infinitely far away, stored as a latitude-longitude image with +y up. Shadow
+	 * rays towards it pick a texel from an alias table over texel radiance times the solid angle it covers, so a
+	 * sun a few texels wide gets the samples its brightness asks for instead of the few uniform directions give it.
+	 */
+	class EnvironmentMap final
+	{
+	public:
+		EnvironmentMap() = default;
+		~EnvironmentMap() = default;
+
+		EnvironmentMap(const EnvironmentMap&) = delete;
+		EnvironmentMap(EnvironmentMap&&) noexcept = delete;
+		EnvironmentMap& operator=(const EnvironmentMap&) = delete;
+		EnvironmentMap& operator=(EnvironmentMap&&) noexcept = delete;
+
+		//Reads a PFM as ImageWriter writes them, false when the file is missing or malformed, the map is left unchanged then
+		bool LoadPFM(const std::string& filename);
+
+		/**
+		 * \brief Replaces the map with a clear sky: a gradient from the horizon to the zenith, a uniform ground below
+		 * the horizon and a sun disk, for scenes that ship without an image
+		 * \param sunAngularRadius radians, the disk gets sunRadiance on top of the sky
+		 */
+		void CreateSky(int width, int height, const Vector3& sunDirection, float sunAngularRadius, const ColorRGB& sunRadiance,
+			const ColorRGB& zenithRadiance, const ColorRGB& horizonRadiance, const ColorRGB& groundRadiance);
+
+		void SetImage(int width, int height, std::vector<ColorRGB> texels);
+		void Clear();
+
+		bool IsEmpty() const { return m_Texels.empty(); }
+
+		//Black for an empty map, rays that miss everything then stay black
+		ColorRGB GetRadiance(const Vector3& direction) const;
+
+		/**
+		 * \brief Picks a direction with a probability proportional to the radiance coming from it
+		 * \param u, v pick the texel, s, t the position within it, all uniform in [0, 1)
+		 * \param pdf per unit solid angle, 0 when the direction cannot be used
+		 * \return false for an empty map
+		 */
+		bool Sample(float u, float v, float s, float t, Vector3& direction, float& pdf) const;
+
+	private:
+		int m_Width{};
+		int m_Height{};
+		std::vector<ColorRGB> m_Texels{}; //rows from the top, +y, down
+
+		AliasTable m_AliasTable{};
+
+		void BuildAliasTable();
+		static Vector3 GetDirection(float phi, float theta);
+	};
+}
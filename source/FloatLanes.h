@@ -0,0 +1,75 @@
+#pragma once
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__AVX__)
+#define RAYTRACER_LANES_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RAYTRACER_LANES_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace dae
+{
+	/**
+	 * \brief As many floats as one SIMD register of the build's instruction set holds: 8 with AVX, 4 with SSE2,
+	 * otherwise 1. Math written against it loops over its data width lanes at a time, so it is written once and
+	 * compiles to whichever register the build targets. Every operation rounds like its scalar counterpart.
+	 */
+	struct FloatLanes
+	{
+#if defined(RAYTRACER_LANES_AVX)
+		static constexpr uint32_t width{ 8 };
+		__m256 value;
+
+		static FloatLanes Load(const float* pSource) { return { _mm256_loadu_ps(pSource) }; }
+		void Store(float* pDestination) const { _mm256_storeu_ps(pDestination, value); }
+		static FloatLanes Broadcast(float scalar) { return { _mm256_set1_ps(scalar) }; }
+
+		friend FloatLanes operator+(FloatLanes a, FloatLanes b) { return { _mm256_add_ps(a.value, b.value) }; }
+		friend FloatLanes operator-(FloatLanes a, FloatLanes b) { return { _mm256_sub_ps(a.value, b.value) }; }
+		friend FloatLanes operator*(FloatLanes a, FloatLanes b) { return { _mm256_mul_ps(a.value, b.value) }; }
+		friend FloatLanes operator/(FloatLanes a, FloatLanes b) { return { _mm256_div_ps(a.value, b.value) }; }
+
+		static FloatLanes Sqrt(FloatLanes a) { return { _mm256_sqrt_ps(a.value) }; }
+		//All bits set in the lanes where a < b, for Select
+		static FloatLanes LessThan(FloatLanes a, FloatLanes b) { return { _mm256_cmp_ps(a.value, b.value, _CMP_LT_OQ) }; }
+		static FloatLanes Select(FloatLanes mask, FloatLanes ifSet, FloatLanes ifClear) { return { _mm256_blendv_ps(ifClear.value, ifSet.value, mask.value) }; }
+#elif defined(RAYTRACER_LANES_SSE2)
+		static constexpr uint32_t width{ 4 };
+		__m128 value;
+
+		static FloatLanes Load(const float* pSource) { return { _mm_loadu_ps(pSource) }; }
+		void Store(float* pDestination) const { _mm_storeu_ps(pDestination, value); }
+		static FloatLanes Broadcast(float scalar) { return { _mm_set1_ps(scalar) }; }
+
+		friend FloatLanes operator+(FloatLanes a, FloatLanes b) { return { _mm_add_ps(a.value, b.value) }; }
+		friend FloatLanes operator-(FloatLanes a, FloatLanes b) { return { _mm_sub_ps(a.value, b.value) }; }
+		friend FloatLanes operator*(FloatLanes a, FloatLanes b) { return { _mm_mul_ps(a.value, b.value) }; }
+		friend FloatLanes operator/(FloatLanes a, FloatLanes b) { return { _mm_div_ps(a.value, b.value) }; }
+
+		static FloatLanes Sqrt(FloatLanes a) { return { _mm_sqrt_ps(a.value) }; }
+		static FloatLanes LessThan(FloatLanes a, FloatLanes b) { return { _mm_cmplt_ps(a.value, b.value) }; }
+		// SSE2 has no blend, the mask picks bitwise
+		static FloatLanes Select(FloatLanes mask, FloatLanes ifSet, FloatLanes ifClear) { return { _mm_or_ps(_mm_and_ps(mask.value, ifSet.value), _mm_andnot_ps(mask.value, ifClear.value)) }; }
+#else
+		static constexpr uint32_t width{ 1 };
+		float value;
+
+		static FloatLanes Load(const float* pSource) { return { *pSource }; }
+		void Store(float* pDestination) const { *pDestination = value; }
+		static FloatLanes Broadcast(float scalar) { return { scalar }; }
+
+		friend FloatLanes operator+(FloatLanes a, FloatLanes b) { return { a.value + b.value }; }
+		friend FloatLanes operator-(FloatLanes a, FloatLanes b) { return { a.value - b.value }; }
+		friend FloatLanes operator*(FloatLanes a, FloatLanes b) { return { a.value * b.value }; }
+		friend FloatLanes operator/(FloatLanes a, FloatLanes b) { return { a.value / b.value }; }
+
+		static FloatLanes Sqrt(FloatLanes a) { return { sqrtf(a.value) }; }
+		static FloatLanes LessThan(FloatLanes a, FloatLanes b) { return { a.value < b.value ? std::bit_cast<float>(UINT32_MAX) : 0.f }; }
+		static FloatLanes Select(FloatLanes mask, FloatLanes ifSet, FloatLanes ifClear) { return { std::bit_cast<uint32_t>(mask.value) ? ifSet.value : ifClear.value }; }
+#endif
+	};
+}
@@ -0,0 +1,107 @@
+//Standard includes
+#include <utility>
+
+//Project includes
+#include "FrameEncoder.h"
+
+using namespace dae;
+
+FrameEncoder::FrameEncoder(size_t maxQueuedFrames) :
+	m_MaxQueuedFrames(maxQueuedFrames > 0 ? maxQueuedFrames : 1)
+{
+	//Start last, the thread reads every member above
+	m_Thread = std::thread{ &FrameEncoder::Run, this };
+}
+
+FrameEncoder::~FrameEncoder()
+{
+	{
+		std::lock_guard lock{ m_Mutex };
+		m_IsRunning = false;
+	}
+	m_Condition.notify_all();
+
+	m_Thread.join();
+}
+
+void FrameEncoder::Encode(const Framebuffer& framebuffer, const std::string& filename, ImageFormat format,
+	const FramebufferResolver::Settings& resolveSettings, const Callback& callback)
+{
+	Enqueue(framebuffer, filename, format, resolveSettings, callback, true);
+}
+
+bool FrameEncoder::TryEncode(const Framebuffer& framebuffer, const std::string& filename, ImageFormat format,
+	const FramebufferResolver::Settings& resolveSettings, const Callback& callback)
+{
+	return Enqueue(framebuffer, filename, format, resolveSettings, callback, false);
+}
+
+void FrameEncoder::Flush()
+{
+	std::unique_lock lock{ m_Mutex };
+	m_Condition.wait(lock, [this] { return m_QueuedCount == 0; });
+}
+
+bool FrameEncoder::Enqueue(const Framebuffer& framebuffer, const std::string& filename, ImageFormat format,
+	const FramebufferResolver::Settings& resolveSettings, const Callback& callback, bool waitForSlot)
+{
+	Job job{};
+	{
+		std::unique_lock lock{ m_Mutex };
+		if (waitForSlot)
+			m_Condition.wait(lock, [this] { return m_QueuedCount < m_MaxQueuedFrames; });
+		else if (m_QueuedCount >= m_MaxQueuedFrames)
+			return false;
+
+		++m_QueuedCount;
+		if (!m_FreeSnapshots.empty())
+		{
+			job.snapshot = std::move(m_FreeSnapshots.back());
+			m_FreeSnapshots.pop_back();
+		}
+	}
+
+	//The slot is reserved, copy outside the lock so the worker keeps going; a recycled snapshot is not reallocated
+	job.snapshot = framebuffer;
+	job.filename = filename;
+	job.format = format;
+	job.resolveSettings = resolveSettings;
+	job.callback = callback;
+
+	{
+		std::lock_guard lock{ m_Mutex };
+		m_Jobs.push_back(std::move(job));
+	}
+	m_Condition.notify_all();
+
+	return true;
+}
+
+void FrameEncoder::Run()
+{
+	while (true)
+	{
+		Job job{};
+		{
+			std::unique_lock lock{ m_Mutex };
+			m_Condition.wait(lock, [this] { return !m_Jobs.empty() || (!m_IsRunning && m_QueuedCount == 0); });
+
+			if (m_Jobs.empty())
+				return;
+
+			job = std::move(m_Jobs.front());
+			m_Jobs.pop_front();
+		}
+
+		const bool isWritten = ImageWriter::Write(job.filename, job.snapshot, job.format, job.resolveSettings);
+		if (job.callback)
+			job.callback(job.filename, isWritten);
+
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_FreeSnapshots.push_back(std::move(job.snapshot));
+			--m_QueuedCount;
+		}
+		m_Condition.notify_all();
+	}
+}
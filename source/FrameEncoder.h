@@ -0,0 +1,71 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Framebuffer.h"
+#include "FramebufferResolver.h"
+#include "ImageWriter.h"
+
+namespace dae
+{
+	/**
+	 * \brief Writes frames to disk on a worker thread. Queuing a frame only copies the float framebuffer into a
+	 * recycled snapshot, tone mapping, compression and file IO happen on the worker. At most maxQueuedFrames
+	 * snapshots exist at once, which bounds the memory a long capture can take.
+	 */
+	class FrameEncoder final
+	{
+	public:
+		//Called on the worker thread once the file is written, or failed to be
+		using Callback = std::function<void(const std::string& filename, bool isWritten)>;
+
+		explicit FrameEncoder(size_t maxQueuedFrames = 4);
+		~FrameEncoder(); //Writes every frame that is still queued
+
+		FrameEncoder(const FrameEncoder&) = delete;
+		FrameEncoder(FrameEncoder&&) noexcept = delete;
+		FrameEncoder& operator=(const FrameEncoder&) = delete;
+		FrameEncoder& operator=(FrameEncoder&&) noexcept = delete;
+
+		//Waits for a free snapshot when the queue is full, for offline renders that must not lose a frame
+		void Encode(const Framebuffer& framebuffer, const std::string& filename, ImageFormat format,
+			const FramebufferResolver::Settings& resolveSettings = {}, const Callback& callback = {});
+
+		//Skips the frame and returns false when the queue is full, for captures that must not stall the caller
+		bool TryEncode(const Framebuffer& framebuffer, const std::string& filename, ImageFormat format,
+			const FramebufferResolver::Settings& resolveSettings = {}, const Callback& callback = {});
+
+		//Waits until every queued frame is written
+		void Flush();
+
+	private:
+		struct Job
+		{
+			Framebuffer snapshot{};
+			std::string filename{};
+			ImageFormat format{};
+			FramebufferResolver::Settings resolveSettings{};
+			Callback callback{};
+		};
+
+		const size_t m_MaxQueuedFrames;
+
+		std::mutex m_Mutex{};
+		std::condition_variable m_Condition{};
+		std::deque<Job> m_Jobs{};
+		std::vector<Framebuffer> m_FreeSnapshots{};
+		size_t m_QueuedCount{}; //frames being copied, waiting or being written
+		bool m_IsRunning{ true };
+
+		std::thread m_Thread{};
+
+		bool Enqueue(const Framebuffer& framebuffer, const std::string& filename, ImageFormat format,
+			const FramebufferResolver::Settings& resolveSettings, const Callback& callback, bool waitForSlot);
+		void Run();
+	};
+}
@@ -0,0 +1,126 @@
+//Standard includes
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+//Project includes
+#include "FramePipeline.h"
+#include "FrameEncoder.h"
+#include "Presenter.h"
+
+using namespace dae;
+
+FramePipeline::FramePipeline(Presenter& presenter, FrameEncoder& encoder) :
+	m_Presenter(presenter),
+	m_Encoder(encoder),
+	m_ResolverSettings(presenter.GetResolver().GetSettings()),
+	m_PendingFrame(presenter.GetWidth(), presenter.GetHeight()),
+	m_ResolvedFrame(presenter.GetWidth(), presenter.GetHeight())
+{
+	//Start last, the thread reads every member above
+	m_Thread = std::thread{ &FramePipeline::Run, this };
+}
+
+FramePipeline::~FramePipeline()
+{
+	{
+		std::lock_guard lock{ m_Mutex };
+		m_IsRunning = false;
+	}
+	m_Condition.notify_all();
+
+	m_Thread.join();
+}
+
+void FramePipeline::Submit(Framebuffer& framebuffer, Capture capture)
+{
+	std::unique_lock lock{ m_Mutex };
+	m_Condition.wait(lock, [this] { return !m_HasPendingFrame; });
+
+	std::swap(m_PendingFrame, framebuffer);
+	m_PendingSettings = m_ResolverSettings;
+	m_PendingCapture = capture;
+	m_HasPendingFrame = true;
+
+	lock.unlock();
+	m_Condition.notify_all();
+}
+
+void FramePipeline::Present()
+{
+	{
+		std::lock_guard lock{ m_Mutex };
+		if (!m_HasReadyPixels)
+			return;
+
+		std::swap(m_PresentedPixels, m_ReadyPixels);
+		m_HasReadyPixels = false;
+	}
+
+	m_Presenter.Flip(m_PresentedPixels);
+}
+
+void FramePipeline::Run()
+{
+	while (true)
+	{
+		Capture capture{};
+		FramebufferResolver::Settings resolveSettings{};
+		{
+			std::unique_lock lock{ m_Mutex };
+			m_Condition.wait(lock, [this] { return m_HasPendingFrame || !m_IsRunning; });
+
+			//A frame submitted right before shutting down is still resolved and captured
+			if (!m_HasPendingFrame)
+				return;
+
+			std::swap(m_ResolvedFrame, m_PendingFrame);
+			resolveSettings = m_PendingSettings;
+			capture = m_PendingCapture;
+			m_HasPendingFrame = false;
+		}
+		m_Condition.notify_all();
+
+		m_Presenter.GetResolver().GetSettings() = resolveSettings;
+		m_Presenter.Resolve(m_ResolvedFrame, m_ResolvedPixels);
+		{
+			std::lock_guard lock{ m_Mutex };
+			std::swap(m_ReadyPixels, m_ResolvedPixels);
+			m_HasReadyPixels = true;
+		}
+
+		if (capture != Capture::None)
+			CaptureFrame(capture, resolveSettings);
+	}
+}
+
+void FramePipeline::CaptureFrame(Capture capture, const FramebufferResolver::Settings& resolveSettings)
+{
+	if (capture == Capture::Screenshot)
+	{
+		m_Encoder.Encode(m_ResolvedFrame, "RayTracing_Buffer.png", ImageFormat::PNG, resolveSettings,
+			[](const std::string& filename, bool isWritten)
+			{
+				if (isWritten)
+					std::cout << "Screenshot saved to " << filename << std::endl;
+				else
+					std::cout << "Something went wrong. Screenshot not saved!" << std::endl;
+			});
+		return;
+	}
+
+	std::ostringstream sequenceFilename;
+	sequenceFilename << "RayTracing_Frame_" << std::setw(4) << std::setfill('0') << m_SequenceFrameIndex++ << ".png";
+
+	//Dropping a capture frame keeps the window responsive when the disk cannot keep up
+	const bool isQueued = m_Encoder.TryEncode(m_ResolvedFrame, sequenceFilename.str(), ImageFormat::PNG, resolveSettings,
+		[](const std::string& filename, bool isWritten)
+		{
+			if (!isWritten)
+				std::cout << "Could not write " << filename << std::endl;
+		});
+
+	if (!isQueued)
+		std::cout << "Encoder is behind, skipped capture frame (" << ++m_SkippedSequenceFrameCount << " so far)" << std::endl;
+}
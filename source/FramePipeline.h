@@ -0,0 +1,82 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Framebuffer.h"
+#include "FramebufferResolver.h"
+
+namespace dae
+{
+	class FrameEncoder;
+	class Presenter;
+
+	/**
+	 * \brief Resolves finished frames and hands captures to the encoder on a thread of its own, so the next
+	 * frame is traced while the previous one is resolved and queued for writing. The main thread then flips the
+	 * resolved pixels to the window with Present, SDL windows only take calls from the thread that created them.
+	 * Frames are handed over by swapping buffers, no pixels are copied. The queue holds a single frame: submitting
+	 * waits until the previous frame was picked up, which keeps the screen at most one frame behind the input.
+	 */
+	class FramePipeline final
+	{
+	public:
+		enum class Capture
+		{
+			None = 0,
+			Screenshot = 1, //Always written, waits for the encoder if it is behind
+			SequenceFrame = 2 //Next numbered frame of a sequence, skipped if the encoder is behind
+		};
+
+		FramePipeline(Presenter& presenter, FrameEncoder& encoder);
+		~FramePipeline();
+
+		FramePipeline(const FramePipeline&) = delete;
+		FramePipeline(FramePipeline&&) noexcept = delete;
+		FramePipeline& operator=(const FramePipeline&) = delete;
+		FramePipeline& operator=(FramePipeline&&) noexcept = delete;
+
+		/**
+		 * \param framebuffer finished frame, gets a framebuffer of the same size back to render the next frame into
+		 * \param capture whether to write this frame to disk once it is presented
+		 */
+		void Submit(Framebuffer& framebuffer, Capture capture = Capture::None);
+
+		//Flips the latest resolved frame to the window if there is a new one, call it on the window's thread
+		void Present();
+
+		//Owned by the calling thread, handed to the presenter's resolver together with every submitted frame
+		FramebufferResolver::Settings& GetResolverSettings() { return m_ResolverSettings; }
+
+	private:
+		Presenter& m_Presenter;
+		FrameEncoder& m_Encoder;
+		FramebufferResolver::Settings m_ResolverSettings{};
+
+		//Shared between the threads, guarded by m_Mutex
+		std::mutex m_Mutex{};
+		std::condition_variable m_Condition{};
+		Framebuffer m_PendingFrame{};
+		FramebufferResolver::Settings m_PendingSettings{};
+		bool m_HasPendingFrame{};
+		Capture m_PendingCapture{};
+		bool m_IsRunning{ true };
+		std::vector<uint32_t> m_ReadyPixels{};
+		bool m_HasReadyPixels{};
+
+		//Only touched by the pipeline's thread
+		Framebuffer m_ResolvedFrame{};
+		std::vector<uint32_t> m_ResolvedPixels{};
+		int m_SequenceFrameIndex{};
+		int m_SkippedSequenceFrameCount{};
+
+		//Only touched by the window's thread
+		std::vector<uint32_t> m_PresentedPixels{};
+
+		std::thread m_Thread{};
+
+		void Run();
+		void CaptureFrame(Capture capture, const FramebufferResolver::Settings& resolveSettings);
+	};
+}
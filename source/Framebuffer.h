@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+
+#include "Math.h"
+
+namespace dae
+{
+	//Linear float RGB image the renderer writes into, independent of any window or surface
+	class Framebuffer final
+	{
+	public:
+		Framebuffer() = default;
+		Framebuffer(int width, int height)
+		{
+			Resize(width, height);
+		}
+
+		void Resize(int width, int height)
+		{
+			m_Width = width;
+			m_Height = height;
+			m_Pixels.assign(size_t(width) * height, ColorRGB{});
+		}
+
+		ColorRGB& At(int px, int py) { return m_Pixels[px + (py * m_Width)]; }
+		const ColorRGB& At(int px, int py) const { return m_Pixels[px + (py * m_Width)]; }
+
+		ColorRGB* GetPixels() { return m_Pixels.data(); }
+		const ColorRGB* GetPixels() const { return m_Pixels.data(); }
+
+		int GetWidth() const { return m_Width; }
+		int GetHeight() const { return m_Height; }
+
+	private:
+		std::vector<ColorRGB> m_Pixels{};
+
+		int m_Width{};
+		int m_Height{};
+	};
+}
@@ -0,0 +1,186 @@
+#include "FramebufferResolver.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Framebuffer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RAYTRACER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace dae
+{
+	namespace
+	{
+		float ToneMap(float value, ToneMapping toneMapping)
+		{
+			switch (toneMapping)
+			{
+			case ToneMapping::Reinhard:
+				return value / (1.f + value);
+			case ToneMapping::ACES:
+				return (value * (2.51f * value + 0.03f)) / (value * (2.43f * value + 0.59f) + 0.14f);
+			default:
+				return value;
+			}
+		}
+	}
+
+	FramebufferResolver::FramebufferResolver()
+	{
+		for (int i{}; i < s_SRGBTableSize; ++i)
+		{
+			const float linear = i / float(s_SRGBTableSize - 1);
+			const float encoded = linear <= 0.0031308f ? linear * 12.92f : 1.055f * powf(linear, 1.f / 2.4f) - 0.055f;
+			m_SRGBTable[i] = static_cast<uint8_t>(std::clamp(encoded, 0.f, 1.f) * 255.f + 0.5f);
+		}
+	}
+
+	void FramebufferResolver::Resolve(const Framebuffer& framebuffer, const PackedPixelFormat& format, uint32_t* pDestination, int destinationPitch) const
+	{
+		static_assert(sizeof(ColorRGB) == 3 * sizeof(float), "Rows are read as raw float triplets");
+
+		const int width = framebuffer.GetWidth();
+		const int height = framebuffer.GetHeight();
+
+		for (int py{}; py < height; ++py)
+		{
+			const float* pSourceRow = &framebuffer.At(0, py).r;
+			uint32_t* pDestinationRow = reinterpret_cast<uint32_t*>(reinterpret_cast<uint8_t*>(pDestination) + size_t(py) * destinationPitch);
+
+#ifdef RAYTRACER_SSE2
+			const int vectorCount = width & ~3;
+			ResolveRowSSE2(pSourceRow, vectorCount, format, pDestinationRow);
+			ResolveRowScalar(pSourceRow + vectorCount * 3, width - vectorCount, format, pDestinationRow + vectorCount);
+#else
+			ResolveRowScalar(pSourceRow, width, format, pDestinationRow);
+#endif
+		}
+	}
+
+	void FramebufferResolver::ResolveRowScalar(const float* pSource, int count, const PackedPixelFormat& format, uint32_t* pDestination) const
+	{
+		for (int i{}; i < count; ++i, pSource += 3)
+		{
+			float channels[3]{ pSource[0] * m_Settings.exposure, pSource[1] * m_Settings.exposure, pSource[2] * m_Settings.exposure };
+
+			if (m_Settings.toneMapping == ToneMapping::MaxToOne)
+			{
+				const float scale = 1.f / std::max(std::max(channels[0], std::max(channels[1], channels[2])), 1.f);
+				for (float& channel : channels)
+					channel *= scale;
+			}
+
+			uint32_t codes[3]{};
+			for (int c{}; c < 3; ++c)
+			{
+				const float value = std::clamp(ToneMap(channels[c], m_Settings.toneMapping), 0.f, 1.f);
+				codes[c] = m_Settings.sRGBEncode
+					? m_SRGBTable[static_cast<int>(value * (s_SRGBTableSize - 1) + 0.5f)]
+					: static_cast<uint32_t>(value * 255.f);
+			}
+
+			pDestination[i] = (codes[0] << format.redShift) | (codes[1] << format.greenShift) | (codes[2] << format.blueShift) | format.alphaMask;
+		}
+	}
+
+#ifdef RAYTRACER_SSE2
+	void FramebufferResolver::ResolveRowSSE2(const float* pSource, int count, const PackedPixelFormat& format, uint32_t* pDestination) const
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.f);
+		const __m128 exposure = _mm_set1_ps(m_Settings.exposure);
+		const __m128 codeScale = _mm_set1_ps(m_Settings.sRGBEncode ? float(s_SRGBTableSize - 1) : 255.f);
+		const __m128 codeBias = _mm_set1_ps(m_Settings.sRGBEncode ? 0.5f : 0.f);
+
+		const __m128i redShift = _mm_cvtsi32_si128(static_cast<int>(format.redShift));
+		const __m128i greenShift = _mm_cvtsi32_si128(static_cast<int>(format.greenShift));
+		const __m128i blueShift = _mm_cvtsi32_si128(static_cast<int>(format.blueShift));
+		const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(format.alphaMask));
+
+		for (int i{}; i < count; i += 4, pSource += 12)
+		{
+			//Four rgb triplets -> one register per channel
+			const __m128 a = _mm_loadu_ps(pSource); //r0 g0 b0 r1
+			const __m128 b = _mm_loadu_ps(pSource + 4); //g1 b1 r2 g2
+			const __m128 c = _mm_loadu_ps(pSource + 8); //b2 r3 g3 b3
+
+			__m128 red = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 2, 3, 0)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 1, 0));
+			__m128 green = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+			__m128 blue = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+
+			red = _mm_mul_ps(red, exposure);
+			green = _mm_mul_ps(green, exposure);
+			blue = _mm_mul_ps(blue, exposure);
+
+			switch (m_Settings.toneMapping)
+			{
+			case ToneMapping::MaxToOne:
+			{
+				const __m128 scale = _mm_div_ps(one, _mm_max_ps(_mm_max_ps(red, _mm_max_ps(green, blue)), one));
+				red = _mm_mul_ps(red, scale);
+				green = _mm_mul_ps(green, scale);
+				blue = _mm_mul_ps(blue, scale);
+				break;
+			}
+			case ToneMapping::Reinhard:
+				red = _mm_div_ps(red, _mm_add_ps(one, red));
+				green = _mm_div_ps(green, _mm_add_ps(one, green));
+				blue = _mm_div_ps(blue, _mm_add_ps(one, blue));
+				break;
+			case ToneMapping::ACES:
+			{
+				const auto aces = [](__m128 x)
+					{
+						const __m128 numerator = _mm_mul_ps(x, _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(2.51f)), _mm_set1_ps(0.03f)));
+						const __m128 denominator = _mm_add_ps(_mm_mul_ps(x, _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(2.43f)), _mm_set1_ps(0.59f))), _mm_set1_ps(0.14f));
+						return _mm_div_ps(numerator, denominator);
+					};
+				red = aces(red);
+				green = aces(green);
+				blue = aces(blue);
+				break;
+			}
+			default:
+				break;
+			}
+
+			//Clamp and quantize, truncating like the scalar path
+			__m128i redCode = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(red, zero), one), codeScale), codeBias));
+			__m128i greenCode = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(green, zero), one), codeScale), codeBias));
+			__m128i blueCode = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(blue, zero), one), codeScale), codeBias));
+
+			if (m_Settings.sRGBEncode)
+			{
+				alignas(16) int32_t indices[3][4];
+				_mm_store_si128(reinterpret_cast<__m128i*>(indices[0]), redCode);
+				_mm_store_si128(reinterpret_cast<__m128i*>(indices[1]), greenCode);
+				_mm_store_si128(reinterpret_cast<__m128i*>(indices[2]), blueCode);
+
+				for (auto& channel : indices)
+				{
+					for (int32_t& index : channel)
+						index = m_SRGBTable[index];
+				}
+
+				redCode = _mm_load_si128(reinterpret_cast<const __m128i*>(indices[0]));
+				greenCode = _mm_load_si128(reinterpret_cast<const __m128i*>(indices[1]));
+				blueCode = _mm_load_si128(reinterpret_cast<const __m128i*>(indices[2]));
+			}
+
+			__m128i packed = _mm_or_si128(_mm_sll_epi32(redCode, redShift), _mm_sll_epi32(greenCode, greenShift));
+			packed = _mm_or_si128(packed, _mm_sll_epi32(blueCode, blueShift));
+			packed = _mm_or_si128(packed, alphaMask);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDestination + i), packed);
+		}
+	}
+#else
+	void FramebufferResolver::ResolveRowSSE2(const float* pSource, int count, const PackedPixelFormat& format, uint32_t* pDestination) const
+	{
+		ResolveRowScalar(pSource, count, format, pDestination);
+	}
+#endif
+}
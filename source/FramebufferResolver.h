@@ -0,0 +1,74 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+namespace dae
+{
+	class Framebuffer;
+
+	enum class ToneMapping
+	{
+		MaxToOne = 0, //Divides by the largest channel when it exceeds 1, keeps the hue
+		Reinhard = 1,
+		ACES = 2, //Narkowicz fit of the ACES filmic curve
+		Max = 3
+	};
+
+	//How the resolved pixels are laid out in a 32-bit word
+	struct PackedPixelFormat
+	{
+		uint32_t redShift{ 0 };
+		uint32_t greenShift{ 8 };
+		uint32_t blueShift{ 16 };
+		uint32_t alphaMask{ 0 };
+	};
+
+	/**
+	 * \brief Turns the linear float framebuffer into 8-bit packed pixels: exposure, tone mapping,
+	 * optional sRGB encoding and packing in one pass. Four pixels are processed at once with SSE2
+	 * when available, the pixel format is only looked at once per call.
+	 */
+	class FramebufferResolver final
+	{
+	public:
+		struct Settings
+		{
+			ToneMapping toneMapping{ ToneMapping::MaxToOne };
+			float exposure{ 1.f };
+			bool sRGBEncode{ false }; //The scenes are lit for a display without gamma, off keeps their look
+
+			void CycleToneMapping() { toneMapping = static_cast<ToneMapping>((static_cast<int>(toneMapping) + 1) % static_cast<int>(ToneMapping::Max)); }
+			void ToggleSRGBEncode() { sRGBEncode = !sRGBEncode; }
+		};
+
+		FramebufferResolver();
+		~FramebufferResolver() = default;
+
+		FramebufferResolver(const FramebufferResolver&) = delete;
+		FramebufferResolver(FramebufferResolver&&) noexcept = delete;
+		FramebufferResolver& operator=(const FramebufferResolver&) = delete;
+		FramebufferResolver& operator=(FramebufferResolver&&) noexcept = delete;
+
+		/**
+		 * \param framebuffer source image
+		 * \param format channel layout of the destination
+		 * \param pDestination first destination row
+		 * \param destinationPitch bytes between two destination rows
+		 */
+		void Resolve(const Framebuffer& framebuffer, const PackedPixelFormat& format, uint32_t* pDestination, int destinationPitch) const;
+
+		Settings& GetSettings() { return m_Settings; }
+		const Settings& GetSettings() const { return m_Settings; }
+
+	private:
+		static constexpr int s_SRGBTableSize{ 4096 };
+
+		Settings m_Settings{};
+
+		//Linear [0, 1] quantized to 12 bits, to the 8-bit sRGB code value
+		std::array<uint8_t, s_SRGBTableSize> m_SRGBTable{};
+
+		void ResolveRowScalar(const float* pSource, int count, const PackedPixelFormat& format, uint32_t* pDestination) const;
+		void ResolveRowSSE2(const float* pSource, int count, const PackedPixelFormat& format, uint32_t* pDestination) const;
+	};
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+#include "Math.h"
+
+namespace dae
+{
+	//Everything the renderer knows about the primary hit of a single pixel
+	struct GBufferTexel
+	{
+		Vector3 position{};
+		Vector3 normal{};
+		Vector3 viewDirection{};
+		ColorRGB color{};
+		float depth{ FLT_MAX };
+
+		uint32_t materialIndex{ 0 };
+		uint8_t age{ 0 };
+		bool didHit{ false };
+	};
+
+	class GBuffer final
+	{
+	public:
+		void Resize(int width, int height)
+		{
+			m_Width = width;
+			m_Height = height;
+			m_Texels.assign(size_t(width) * height, GBufferTexel{});
+		}
+
+		void Clear()
+		{
+			m_Texels.assign(m_Texels.size(), GBufferTexel{});
+		}
+
+		GBufferTexel& At(int px, int py) { return m_Texels[px + (py * m_Width)]; }
+		const GBufferTexel& At(int px, int py) const { return m_Texels[px + (py * m_Width)]; }
+
+		int GetWidth() const { return m_Width; }
+		int GetHeight() const { return m_Height; }
+
+	private:
+		std::vector<GBufferTexel> m_Texels{};
+
+		int m_Width{};
+		int m_Height{};
+	};
+}
@@ -0,0 +1,514 @@
+//Headless entry point: renders frames into an in-memory framebuffer and writes them to disk,
+//no window, no SDL and no VLD so it runs on render farm machines
+
+//Standard includes
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+//Project includes
+#include "FrameEncoder.h"
+#include "ImageWriter.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "Timer.h"
+#include "WavefrontRenderer.h"
+
+using namespace dae;
+
+namespace
+{
+	struct Options
+	{
+		std::string sceneName{ "W4_Reference" };
+		std::string renderMode{ "standard" };
+		std::string outputPrefix{ "frame" };
+		std::string format{ "ppm" };
+		std::string toneMapping{ "maxtoone" };
+		std::string sampler{ "sobol" };
+		std::string lightSelection{ "culled" };
+		std::string indirectMode{ "off" };
+		std::string brdfPrecision{ "exact" };
+		std::string environmentFile{};
+		std::string environmentSampling{ "importance" };
+		uint32_t environmentSampleCount{ 4 };
+		int width{ 640 };
+		int height{ 480 };
+		int frameCount{ 1 };
+		uint32_t samplesPerPixel{ 1 };
+		uint32_t lightSampleCount{ 8 };
+		uint32_t lightCandidateCount{ 8 };
+		float minLightContribution{ 0.f };
+		float lightThreshold{ -1.f }; //negative keeps the scene's influence radii
+		int tileSize{ 16 };
+		uint32_t areaGridSize{ 4 };
+		uint32_t penumbraGridSize{ 12 };
+		size_t shadowSampleBudget{};
+		float visibilityVoxelSize{ 0.1f };
+		float irradianceError{ 0.3f };
+		float timeStep{ 1.f / 30.f };
+		float exposure{ 1.f };
+		bool sRGBEncode{ false };
+		bool sortShadowRays{ true };
+		bool useOccluderCache{ true };
+		bool useVisibilityCache{ false };
+		bool writeFrames{ true };
+	};
+
+	void PrintUsage()
+	{
+		std::cout << "Usage: RayTracerHeadless [options]\n"
+			<< "  --scene <W1|W2|W3|W4|W4_Reference|W4_Bunny|ManyLights|AreaLights|Outdoor>  scene to render (default W4_Reference)\n"
+			<< "  --width <pixels> --height <pixels>           resolution (default 640x480)\n"
+			<< "  --frames <count>                             frames to render (default 1)\n"
+			<< "  --spp <count>                                samples per pixel in standard mode (default 1)\n"
+			<< "  --sampler <random|sobol|bluenoise>           pixel jitter of multi-sample modes (default sobol)\n"
+			<< "  --mode <standard|adaptive|reprojection|dynamic|checkerboard|wavefront>\n"
+			<< "  --timestep <seconds>                         fixed animation step per frame (default 1/30)\n"
+			<< "  --output <prefix>                            output file prefix (default frame)\n"
+			<< "  --format <ppm|png|pfm|exr>                   8-bit PPM/PNG or float PFM/half EXR (default ppm)\n"
+			<< "  --tonemap <maxtoone|reinhard|aces>           tone mapping of PPM output (default maxtoone)\n"
+			<< "  --exposure <scale>                           linear exposure of PPM output (default 1)\n"
+			<< "  --srgb                                       sRGB encode PPM output\n"
+			<< "  --lights <all|culled|sampled|power|tiled>    lights evaluated per shading point in scenes with many (default culled)\n"
+			<< "                                               culled is exact and only saves time with --light-cutoff, sampled and power are the fast ones\n"
+			<< "  --light-samples <count>                      lights picked per shading point by --lights sampled|power (default 8)\n"
+			<< "  --light-candidates <count>                   --lights power resamples each pick from this many (default 8)\n"
+			<< "  --light-cutoff <radiance>                    --lights culled skips clusters adding less (default 0, exact and no faster than all)\n"
+			<< "  --light-threshold <radiance>                 point lights reach until their radiance falls below, 0 everywhere (default per scene)\n"
+			<< "  --tile-size <pixels>                         tiles of --lights tiled (default 16)\n"
+			<< "  --environment <file.pfm>                     lat-long HDR map lighting the scene, replaces the scene's own\n"
+			<< "  --env-sampling <uniform|importance>          how environment shadow rays pick directions (default importance)\n"
+			<< "  --env-samples <count>                        environment shadow rays per shading point (default 4)\n"
+			<< "  --indirect <off|sampled|cached>              one bounce of diffuse indirect light (default off)\n"
+			<< "  --irradiance-error <a>                       records of --indirect cached are reused up to a times their spacing (default 0.3)\n"
+			<< "  --brdf <exact|fast>                          fast evaluates BRDFs with approximations of bounded error (default exact)\n"
+			<< "                                               with --mode wavefront fast also shades Phong and Cook-Torrance materials in\n"
+			<< "                                               batches, 4 lanes wide with SSE2 or 8 in an AVX build, Lambert is never batched\n"
+			<< "  --area-grid <n>                              n x n stratified shadow samples per area light (default 4)\n"
+			<< "  --penumbra-grid <n>                          up to n x n more where those disagree (default 12)\n"
+			<< "  --shadow-budget <samples>                    area light shadow samples per frame, 0 unlimited (default 0)\n"
+			<< "  --no-ray-sorting                             trace wavefront shadow rays in emission order\n"
+			<< "  --no-occluder-cache                          trace every shadow ray through the whole scene\n"
+			<< "  --visibility-cache                           reuse point light visibility of static scenes across frames, approximate:\n"
+			<< "                                               voxels whose shadow rays agreed stop tracing and miss shadows thinner than a voxel\n"
+			<< "  --visibility-voxel <size>                    voxel size of the visibility cache (default 0.1)\n"
+			<< "  --no-output                                  only print timings\n";
+	}
+
+	bool ParseOptions(int argc, char* args[], Options& options)
+	{
+		for (int i{ 1 }; i < argc; ++i)
+		{
+			const std::string argument = args[i];
+
+			if (argument == "--help" || argument == "-h")
+				return false;
+
+			if (argument == "--no-output")
+			{
+				options.writeFrames = false;
+				continue;
+			}
+
+			if (argument == "--srgb")
+			{
+				options.sRGBEncode = true;
+				continue;
+			}
+
+			if (argument == "--no-ray-sorting")
+			{
+				options.sortShadowRays = false;
+				continue;
+			}
+
+			if (argument == "--no-occluder-cache")
+			{
+				options.useOccluderCache = false;
+				continue;
+			}
+
+			if (argument == "--visibility-cache")
+			{
+				options.useVisibilityCache = true;
+				continue;
+			}
+
+			if (argument.rfind("--", 0) != 0 || i + 1 >= argc)
+			{
+				std::cerr << (i + 1 >= argc ? "Missing value for " : "Unknown option ") << argument << std::endl;
+				return false;
+			}
+
+			if (argument == "--scene")
+				options.sceneName = args[++i];
+			else if (argument == "--mode")
+				options.renderMode = args[++i];
+			else if (argument == "--output")
+				options.outputPrefix = args[++i];
+			else if (argument == "--format")
+				options.format = args[++i];
+			else if (argument == "--tonemap")
+				options.toneMapping = args[++i];
+			else if (argument == "--sampler")
+				options.sampler = args[++i];
+			else if (argument == "--lights")
+				options.lightSelection = args[++i];
+			else if (argument == "--environment")
+				options.environmentFile = args[++i];
+			else if (argument == "--env-sampling")
+				options.environmentSampling = args[++i];
+			else if (argument == "--env-samples")
+				options.environmentSampleCount = static_cast<uint32_t>(std::atoi(args[++i]));
+			else if (argument == "--indirect")
+				options.indirectMode = args[++i];
+			else if (argument == "--brdf")
+				options.brdfPrecision = args[++i];
+			else if (argument == "--irradiance-error")
+				options.irradianceError = static_cast<float>(std::atof(args[++i]));
+			else if (argument == "--light-samples")
+				options.lightSampleCount = static_cast<uint32_t>(std::atoi(args[++i]));
+			else if (argument == "--light-candidates")
+				options.lightCandidateCount = static_cast<uint32_t>(std::atoi(args[++i]));
+			else if (argument == "--light-threshold")
+				options.lightThreshold = static_cast<float>(std::atof(args[++i]));
+			else if (argument == "--tile-size")
+				options.tileSize = std::atoi(args[++i]);
+			else if (argument == "--area-grid")
+				options.areaGridSize = static_cast<uint32_t>(std::atoi(args[++i]));
+			else if (argument == "--penumbra-grid")
+				options.penumbraGridSize = static_cast<uint32_t>(std::atoi(args[++i]));
+			else if (argument == "--visibility-voxel")
+				options.visibilityVoxelSize = static_cast<float>(std::atof(args[++i]));
+			else if (argument == "--shadow-budget")
+				options.shadowSampleBudget = static_cast<size_t>(std::atoll(args[++i]));
+			else if (argument == "--light-cutoff")
+				options.minLightContribution = static_cast<float>(std::atof(args[++i]));
+			else if (argument == "--exposure")
+				options.exposure = static_cast<float>(std::atof(args[++i]));
+			else if (argument == "--width")
+				options.width = std::atoi(args[++i]);
+			else if (argument == "--height")
+				options.height = std::atoi(args[++i]);
+			else if (argument == "--frames")
+				options.frameCount = std::atoi(args[++i]);
+			else if (argument == "--spp")
+				options.samplesPerPixel = static_cast<uint32_t>(std::atoi(args[++i]));
+			else if (argument == "--timestep")
+				options.timeStep = static_cast<float>(std::atof(args[++i]));
+			else
+			{
+				std::cerr << "Unknown option " << argument << std::endl;
+				return false;
+			}
+		}
+
+		if (options.width <= 0 || options.height <= 0 || options.frameCount <= 0)
+		{
+			std::cerr << "Resolution and frame count must be positive" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	std::unique_ptr<Scene> CreateScene(const std::string& sceneName)
+	{
+		if (sceneName == "W1") return std::make_unique<Scene_W1>();
+		if (sceneName == "W2") return std::make_unique<Scene_W2>();
+		if (sceneName == "W3") return std::make_unique<Scene_W3>();
+		if (sceneName == "W4") return std::make_unique<Scene_W4>();
+		if (sceneName == "W4_Reference") return std::make_unique<Scene_W4_Reference>();
+		if (sceneName == "W4_Bunny") return std::make_unique<Scene_W4_Bunny>();
+		if (sceneName == "ManyLights") return std::make_unique<Scene_ManyLights>();
+		if (sceneName == "AreaLights") return std::make_unique<Scene_AreaLights>();
+		if (sceneName == "Outdoor") return std::make_unique<Scene_Outdoor>();
+
+		return nullptr;
+	}
+
+	bool ParseRenderMode(const std::string& name, Renderer::RenderMode& renderMode)
+	{
+		if (name == "standard") renderMode = Renderer::RenderMode::Standard;
+		else if (name == "adaptive") renderMode = Renderer::RenderMode::Adaptive;
+		else if (name == "reprojection") renderMode = Renderer::RenderMode::Reprojection;
+		else if (name == "dynamic") renderMode = Renderer::RenderMode::DynamicResolution;
+		else if (name == "checkerboard") renderMode = Renderer::RenderMode::Checkerboard;
+		else if (name == "wavefront") renderMode = Renderer::RenderMode::Wavefront;
+		else return false;
+
+		return true;
+	}
+
+	bool ParseToneMapping(const std::string& name, ToneMapping& toneMapping)
+	{
+		if (name == "maxtoone") toneMapping = ToneMapping::MaxToOne;
+		else if (name == "reinhard") toneMapping = ToneMapping::Reinhard;
+		else if (name == "aces") toneMapping = ToneMapping::ACES;
+		else return false;
+
+		return true;
+	}
+
+	bool ParseSamplerType(const std::string& name, SamplerType& samplerType)
+	{
+		if (name == "random") samplerType = SamplerType::Random;
+		else if (name == "sobol") samplerType = SamplerType::Sobol;
+		else if (name == "bluenoise") samplerType = SamplerType::BlueNoise;
+		else return false;
+
+		return true;
+	}
+
+	bool ParseLightSelection(const std::string& name, Renderer::LightSelection& lightSelection)
+	{
+		if (name == "all") lightSelection = Renderer::LightSelection::All;
+		else if (name == "culled") lightSelection = Renderer::LightSelection::Culled;
+		else if (name == "sampled") lightSelection = Renderer::LightSelection::Sampled;
+		else if (name == "power") lightSelection = Renderer::LightSelection::Power;
+		else if (name == "tiled") lightSelection = Renderer::LightSelection::Tiled;
+		else return false;
+
+		return true;
+	}
+
+	bool ParseEnvironmentSampling(const std::string& name, Renderer::EnvironmentSampling& sampling)
+	{
+		if (name == "uniform") sampling = Renderer::EnvironmentSampling::Uniform;
+		else if (name == "importance") sampling = Renderer::EnvironmentSampling::Importance;
+		else return false;
+
+		return true;
+	}
+
+	bool ParseIndirectMode(const std::string& name, Renderer::IndirectMode& indirectMode)
+	{
+		if (name == "off") indirectMode = Renderer::IndirectMode::Off;
+		else if (name == "sampled") indirectMode = Renderer::IndirectMode::Sampled;
+		else if (name == "cached") indirectMode = Renderer::IndirectMode::Cached;
+		else return false;
+
+		return true;
+	}
+
+	bool ParseBRDFPrecision(const std::string& name, BRDF::Precision& precision)
+	{
+		if (name == "exact") precision = BRDF::Precision::Exact;
+		else if (name == "fast") precision = BRDF::Precision::Fast;
+		else return false;
+
+		return true;
+	}
+
+	bool ParseImageFormat(const std::string& name, ImageFormat& format)
+	{
+		if (name == "ppm") format = ImageFormat::PPM;
+		else if (name == "png") format = ImageFormat::PNG;
+		else if (name == "pfm") format = ImageFormat::PFM;
+		else if (name == "exr") format = ImageFormat::EXR;
+		else return false;
+
+		return true;
+	}
+}
+
+int main(int argc, char* args[])
+{
+	Options options{};
+	if (!ParseOptions(argc, args, options))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	const std::unique_ptr<Scene> pScene = CreateScene(options.sceneName);
+	if (!pScene)
+	{
+		std::cerr << "Unknown scene " << options.sceneName << std::endl;
+		return 1;
+	}
+
+	Renderer::RenderMode renderMode{};
+	if (!ParseRenderMode(options.renderMode, renderMode))
+	{
+		std::cerr << "Unknown render mode " << options.renderMode << std::endl;
+		return 1;
+	}
+
+	FramebufferResolver::Settings resolveSettings{};
+	resolveSettings.exposure = options.exposure;
+	resolveSettings.sRGBEncode = options.sRGBEncode;
+	if (!ParseToneMapping(options.toneMapping, resolveSettings.toneMapping))
+	{
+		std::cerr << "Unknown tone mapping " << options.toneMapping << std::endl;
+		return 1;
+	}
+
+	SamplerType samplerType{};
+	if (!ParseSamplerType(options.sampler, samplerType))
+	{
+		std::cerr << "Unknown sampler " << options.sampler << std::endl;
+		return 1;
+	}
+
+	Renderer::LightSettings lightSettings{};
+	lightSettings.sampleCount = options.lightSampleCount;
+	lightSettings.candidateCount = options.lightCandidateCount;
+	lightSettings.minContribution = options.minLightContribution;
+	if (!ParseLightSelection(options.lightSelection, lightSettings.selection))
+	{
+		std::cerr << "Unknown light selection " << options.lightSelection << std::endl;
+		return 1;
+	}
+
+	Renderer::EnvironmentSettings environmentSettings{};
+	environmentSettings.sampleCount = options.environmentSampleCount;
+	if (!ParseEnvironmentSampling(options.environmentSampling, environmentSettings.sampling))
+	{
+		std::cerr << "Unknown environment sampling " << options.environmentSampling << std::endl;
+		return 1;
+	}
+
+	Renderer::IndirectMode indirectMode{};
+	if (!ParseIndirectMode(options.indirectMode, indirectMode))
+	{
+		std::cerr << "Unknown indirect mode " << options.indirectMode << std::endl;
+		return 1;
+	}
+
+	BRDF::Precision brdfPrecision{};
+	if (!ParseBRDFPrecision(options.brdfPrecision, brdfPrecision))
+	{
+		std::cerr << "Unknown BRDF precision " << options.brdfPrecision << std::endl;
+		return 1;
+	}
+
+	ImageFormat imageFormat{};
+	if (!ParseImageFormat(options.format, imageFormat))
+	{
+		std::cerr << "Unknown format " << options.format << std::endl;
+		return 1;
+	}
+
+	pScene->Initialize();
+	if (options.lightThreshold >= 0.f)
+		pScene->SetLightInfluenceThreshold(options.lightThreshold);
+
+	if (!options.environmentFile.empty() && !pScene->GetEnvironment().LoadPFM(options.environmentFile))
+	{
+		std::cerr << "Could not read environment map " << options.environmentFile << std::endl;
+		return 1;
+	}
+
+	Renderer renderer{ options.width, options.height };
+	renderer.SetRenderMode(renderMode);
+	renderer.SetSamplesPerPixel(options.samplesPerPixel);
+	renderer.SetSamplerType(samplerType);
+	renderer.GetLightSettings() = lightSettings;
+	renderer.GetEnvironmentSettings() = environmentSettings;
+	renderer.SetOccluderCacheEnabled(options.useOccluderCache);
+	renderer.GetTileLightCuller().GetSettings().tileSize = options.tileSize;
+	renderer.GetShadowSampleBudget().GetSettings().baseGridSize = options.areaGridSize;
+	renderer.GetShadowSampleBudget().GetSettings().maxPenumbraGridSize = options.penumbraGridSize;
+	renderer.GetShadowSampleBudget().GetSettings().frameBudget = options.shadowSampleBudget;
+	renderer.SetVisibilityCacheEnabled(options.useVisibilityCache);
+	renderer.SetIndirectMode(indirectMode);
+	renderer.SetBRDFPrecision(brdfPrecision);
+	renderer.GetIrradianceCache().GetSettings().maxError = options.irradianceError;
+	renderer.GetVisibilityCache().GetSettings().voxelSize = options.visibilityVoxelSize;
+	renderer.GetWavefrontRenderer().GetSettings().sortShadowRays = options.sortShadowRays;
+
+	const bool isWavefront = renderMode == Renderer::RenderMode::Wavefront && renderer.CanRenderWavefront(pScene.get());
+	if (renderMode == Renderer::RenderMode::Wavefront && !isWavefront)
+		std::cerr << "Wavefront mode cannot trace scene " << options.sceneName << " with these settings, it renders in standard mode" << std::endl;
+
+	//Fixed step so animated scenes produce the same frames on every machine
+	Timer timer{};
+	timer.SetFixedElapsed(options.timeStep);
+	timer.Start();
+
+	//Frames are written on the encoder's thread while the next one renders, a full queue waits rather than dropping frames
+	FrameEncoder encoder{};
+	std::atomic<bool> hasWriteFailed{ false };
+
+	double totalRenderTime{};
+	for (int frame{}; frame < options.frameCount; ++frame)
+	{
+		pScene->Update(&timer);
+
+		const auto startTime = std::chrono::steady_clock::now();
+		renderer.Render(pScene.get());
+		const double renderTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+		totalRenderTime += renderTime;
+		timer.Update();
+
+		std::cout << "Frame " << frame << ": " << std::fixed << std::setprecision(2) << renderTime << " ms";
+		if (renderer.GetAverageSamplesPerPixel() != 1.f)
+			std::cout << " (" << renderer.GetAverageSamplesPerPixel() << " spp)";
+		if (isWavefront)
+		{
+			const WavefrontRenderer::Statistics& statistics = renderer.GetWavefrontRenderer().GetStatistics();
+			std::cout << " (" << statistics.shadowRayCount << " shadow rays, " << statistics.GetTestsPerShadowRay() << " tests per shadow ray)";
+		}
+		else if (renderer.GetOccluderCacheStatistics().queryCount > 0)
+		{
+			std::cout << " (" << renderer.GetOccluderCacheStatistics().GetHitRate() * 100.f << "% occluder cache hits)";
+		}
+		if (renderer.GetVisibilityCache().GetStatistics().queryCount > 0)
+		{
+			std::cout << " (" << renderer.GetVisibilityCache().GetStatistics().GetHitRate() * 100.f << "% visibility cache hits)";
+		}
+		if (renderer.GetIndirectMode() == Renderer::IndirectMode::Cached)
+		{
+			const IrradianceCache::Statistics& statistics = renderer.GetIrradianceCache().GetStatistics();
+			std::cout << " (" << statistics.recordCount << " new irradiance records, " << renderer.GetIrradianceCache().GetRecordCount() << " total, "
+				<< statistics.GetHitRate() * 100.f << "% interpolated)";
+		}
+		if (renderer.GetShadowSampleBudget().GetStatistics().GetSampleCount() > 0)
+		{
+			const ShadowSampleBudget::Statistics& statistics = renderer.GetShadowSampleBudget().GetStatistics();
+			std::cout << " (" << statistics.GetSampleCount() << " area shadow samples, " << statistics.GetPenumbraFraction() * 100.f << "% penumbra)";
+		}
+		if (renderer.GetTileLightCuller().GetStatistics().tileCount > 0)
+		{
+			std::cout << " (" << renderer.GetTileLightCuller().GetStatistics().GetAverageLightCount() << " lights per tile)";
+		}
+		std::cout << std::endl;
+
+		if (!options.writeFrames)
+			continue;
+
+		std::ostringstream filename;
+		filename << options.outputPrefix << "_" << std::setw(4) << std::setfill('0') << frame << "." << ImageWriter::GetExtension(imageFormat);
+
+		encoder.Encode(renderer.GetFramebuffer(), filename.str(), imageFormat, resolveSettings,
+			[&hasWriteFailed](const std::string& filename, bool isWritten)
+			{
+				if (isWritten)
+					return;
+
+				std::cerr << "Could not write " << filename << std::endl;
+				hasWriteFailed = true;
+			});
+
+		if (hasWriteFailed)
+			return 1;
+	}
+
+	encoder.Flush();
+	if (hasWriteFailed)
+		return 1;
+
+	std::cout << "Rendered " << options.frameCount << " frame(s), average " << std::fixed << std::setprecision(2)
+		<< totalRenderTime / options.frameCount << " ms" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,576 @@
+#include "ImageWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include "Framebuffer.h"
+
+namespace dae
+{
+	namespace
+	{
+		//Tone mapped 8-bit RGB triplets, rows top to bottom
+		std::vector<uint8_t> ResolveRGB8(const Framebuffer& framebuffer, const FramebufferResolver::Settings& resolveSettings)
+		{
+			const size_t pixelCount = size_t(framebuffer.GetWidth()) * framebuffer.GetHeight();
+
+			//Resolve into little-endian RGBX words, then drop the padding byte
+			FramebufferResolver resolver{};
+			resolver.GetSettings() = resolveSettings;
+
+			std::vector<uint32_t> pixels(pixelCount);
+			resolver.Resolve(framebuffer, PackedPixelFormat{}, pixels.data(), framebuffer.GetWidth() * static_cast<int>(sizeof(uint32_t)));
+
+			std::vector<uint8_t> rgb(pixelCount * 3);
+			for (size_t i{}; i < pixelCount; ++i)
+			{
+				rgb[i * 3] = static_cast<uint8_t>(pixels[i]);
+				rgb[i * 3 + 1] = static_cast<uint8_t>(pixels[i] >> 8);
+				rgb[i * 3 + 2] = static_cast<uint8_t>(pixels[i] >> 16);
+			}
+
+			return rgb;
+		}
+
+		void AppendBigEndian(std::vector<uint8_t>& bytes, uint32_t value)
+		{
+			bytes.insert(bytes.end(), { uint8_t(value >> 24), uint8_t(value >> 16), uint8_t(value >> 8), uint8_t(value) });
+		}
+
+		void AppendLittleEndian(std::vector<uint8_t>& bytes, uint32_t value)
+		{
+			bytes.insert(bytes.end(), { uint8_t(value), uint8_t(value >> 8), uint8_t(value >> 16), uint8_t(value >> 24) });
+		}
+
+		void AppendLittleEndian(std::vector<uint8_t>& bytes, float value)
+		{
+			uint32_t bits{};
+			memcpy(&bits, &value, sizeof(bits));
+			AppendLittleEndian(bytes, bits);
+		}
+
+		void AppendLittleEndian(std::vector<uint8_t>& bytes, uint64_t value)
+		{
+			AppendLittleEndian(bytes, static_cast<uint32_t>(value));
+			AppendLittleEndian(bytes, static_cast<uint32_t>(value >> 32));
+		}
+
+		void AppendString(std::vector<uint8_t>& bytes, const char* pString)
+		{
+			bytes.insert(bytes.end(), pString, pString + strlen(pString) + 1);
+		}
+
+#pragma region Deflate
+		//Packs bits least significant first, the order deflate streams are read in
+		class BitWriter final
+		{
+		public:
+			explicit BitWriter(std::vector<uint8_t>& output) : m_Output(output) {}
+
+			void Write(uint32_t bits, int count)
+			{
+				m_Buffer |= bits << m_Count;
+				m_Count += count;
+
+				while (m_Count >= 8)
+				{
+					m_Output.push_back(static_cast<uint8_t>(m_Buffer));
+					m_Buffer >>= 8;
+					m_Count -= 8;
+				}
+			}
+
+			//Huffman codes are defined most significant bit first
+			void WriteCode(uint32_t code, int length)
+			{
+				uint32_t reversed{};
+				for (int i{}; i < length; ++i)
+					reversed |= ((code >> i) & 1) << (length - 1 - i);
+
+				Write(reversed, length);
+			}
+
+			void Flush()
+			{
+				if (m_Count > 0)
+					m_Output.push_back(static_cast<uint8_t>(m_Buffer));
+
+				m_Buffer = 0;
+				m_Count = 0;
+			}
+
+		private:
+			std::vector<uint8_t>& m_Output;
+			uint32_t m_Buffer{};
+			int m_Count{};
+		};
+
+		constexpr std::array<uint16_t, 29> s_LengthBases{ 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+		constexpr std::array<uint8_t, 29> s_LengthExtraBits{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+		constexpr std::array<uint16_t, 30> s_DistanceBases{ 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+		constexpr std::array<uint8_t, 30> s_DistanceExtraBits{ 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+		//Fixed Huffman code of a literal/length symbol, RFC 1951 3.2.6
+		void WriteFixedSymbol(BitWriter& writer, uint32_t symbol)
+		{
+			if (symbol < 144)
+				writer.WriteCode(0x30 + symbol, 8);
+			else if (symbol < 256)
+				writer.WriteCode(0x190 + symbol - 144, 9);
+			else if (symbol < 280)
+				writer.WriteCode(symbol - 256, 7);
+			else
+				writer.WriteCode(0xC0 + symbol - 280, 8);
+		}
+
+		void WriteMatch(BitWriter& writer, uint32_t length, uint32_t distance)
+		{
+			size_t lengthCode{ s_LengthBases.size() - 1 };
+			while (s_LengthBases[lengthCode] > length)
+				--lengthCode;
+
+			WriteFixedSymbol(writer, 257 + static_cast<uint32_t>(lengthCode));
+			writer.Write(length - s_LengthBases[lengthCode], s_LengthExtraBits[lengthCode]);
+
+			size_t distanceCode{ s_DistanceBases.size() - 1 };
+			while (s_DistanceBases[distanceCode] > distance)
+				--distanceCode;
+
+			writer.WriteCode(static_cast<uint32_t>(distanceCode), 5);
+			writer.Write(distance - s_DistanceBases[distanceCode], s_DistanceExtraBits[distanceCode]);
+		}
+
+		//zlib stream of a single fixed Huffman block, greedy LZ77 matches found through hash chains
+		std::vector<uint8_t> Deflate(const std::vector<uint8_t>& data)
+		{
+			constexpr size_t windowSize{ 32768 };
+			constexpr int hashBits{ 15 };
+			constexpr int maxChainLength{ 32 };
+			constexpr size_t minMatchLength{ 3 };
+			constexpr size_t maxMatchLength{ 258 };
+
+			const size_t size = data.size();
+			std::vector<uint8_t> output{ 0x78, 0x01 };
+			output.reserve(size / 2);
+
+			BitWriter writer{ output };
+			writer.Write(1, 1); //final block
+			writer.Write(1, 2); //fixed Huffman codes
+
+			std::vector<int32_t> head(size_t(1) << hashBits, -1);
+			std::vector<int32_t> previous(windowSize, -1);
+
+			const auto hash = [&](size_t i)
+				{
+					const uint32_t key = (uint32_t(data[i]) << 16) | (uint32_t(data[i + 1]) << 8) | data[i + 2];
+					return (key * 2654435761u) >> (32 - hashBits);
+				};
+
+			const auto insert = [&](size_t i)
+				{
+					if (i + minMatchLength > size)
+						return;
+
+					const uint32_t key = hash(i);
+					previous[i % windowSize] = head[key];
+					head[key] = static_cast<int32_t>(i);
+				};
+
+			size_t i{};
+			while (i < size)
+			{
+				size_t bestLength{};
+				size_t bestDistance{};
+
+				if (i + minMatchLength <= size)
+				{
+					const size_t maxLength = std::min(maxMatchLength, size - i);
+
+					// a chain slot is only overwritten a full window later, so every candidate closer than that is intact
+					int32_t candidate = head[hash(i)];
+					for (int chainLength{}; candidate >= 0 && chainLength < maxChainLength && i - candidate < windowSize; ++chainLength)
+					{
+						size_t length{};
+						while (length < maxLength && data[candidate + length] == data[i + length])
+							++length;
+
+						if (length > bestLength)
+						{
+							bestLength = length;
+							bestDistance = i - candidate;
+							if (length == maxLength)
+								break;
+						}
+
+						candidate = previous[candidate % windowSize];
+					}
+				}
+
+				if (bestLength >= minMatchLength)
+				{
+					WriteMatch(writer, static_cast<uint32_t>(bestLength), static_cast<uint32_t>(bestDistance));
+					for (size_t k{}; k < bestLength; ++k)
+						insert(i + k);
+
+					i += bestLength;
+				}
+				else
+				{
+					WriteFixedSymbol(writer, data[i]);
+					insert(i);
+					++i;
+				}
+			}
+
+			WriteFixedSymbol(writer, 256); //end of block
+			writer.Flush();
+
+			uint32_t adlerA{ 1 }, adlerB{};
+			for (const uint8_t byte : data)
+			{
+				adlerA = (adlerA + byte) % 65521;
+				adlerB = (adlerB + adlerA) % 65521;
+			}
+			AppendBigEndian(output, (adlerB << 16) | adlerA);
+
+			return output;
+		}
+#pragma endregion
+
+#pragma region PNG
+		uint32_t GetCRC(const uint8_t* pData, size_t size, uint32_t crc = 0)
+		{
+			static const std::array<uint32_t, 256> s_Table = []
+				{
+					std::array<uint32_t, 256> table{};
+					for (uint32_t n{}; n < 256; ++n)
+					{
+						uint32_t c{ n };
+						for (int k{}; k < 8; ++k)
+							c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+
+						table[n] = c;
+					}
+					return table;
+				}();
+
+			crc = ~crc;
+			for (size_t i{}; i < size; ++i)
+				crc = s_Table[(crc ^ pData[i]) & 0xFF] ^ (crc >> 8);
+
+			return ~crc;
+		}
+
+		void WriteChunk(std::ofstream& file, const char* pType, const std::vector<uint8_t>& data)
+		{
+			std::vector<uint8_t> header{};
+			AppendBigEndian(header, static_cast<uint32_t>(data.size()));
+			header.insert(header.end(), pType, pType + 4);
+
+			std::vector<uint8_t> footer{};
+			AppendBigEndian(footer, GetCRC(data.data(), data.size(), GetCRC(header.data() + 4, 4)));
+
+			file.write(reinterpret_cast<const char*>(header.data()), header.size());
+			file.write(reinterpret_cast<const char*>(data.data()), data.size());
+			file.write(reinterpret_cast<const char*>(footer.data()), footer.size());
+		}
+
+		uint8_t GetPaethPredictor(int a, int b, int c)
+		{
+			const int p = a + b - c;
+			const int pa = std::abs(p - a);
+			const int pb = std::abs(p - b);
+			const int pc = std::abs(p - c);
+
+			if (pa <= pb && pa <= pc)
+				return static_cast<uint8_t>(a);
+
+			return static_cast<uint8_t>(pb <= pc ? b : c);
+		}
+
+		//Every row gets the filter type byte with the smallest sum of absolute residuals, the usual heuristic
+		std::vector<uint8_t> FilterRows(const std::vector<uint8_t>& rgb, int width, int height)
+		{
+			constexpr size_t bytesPerPixel{ 3 };
+			const size_t stride = size_t(width) * bytesPerPixel;
+
+			std::vector<uint8_t> filtered{};
+			filtered.reserve((stride + 1) * height);
+
+			std::vector<uint8_t> candidate(stride);
+			std::vector<uint8_t> best(stride);
+
+			for (int py{}; py < height; ++py)
+			{
+				const uint8_t* pRow = rgb.data() + py * stride;
+				const uint8_t* pAbove = py > 0 ? pRow - stride : nullptr;
+
+				uint8_t bestFilter{};
+				uint32_t bestScore{ UINT32_MAX };
+
+				for (uint8_t filter{}; filter < 5; ++filter)
+				{
+					uint32_t score{};
+					for (size_t x{}; x < stride; ++x)
+					{
+						const int a = x >= bytesPerPixel ? pRow[x - bytesPerPixel] : 0;
+						const int b = pAbove ? pAbove[x] : 0;
+						const int c = pAbove && x >= bytesPerPixel ? pAbove[x - bytesPerPixel] : 0;
+
+						uint8_t predictor{};
+						switch (filter)
+						{
+						case 1: predictor = static_cast<uint8_t>(a); break;
+						case 2: predictor = static_cast<uint8_t>(b); break;
+						case 3: predictor = static_cast<uint8_t>((a + b) / 2); break;
+						case 4: predictor = GetPaethPredictor(a, b, c); break;
+						default: break;
+						}
+
+						candidate[x] = static_cast<uint8_t>(pRow[x] - predictor);
+						score += std::abs(static_cast<int8_t>(candidate[x]));
+					}
+
+					if (score < bestScore)
+					{
+						bestScore = score;
+						bestFilter = filter;
+						std::swap(best, candidate);
+					}
+				}
+
+				filtered.push_back(bestFilter);
+				filtered.insert(filtered.end(), best.begin(), best.end());
+			}
+
+			return filtered;
+		}
+#pragma endregion
+
+		//Rounds to the nearest half, ties to even, overflows to infinity
+		uint16_t FloatToHalf(float value)
+		{
+			uint32_t bits{};
+			memcpy(&bits, &value, sizeof(bits));
+
+			const uint32_t sign = (bits >> 16) & 0x8000;
+			const uint32_t floatExponent = (bits >> 23) & 0xFF;
+			uint32_t mantissa = bits & 0x7FFFFF;
+
+			if (floatExponent == 0xFF)
+				return static_cast<uint16_t>(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+
+			const int exponent = static_cast<int>(floatExponent) - 127 + 15;
+			if (exponent >= 31)
+				return static_cast<uint16_t>(sign | 0x7C00);
+
+			uint32_t half{};
+			uint32_t remainder{};
+			uint32_t halfway{};
+
+			if (exponent <= 0)
+			{
+				//Subnormal half
+				if (exponent < -10)
+					return static_cast<uint16_t>(sign);
+
+				mantissa |= 0x800000;
+				const int shift = 14 - exponent;
+				half = mantissa >> shift;
+				remainder = mantissa & ((1u << shift) - 1);
+				halfway = 1u << (shift - 1);
+			}
+			else
+			{
+				half = (uint32_t(exponent) << 10) | (mantissa >> 13);
+				remainder = mantissa & 0x1FFF;
+				halfway = 0x1000;
+			}
+
+			// a carry out of the mantissa correctly bumps the exponent
+			if (remainder > halfway || (remainder == halfway && (half & 1)))
+				++half;
+
+			return static_cast<uint16_t>(sign | half);
+		}
+	}
+
+	namespace ImageWriter
+	{
+		bool WritePPM(const std::string& filename, const Framebuffer& framebuffer, const FramebufferResolver::Settings& resolveSettings)
+		{
+			std::ofstream file(filename, std::ios::binary);
+			if (!file)
+				return false;
+
+			file << "P6\n" << framebuffer.GetWidth() << " " << framebuffer.GetHeight() << "\n255\n";
+
+			const std::vector<uint8_t> rgb = ResolveRGB8(framebuffer, resolveSettings);
+			file.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+
+			return file.good();
+		}
+
+		bool WritePNG(const std::string& filename, const Framebuffer& framebuffer, const FramebufferResolver::Settings& resolveSettings)
+		{
+			std::ofstream file(filename, std::ios::binary);
+			if (!file)
+				return false;
+
+			const int width = framebuffer.GetWidth();
+			const int height = framebuffer.GetHeight();
+
+			constexpr uint8_t signature[]{ 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+			file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+			//8-bit truecolor, deflate, adaptive filtering, not interlaced
+			std::vector<uint8_t> header{};
+			AppendBigEndian(header, static_cast<uint32_t>(width));
+			AppendBigEndian(header, static_cast<uint32_t>(height));
+			header.insert(header.end(), { 8, 2, 0, 0, 0 });
+
+			WriteChunk(file, "IHDR", header);
+			WriteChunk(file, "IDAT", Deflate(FilterRows(ResolveRGB8(framebuffer, resolveSettings), width, height)));
+			WriteChunk(file, "IEND", {});
+
+			return file.good();
+		}
+
+		bool WritePFM(const std::string& filename, const Framebuffer& framebuffer)
+		{
+			std::ofstream file(filename, std::ios::binary);
+			if (!file)
+				return false;
+
+			static_assert(sizeof(ColorRGB) == 3 * sizeof(float), "ColorRGB rows are written as raw float triplets");
+
+			//Negative scale marks little-endian data, rows are stored bottom to top
+			const int width = framebuffer.GetWidth();
+			const int height = framebuffer.GetHeight();
+			file << "PF\n" << width << " " << height << "\n-1.0\n";
+
+			for (int py{ height - 1 }; py >= 0; --py)
+			{
+				file.write(reinterpret_cast<const char*>(&framebuffer.At(0, py)), sizeof(ColorRGB) * width);
+			}
+
+			return file.good();
+		}
+
+		bool WriteEXR(const std::string& filename, const Framebuffer& framebuffer)
+		{
+			std::ofstream file(filename, std::ios::binary);
+			if (!file)
+				return false;
+
+			const int width = framebuffer.GetWidth();
+			const int height = framebuffer.GetHeight();
+
+			std::vector<uint8_t> header{ 0x76, 0x2F, 0x31, 0x01 };
+			AppendLittleEndian(header, 2u); //version 2, single part scanline file
+
+			const auto appendAttribute = [&](const char* pName, const char* pType, const std::vector<uint8_t>& value)
+				{
+					AppendString(header, pName);
+					AppendString(header, pType);
+					AppendLittleEndian(header, static_cast<uint32_t>(value.size()));
+					header.insert(header.end(), value.begin(), value.end());
+				};
+
+			//Channels are listed, and stored, in alphabetical order
+			std::vector<uint8_t> channels{};
+			for (const char* pChannel : { "B", "G", "R" })
+			{
+				AppendString(channels, pChannel);
+				AppendLittleEndian(channels, 1u); //HALF
+				channels.insert(channels.end(), { 0, 0, 0, 0 }); //pLinear, reserved
+				AppendLittleEndian(channels, 1u); //x sampling
+				AppendLittleEndian(channels, 1u); //y sampling
+			}
+			channels.push_back(0);
+
+			std::vector<uint8_t> window{};
+			for (const uint32_t value : { 0u, 0u, uint32_t(width - 1), uint32_t(height - 1) })
+				AppendLittleEndian(window, value);
+
+			std::vector<uint8_t> one{};
+			AppendLittleEndian(one, 1.f);
+
+			appendAttribute("channels", "chlist", channels);
+			appendAttribute("compression", "compression", { 0 });
+			appendAttribute("dataWindow", "box2i", window);
+			appendAttribute("displayWindow", "box2i", window);
+			appendAttribute("lineOrder", "lineOrder", { 0 }); //increasing y
+			appendAttribute("pixelAspectRatio", "float", one);
+			appendAttribute("screenWindowCenter", "v2f", std::vector<uint8_t>(8, 0));
+			appendAttribute("screenWindowWidth", "float", one);
+			header.push_back(0);
+
+			//One scanline per block: y, byte count, then every channel's row of halves
+			const uint32_t blockDataSize = static_cast<uint32_t>(width) * 3 * sizeof(uint16_t);
+			const uint64_t firstBlockOffset = header.size() + sizeof(uint64_t) * height;
+			for (int py{}; py < height; ++py)
+				AppendLittleEndian(header, firstBlockOffset + uint64_t(py) * (8 + blockDataSize));
+
+			file.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+			std::vector<uint8_t> block{};
+			block.reserve(8 + blockDataSize);
+			for (int py{}; py < height; ++py)
+			{
+				block.clear();
+				AppendLittleEndian(block, static_cast<uint32_t>(py));
+				AppendLittleEndian(block, blockDataSize);
+
+				for (const float ColorRGB::* pChannel : { &ColorRGB::b, &ColorRGB::g, &ColorRGB::r })
+				{
+					for (int px{}; px < width; ++px)
+					{
+						const uint16_t half = FloatToHalf(framebuffer.At(px, py).*pChannel);
+						block.insert(block.end(), { uint8_t(half), uint8_t(half >> 8) });
+					}
+				}
+
+				file.write(reinterpret_cast<const char*>(block.data()), block.size());
+			}
+
+			return file.good();
+		}
+
+		bool Write(const std::string& filename, const Framebuffer& framebuffer, ImageFormat format, const FramebufferResolver::Settings& resolveSettings)
+		{
+			switch (format)
+			{
+			case ImageFormat::PNG:
+				return WritePNG(filename, framebuffer, resolveSettings);
+			case ImageFormat::PFM:
+				return WritePFM(filename, framebuffer);
+			case ImageFormat::EXR:
+				return WriteEXR(filename, framebuffer);
+			default:
+				return WritePPM(filename, framebuffer, resolveSettings);
+			}
+		}
+
+		const char* GetExtension(ImageFormat format)
+		{
+			switch (format)
+			{
+			case ImageFormat::PNG:
+				return "png";
+			case ImageFormat::PFM:
+				return "pfm";
+			case ImageFormat::EXR:
+				return "exr";
+			default:
+				return "ppm";
+			}
+		}
+	}
+}
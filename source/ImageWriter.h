@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+
+#include "FramebufferResolver.h"
+
+namespace dae
+{
+	class Framebuffer;
+
+	enum class ImageFormat
+	{
+		PPM = 0, //8-bit, uncompressed
+		PNG = 1, //8-bit, deflate compressed
+		PFM = 2, //32-bit float, uncompressed
+		EXR = 3 //16-bit half float, uncompressed
+	};
+
+	namespace ImageWriter
+	{
+		/**
+		 * \brief Writes the framebuffer as a binary PPM, tone mapped and quantized to 8 bits per channel
+		 * \return true on success
+		 */
+		bool WritePPM(const std::string& filename, const Framebuffer& framebuffer, const FramebufferResolver::Settings& resolveSettings = {});
+
+		/**
+		 * \brief Writes the framebuffer as an RGB PNG, tone mapped and quantized to 8 bits per channel.
+		 * Rows get the filter with the smallest residual, the stream is deflated with fixed Huffman codes.
+		 * \return true on success
+		 */
+		bool WritePNG(const std::string& filename, const Framebuffer& framebuffer, const FramebufferResolver::Settings& resolveSettings = {});
+
+		/**
+		 * \brief Writes the framebuffer as a little-endian PFM, keeping the full float range
+		 * \return true on success
+		 */
+		bool WritePFM(const std::string& filename, const Framebuffer& framebuffer);
+
+		/**
+		 * \brief Writes the framebuffer as a scanline OpenEXR with half float channels, linear and not tone mapped
+		 * \return true on success
+		 */
+		bool WriteEXR(const std::string& filename, const Framebuffer& framebuffer);
+
+		//Writes with the writer of the given format, the resolve settings only apply to the 8-bit formats
+		bool Write(const std::string& filename, const Framebuffer& framebuffer, ImageFormat format, const FramebufferResolver::Settings& resolveSettings = {});
+
+		const char* GetExtension(ImageFormat format);
+	}
+}
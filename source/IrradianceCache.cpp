@@ -0,0 +1,238 @@
+#include "IrradianceCache.h"
+
+#include "Utils.h"
+
+namespace dae
+{
+	void IrradianceCache::Clear()
+	{
+		m_Records.clear();
+		m_Nodes.clear();
+		m_RootIndex = s_InvalidIndex;
+	}
+
+	bool IrradianceCache::Interpolate(const Vector3& point, const Vector3& normal, ColorRGB& irradiance)
+	{
+		++m_Statistics.queryCount;
+
+		if (m_RootIndex == s_InvalidIndex)
+			return false;
+
+		ColorRGB irradianceSum{};
+		float weightSum{};
+
+		m_Stack.clear();
+		m_Stack.push_back(m_RootIndex);
+
+		while (!m_Stack.empty())
+		{
+			const Node& node = m_Nodes[m_Stack.back()];
+			m_Stack.pop_back();
+
+			// records reach up to halfSize past the node, so the point has to be within twice its half size
+			const Vector3 offset = point - node.center;
+			if (std::max({ fabsf(offset.x), fabsf(offset.y), fabsf(offset.z) }) > 2.f * node.halfSize)
+				continue;
+
+			for (uint32_t recordIndex = node.firstRecord; recordIndex != s_InvalidIndex; recordIndex = m_Records[recordIndex].next)
+			{
+				const Record& record = m_Records[recordIndex];
+				const Vector3 toPoint = point - record.position;
+
+				const float error = toPoint.Magnitude() / record.harmonicMeanDistance + sqrtf(std::max(1.f - Vector3::Dot(normal, record.normal), 0.f));
+				if (error >= m_Settings.maxError)
+					continue;
+
+				// a point below the record's tangent plane may see occluders the record never saw
+				if (Vector3::Dot(toPoint, record.normal + normal) * 0.5f < -s_BehindTolerance)
+					continue;
+
+				// Ward's 1 / error, shifted so records fade out instead of dropping in at the edge of their valid region
+				const float weight = 1.f / std::max(error, 1e-4f) - 1.f / m_Settings.maxError;
+
+				const Vector3 rotationAxis = Vector3::Cross(record.normal, normal);
+				const ColorRGB extrapolated{
+					std::max(record.irradiance.r + Vector3::Dot(rotationAxis, record.rotationGradient[0]) + Vector3::Dot(toPoint, record.translationGradient[0]), 0.f),
+					std::max(record.irradiance.g + Vector3::Dot(rotationAxis, record.rotationGradient[1]) + Vector3::Dot(toPoint, record.translationGradient[1]), 0.f),
+					std::max(record.irradiance.b + Vector3::Dot(rotationAxis, record.rotationGradient[2]) + Vector3::Dot(toPoint, record.translationGradient[2]), 0.f) };
+
+				irradianceSum += weight * extrapolated;
+				weightSum += weight;
+			}
+
+			for (const uint32_t childIndex : node.children)
+			{
+				if (childIndex != s_InvalidIndex)
+				{
+					m_Stack.push_back(childIndex);
+				}
+			}
+		}
+
+		if (weightSum <= 0.f)
+			return false;
+
+		irradiance = (1.f / weightSum) * irradianceSum;
+		++m_Statistics.hitCount;
+		return true;
+	}
+
+	void IrradianceCache::GetTangentFrame(const Vector3& normal, Vector3& tangent, Vector3& bitangent)
+	{
+		LightUtils::GetOrthonormalBasis(normal, tangent, bitangent);
+	}
+
+	uint32_t IrradianceCache::GetOctant(const Vector3& center, const Vector3& point)
+	{
+		return (point.x >= center.x ? 1u : 0u) | (point.y >= center.y ? 2u : 0u) | (point.z >= center.z ? 4u : 0u);
+	}
+
+	ColorRGB IrradianceCache::GetSampledIrradiance(uint32_t thetaCount, uint32_t phiCount) const
+	{
+		// cosine weighted, so every stratum carries pi / sampleCount
+		ColorRGB radianceSum{};
+		for (const ColorRGB& radiance : m_SampleRadiances)
+		{
+			radianceSum += radiance;
+		}
+
+		return (PI / (thetaCount * phiCount)) * radianceSum;
+	}
+
+	void IrradianceCache::InsertRecord(const Vector3& point, const Vector3& normal, const Vector3& tangent, const Vector3& bitangent, uint32_t thetaCount, uint32_t phiCount)
+	{
+		Record record{};
+		record.position = point;
+		record.normal = normal;
+		record.irradiance = GetSampledIrradiance(thetaCount, phiCount);
+
+		// misses add nothing to the sum, a hemisphere that sees nothing gets the largest spacing
+		float inverseDistanceSum{};
+		for (const float distance : m_SampleDistances)
+		{
+			inverseDistanceSum += 1.f / std::max(distance, m_Settings.minSpacing);
+		}
+		const float harmonicMeanDistance = inverseDistanceSum > 0.f ? m_SampleDistances.size() / inverseDistanceSum : m_Settings.maxSpacing;
+		record.harmonicMeanDistance = std::clamp(harmonicMeanDistance, m_Settings.minSpacing, m_Settings.maxSpacing);
+
+		// Ward and Heckbert 1992 for cosine weighted strata, in tangent space. The rotation gradient follows how
+		// tilting the normal reweights each stratum, the translation gradient how the boundaries between neighboring
+		// strata sweep over what they see when the point moves, which depends on how far away that is
+		ColorRGB rotation[2]{};
+		ColorRGB translation[2]{};
+
+		const float stratumWeight = PI / (thetaCount * phiCount);
+		const auto getDistance = [&](uint32_t sampleIndex) { return std::max(m_SampleDistances[sampleIndex], m_Settings.minSpacing); };
+
+		for (uint32_t k{}; k < phiCount; ++k)
+		{
+			const float phiCenter = PI_2 * (k + 0.5f) / phiCount;
+			const float phiEdge = PI_2 * k / phiCount;
+			const uint32_t previousK = (k + phiCount - 1) % phiCount;
+
+			ColorRGB rotationSum{};
+			ColorRGB polarSum{};
+			ColorRGB azimuthSum{};
+
+			for (uint32_t j{}; j < thetaCount; ++j)
+			{
+				const uint32_t sampleIndex = k * thetaCount + j;
+				const ColorRGB& radiance = m_SampleRadiances[sampleIndex];
+
+				const float sinTheta = sqrtf((j + 0.5f) / thetaCount);
+				rotationSum += (-sinTheta / sqrtf(1.f - sinTheta * sinTheta)) * radiance;
+
+				const float sinThetaMinus = sqrtf(float(j) / thetaCount);
+				const float sinThetaPlus = sqrtf(float(j + 1) / thetaCount);
+
+				if (j > 0)
+				{
+					const float cosThetaMinusSqr = 1.f - float(j) / thetaCount;
+					const float distance = std::min(getDistance(sampleIndex), getDistance(sampleIndex - 1));
+					polarSum += (sinThetaMinus * cosThetaMinusSqr / distance) * (radiance - m_SampleRadiances[sampleIndex - 1]);
+				}
+
+				const uint32_t previousIndex = previousK * thetaCount + j;
+				const float distance = std::min(getDistance(sampleIndex), getDistance(previousIndex));
+				azimuthSum += ((sinThetaPlus - sinThetaMinus) / distance) * (radiance - m_SampleRadiances[previousIndex]);
+			}
+
+			// u points along the stratum's azimuth, v across it, vEdge across its first boundary
+			const float u[2]{ cosf(phiCenter), sinf(phiCenter) };
+			const float v[2]{ -sinf(phiCenter), cosf(phiCenter) };
+			const float vEdge[2]{ -sinf(phiEdge), cosf(phiEdge) };
+
+			for (int axis{}; axis < 2; ++axis)
+			{
+				rotation[axis] += (v[axis] * stratumWeight) * rotationSum;
+				translation[axis] += (u[axis] * PI_2 / phiCount) * polarSum + vEdge[axis] * azimuthSum;
+			}
+		}
+
+		record.rotationGradient[0] = tangent * rotation[0].r + bitangent * rotation[1].r;
+		record.rotationGradient[1] = tangent * rotation[0].g + bitangent * rotation[1].g;
+		record.rotationGradient[2] = tangent * rotation[0].b + bitangent * rotation[1].b;
+		record.translationGradient[0] = tangent * translation[0].r + bitangent * translation[1].r;
+		record.translationGradient[1] = tangent * translation[0].g + bitangent * translation[1].g;
+		record.translationGradient[2] = tangent * translation[0].b + bitangent * translation[1].b;
+
+		m_Records.push_back(record);
+		++m_Statistics.recordCount;
+
+		InsertIntoOctree(static_cast<uint32_t>(m_Records.size() - 1), m_Settings.maxError * record.harmonicMeanDistance);
+	}
+
+	void IrradianceCache::InsertIntoOctree(uint32_t recordIndex, float radius)
+	{
+		const Vector3 point = m_Records[recordIndex].position;
+
+		if (m_RootIndex == s_InvalidIndex)
+		{
+			m_Nodes.push_back(Node{ point, radius });
+			m_RootIndex = 0;
+		}
+
+		// the octree has no fixed bounds, the root doubles towards records outside it
+		while (true)
+		{
+			const Vector3 rootCenter = m_Nodes[m_RootIndex].center;
+			const float rootHalfSize = m_Nodes[m_RootIndex].halfSize;
+			const Vector3 offset = point - rootCenter;
+
+			if (std::max({ fabsf(offset.x), fabsf(offset.y), fabsf(offset.z) }) <= rootHalfSize && rootHalfSize >= radius)
+				break;
+
+			Node root{};
+			root.center = rootCenter + Vector3{ offset.x >= 0.f ? rootHalfSize : -rootHalfSize, offset.y >= 0.f ? rootHalfSize : -rootHalfSize, offset.z >= 0.f ? rootHalfSize : -rootHalfSize };
+			root.halfSize = 2.f * rootHalfSize;
+			root.children[GetOctant(root.center, rootCenter)] = m_RootIndex;
+
+			m_RootIndex = static_cast<uint32_t>(m_Nodes.size());
+			m_Nodes.push_back(root);
+		}
+
+		// descend while the children are still as large as the region the record is valid in
+		uint32_t nodeIndex = m_RootIndex;
+		for (uint32_t depth{}; depth < s_MaxDepth; ++depth)
+		{
+			const float childHalfSize = 0.5f * m_Nodes[nodeIndex].halfSize;
+			if (childHalfSize < radius)
+				break;
+
+			const Vector3 center = m_Nodes[nodeIndex].center;
+			const uint32_t octant = GetOctant(center, point);
+
+			if (m_Nodes[nodeIndex].children[octant] == s_InvalidIndex)
+			{
+				const Vector3 childCenter = center + Vector3{ octant & 1u ? childHalfSize : -childHalfSize, octant & 2u ? childHalfSize : -childHalfSize, octant & 4u ? childHalfSize : -childHalfSize };
+				m_Nodes[nodeIndex].children[octant] = static_cast<uint32_t>(m_Nodes.size());
+				m_Nodes.push_back(Node{ childCenter, childHalfSize });
+			}
+
+			nodeIndex = m_Nodes[nodeIndex].children[octant];
+		}
+
+		m_Records[recordIndex].next = m_Nodes[nodeIndex].firstRecord;
+		m_Nodes[nodeIndex].firstRecord = recordIndex;
+	}
+}
@@ -0,0 +1,175 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Math.h"
+
+namespace dae
+{
+	/**
+	 * \brief Irradiance caching (Ward et al. 1988) for diffuse indirect light. A record samples the hemisphere above a
+	 * point once, keeps its irradiance together with rotation and translation gradients (Ward and Heckbert 1992),
+	 * and is reused by every point within maxError times the harmonic mean distance of what its rays hit. The records
+	 * are kept in a loose octree, a record sits in the deepest node at least as large as the region it is valid in.
+	 * Not thread safe, like the occluder cache.
+	 */
+	class IrradianceCache final
+	{
+	public:
+		struct Settings
+		{
+			float maxError{ 0.3f }; //Ward's a, smaller values place more records
+			float minSpacing{ 0.1f }; //clamp of the harmonic mean distance, so corners do not pile up records
+			float maxSpacing{ 4.f }; //and open areas still get a few
+			uint32_t thetaCount{ 8 }; //hemisphere strata along the polar angle, cosine weighted
+			uint32_t phiCount{ 24 }; //and around the normal
+		};
+
+		struct Statistics
+		{
+			size_t queryCount{};
+			size_t hitCount{}; //queries interpolated from existing records
+			size_t recordCount{}; //records added this frame
+
+			float GetHitRate() const { return queryCount > 0 ? hitCount / float(queryCount) : 0.f; }
+		};
+
+		IrradianceCache() = default;
+		~IrradianceCache() = default;
+
+		IrradianceCache(const IrradianceCache&) = delete;
+		IrradianceCache(IrradianceCache&&) noexcept = delete;
+		IrradianceCache& operator=(const IrradianceCache&) = delete;
+		IrradianceCache& operator=(IrradianceCache&&) noexcept = delete;
+
+		void Clear();
+		size_t GetRecordCount() const { return m_Records.size(); }
+
+		//Weighted average of the gradient extrapolated records valid at the point, false when there are none
+		bool Interpolate(const Vector3& point, const Vector3& normal, ColorRGB& irradiance);
+
+		/**
+		 * \brief Samples the hemisphere around the normal, one ray per stratum, without keeping a record. Where the rays
+		 * start is up to traceRadiance
+		 * \param jitter jitter(sampleIndex, u, v) position within the stratum, both in [0, 1)
+		 * \param traceRadiance traceRadiance(direction, distance) radiance arriving from the direction, and the
+		 * distance to what it hit, FLT_MAX on a miss
+		 */
+		template<typename Jitter, typename TraceRadiance>
+		ColorRGB ComputeIrradiance(const Vector3& normal, Jitter&& jitter, TraceRadiance&& traceRadiance);
+
+		//Like ComputeIrradiance, and stores the result as a record with its gradients
+		template<typename Jitter, typename TraceRadiance>
+		ColorRGB AddRecord(const Vector3& point, const Vector3& normal, Jitter&& jitter, TraceRadiance&& traceRadiance);
+
+		Settings& GetSettings() { return m_Settings; }
+		const Statistics& GetStatistics() const { return m_Statistics; }
+		void ResetStatistics() { m_Statistics = {}; }
+
+	private:
+		static constexpr uint32_t s_InvalidIndex{ ~0u };
+		static constexpr uint32_t s_MaxDepth{ 24 }; //below the root a record was added under
+		static constexpr float s_BehindTolerance{ 0.01f }; //points further below a record's tangent plane than this never use it
+
+		struct Record
+		{
+			Vector3 position{};
+			Vector3 normal{};
+			ColorRGB irradiance{};
+			Vector3 rotationGradient[3]{}; //per color channel
+			Vector3 translationGradient[3]{};
+			float harmonicMeanDistance{};
+			uint32_t next{ s_InvalidIndex }; //next record of the same octree node
+		};
+
+		//Loose octree node, holds records centered inside it whose valid region reaches at most halfSize beyond it
+		struct Node
+		{
+			Vector3 center{};
+			float halfSize{};
+			uint32_t children[8]{ s_InvalidIndex, s_InvalidIndex, s_InvalidIndex, s_InvalidIndex, s_InvalidIndex, s_InvalidIndex, s_InvalidIndex, s_InvalidIndex };
+			uint32_t firstRecord{ s_InvalidIndex };
+		};
+
+		Settings m_Settings{};
+		Statistics m_Statistics{};
+
+		std::vector<Record> m_Records{};
+		std::vector<Node> m_Nodes{};
+		uint32_t m_RootIndex{ s_InvalidIndex };
+		std::vector<uint32_t> m_Stack{}; //nodes still to visit, growing the root can make the tree deeper than s_MaxDepth
+
+		//Radiance and hit distance per stratum of the hemisphere being sampled, phi major
+		std::vector<ColorRGB> m_SampleRadiances{};
+		std::vector<float> m_SampleDistances{};
+
+		static void GetTangentFrame(const Vector3& normal, Vector3& tangent, Vector3& bitangent);
+		static uint32_t GetOctant(const Vector3& center, const Vector3& point);
+
+		template<typename Jitter, typename TraceRadiance>
+		void SampleHemisphere(const Vector3& normal, const Vector3& tangent, const Vector3& bitangent, uint32_t thetaCount, uint32_t phiCount,
+			Jitter&& jitter, TraceRadiance&& traceRadiance);
+		ColorRGB GetSampledIrradiance(uint32_t thetaCount, uint32_t phiCount) const;
+		//Turns the sampled hemisphere into a record and files it in the octree
+		void InsertRecord(const Vector3& point, const Vector3& normal, const Vector3& tangent, const Vector3& bitangent, uint32_t thetaCount, uint32_t phiCount);
+		void InsertIntoOctree(uint32_t recordIndex, float radius);
+	};
+
+	template<typename Jitter, typename TraceRadiance>
+	ColorRGB IrradianceCache::ComputeIrradiance(const Vector3& normal, Jitter&& jitter, TraceRadiance&& traceRadiance)
+	{
+		const uint32_t thetaCount = std::max(m_Settings.thetaCount, 1u);
+		const uint32_t phiCount = std::max(m_Settings.phiCount, 1u);
+
+		Vector3 tangent{}, bitangent{};
+		GetTangentFrame(normal, tangent, bitangent);
+		SampleHemisphere(normal, tangent, bitangent, thetaCount, phiCount, jitter, traceRadiance);
+
+		return GetSampledIrradiance(thetaCount, phiCount);
+	}
+
+	template<typename Jitter, typename TraceRadiance>
+	ColorRGB IrradianceCache::AddRecord(const Vector3& point, const Vector3& normal, Jitter&& jitter, TraceRadiance&& traceRadiance)
+	{
+		// the gradients difference neighboring strata, they need at least two of each
+		const uint32_t thetaCount = std::max(m_Settings.thetaCount, 2u);
+		const uint32_t phiCount = std::max(m_Settings.phiCount, 3u);
+
+		Vector3 tangent{}, bitangent{};
+		GetTangentFrame(normal, tangent, bitangent);
+		SampleHemisphere(normal, tangent, bitangent, thetaCount, phiCount, jitter, traceRadiance);
+		InsertRecord(point, normal, tangent, bitangent, thetaCount, phiCount);
+
+		return m_Records.back().irradiance;
+	}
+
+	template<typename Jitter, typename TraceRadiance>
+	void IrradianceCache::SampleHemisphere(const Vector3& normal, const Vector3& tangent, const Vector3& bitangent, uint32_t thetaCount, uint32_t phiCount,
+		Jitter&& jitter, TraceRadiance&& traceRadiance)
+	{
+		m_SampleRadiances.resize(size_t(thetaCount) * phiCount);
+		m_SampleDistances.resize(size_t(thetaCount) * phiCount);
+
+		for (uint32_t k{}; k < phiCount; ++k)
+		{
+			for (uint32_t j{}; j < thetaCount; ++j)
+			{
+				const uint32_t sampleIndex = k * thetaCount + j;
+
+				float u{}, v{};
+				jitter(sampleIndex, u, v);
+
+				// sin^2 of the polar angle is uniform in a cosine weighted hemisphere
+				const float sinTheta = sqrtf((j + u) / thetaCount);
+				const float cosTheta = sqrtf(std::max(1.f - sinTheta * sinTheta, 0.f));
+				const float phi = PI_2 * (k + v) / phiCount;
+
+				const Vector3 direction = (tangent * cosf(phi) + bitangent * sinf(phi)) * sinTheta + normal * cosTheta;
+				m_SampleRadiances[sampleIndex] = traceRadiance(direction, m_SampleDistances[sampleIndex]);
+			}
+		}
+	}
+}
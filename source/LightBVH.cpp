@@ -0,0 +1,378 @@
+#include "LightBVH.h"
+
+#include <algorithm>
+#include <cfloat>
+
+#include "DataTypes.h"
+
+namespace dae
+{
+	namespace
+	{
+		//Largest float below 1, keeps a rescaled random number inside [0, 1)
+		constexpr float OneMinusEpsilon{ 0x1.fffffep-1f };
+
+		float GetHalfArea(const Vector3& boundsMin, const Vector3& boundsMax)
+		{
+			const Vector3 extent = boundsMax - boundsMin;
+			return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+		}
+
+		float GetSquaredDistanceToBounds(const Vector3& point, const Vector3& boundsMin, const Vector3& boundsMax)
+		{
+			const float dx = std::max({ boundsMin.x - point.x, 0.f, point.x - boundsMax.x });
+			const float dy = std::max({ boundsMin.y - point.y, 0.f, point.y - boundsMax.y });
+			const float dz = std::max({ boundsMin.z - point.z, 0.f, point.z - boundsMax.z });
+			return dx * dx + dy * dy + dz * dz;
+		}
+
+		float AngleBetween(const Vector3& a, const Vector3& b)
+		{
+			return acosf(std::clamp(Vector3::Dot(a, b), -1.f, 1.f));
+		}
+	}
+
+	void LightBVH::Build(const std::vector<Light>& lights)
+	{
+		m_Nodes.clear();
+		m_UnboundedLights.clear();
+
+		std::vector<uint32_t> lightIndices{};
+		for (uint32_t i{}; i < lights.size(); ++i)
+		{
+			if (lights[i].type == LightType::Point)
+				lightIndices.push_back(i);
+			else
+				m_UnboundedLights.push_back(i);
+		}
+
+		if (lightIndices.empty())
+			return;
+
+		m_Nodes.reserve(2 * lightIndices.size() - 1);
+		BuildNode(lights, lightIndices, 0, uint32_t(lightIndices.size()), 0);
+
+		// the build leaves every subtree's lights next to each other
+		m_LightOrder = std::move(lightIndices);
+	}
+
+	uint32_t LightBVH::BuildNode(const std::vector<Light>& lights, std::vector<uint32_t>& lightIndices, uint32_t begin, uint32_t end, uint32_t depth)
+	{
+		const uint32_t nodeIndex = uint32_t(m_Nodes.size());
+		m_Nodes.emplace_back();
+
+		Node node{};
+		node.boundsMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+		node.boundsMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		Cone cone{};
+		for (uint32_t i{ begin }; i < end; ++i)
+		{
+			const Light& light = lights[lightIndices[i]];
+			for (int axis{}; axis < 3; ++axis)
+			{
+				node.boundsMin[axis] = std::min(node.boundsMin[axis], light.origin[axis]);
+				node.boundsMax[axis] = std::max(node.boundsMax[axis], light.origin[axis]);
+			}
+
+			node.power += light.intensity * std::max({ light.color.r, light.color.g, light.color.b });
+
+			cone = i == begin ? GetEmissionCone(light) : UnionCones(cone, GetEmissionCone(light));
+		}
+
+		node.firstLight = begin;
+		node.lightCount = end - begin;
+		node.axis = cone.axis;
+		node.cosThetaO = cone.thetaO >= PI ? -1.f : cosf(cone.thetaO);
+
+		if (end - begin == 1)
+		{
+			node.index = lightIndices[begin];
+			node.isLeaf = true;
+			m_Nodes[nodeIndex] = node;
+			return nodeIndex;
+		}
+
+		// split the longest axis of the bounds, the lights are points so they are their own centroids
+		const Vector3 extent = node.boundsMax - node.boundsMin;
+		int splitAxis{ 0 };
+		if (extent.y > extent[splitAxis]) splitAxis = 1;
+		if (extent.z > extent[splitAxis]) splitAxis = 2;
+
+		const auto getPosition = [&](uint32_t lightIndex) { return lights[lightIndex].origin[splitAxis]; };
+		uint32_t middle{ begin + (end - begin) / 2 };
+
+		if (extent[splitAxis] > 0.f && depth < s_MaxDepth)
+		{
+			struct Bin
+			{
+				Vector3 boundsMin{ FLT_MAX, FLT_MAX, FLT_MAX };
+				Vector3 boundsMax{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+				Cone cone{};
+				float power{};
+				uint32_t count{};
+			};
+
+			const auto getBin = [&](uint32_t lightIndex)
+				{
+					const float offset = (getPosition(lightIndex) - node.boundsMin[splitAxis]) / extent[splitAxis];
+					return std::min(uint32_t(offset * s_BinCount), s_BinCount - 1);
+				};
+
+			Bin bins[s_BinCount]{};
+			for (uint32_t i{ begin }; i < end; ++i)
+			{
+				const Light& light = lights[lightIndices[i]];
+				Bin& bin = bins[getBin(lightIndices[i])];
+
+				for (int axis{}; axis < 3; ++axis)
+				{
+					bin.boundsMin[axis] = std::min(bin.boundsMin[axis], light.origin[axis]);
+					bin.boundsMax[axis] = std::max(bin.boundsMax[axis], light.origin[axis]);
+				}
+
+				bin.cone = bin.count == 0 ? GetEmissionCone(light) : UnionCones(bin.cone, GetEmissionCone(light));
+				bin.power += light.intensity * std::max({ light.color.r, light.color.g, light.color.b });
+				++bin.count;
+			}
+
+			// surface area orientation heuristic: a side costs its power times its spatial and directional extent
+			const auto accumulate = [&](Bin& total, const Bin& bin)
+				{
+					if (bin.count == 0)
+						return;
+
+					for (int axis{}; axis < 3; ++axis)
+					{
+						total.boundsMin[axis] = std::min(total.boundsMin[axis], bin.boundsMin[axis]);
+						total.boundsMax[axis] = std::max(total.boundsMax[axis], bin.boundsMax[axis]);
+					}
+
+					total.cone = total.count == 0 ? bin.cone : UnionCones(total.cone, bin.cone);
+					total.power += bin.power;
+					total.count += bin.count;
+				};
+
+			const auto getCost = [](const Bin& side)
+				{
+					return side.power * GetHalfArea(side.boundsMin, side.boundsMax) * GetOrientationMeasure(side.cone);
+				};
+
+			float rightCosts[s_BinCount]{};
+			Bin right{};
+			for (uint32_t split{ s_BinCount - 1 }; split > 0; --split)
+			{
+				accumulate(right, bins[split]);
+				rightCosts[split] = right.count > 0 ? getCost(right) : FLT_MAX;
+			}
+
+			float bestCost{ FLT_MAX };
+			uint32_t bestSplit{};
+			Bin left{};
+			for (uint32_t split{ 1 }; split < s_BinCount; ++split)
+			{
+				accumulate(left, bins[split - 1]);
+				if (left.count == 0 || rightCosts[split] == FLT_MAX)
+					continue;
+
+				const float cost = getCost(left) + rightCosts[split];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestSplit = split;
+				}
+			}
+
+			if (bestSplit > 0)
+			{
+				middle = uint32_t(std::partition(lightIndices.begin() + begin, lightIndices.begin() + end,
+					[&](uint32_t lightIndex) { return getBin(lightIndex) < bestSplit; }) - lightIndices.begin());
+			}
+			else
+			{
+				std::nth_element(lightIndices.begin() + begin, lightIndices.begin() + middle, lightIndices.begin() + end,
+					[&](uint32_t a, uint32_t b) { return getPosition(a) < getPosition(b); });
+			}
+		}
+		else
+		{
+			// lights on one spot, or too deep: halve by count so the depth stays logarithmic
+			std::nth_element(lightIndices.begin() + begin, lightIndices.begin() + middle, lightIndices.begin() + end,
+				[&](uint32_t a, uint32_t b) { return getPosition(a) < getPosition(b); });
+		}
+
+		BuildNode(lights, lightIndices, begin, middle, depth + 1);
+		node.index = BuildNode(lights, lightIndices, middle, end, depth + 1);
+		m_Nodes[nodeIndex] = node;
+
+		return nodeIndex;
+	}
+
+	bool LightBVH::SampleLight(const Vector3& point, const Vector3& normal, float u, uint32_t& lightIndex, float& probability) const
+	{
+		if (m_Nodes.empty())
+			return false;
+
+		probability = 1.f;
+		uint32_t nodeIndex{};
+
+		while (!m_Nodes[nodeIndex].isLeaf)
+		{
+			const uint32_t leftIndex = nodeIndex + 1;
+			const uint32_t rightIndex = m_Nodes[nodeIndex].index;
+
+			const float leftImportance = GetImportance(m_Nodes[leftIndex], point, normal);
+			const float rightImportance = GetImportance(m_Nodes[rightIndex], point, normal);
+			if (leftImportance + rightImportance <= 0.f)
+				return false;
+
+			// reuse the random number: rescale the part of [0, 1) the picked child covers back to [0, 1)
+			const float leftProbability = leftImportance / (leftImportance + rightImportance);
+			if (u < leftProbability)
+			{
+				nodeIndex = leftIndex;
+				u = std::min(u / leftProbability, OneMinusEpsilon);
+				probability *= leftProbability;
+			}
+			else
+			{
+				nodeIndex = rightIndex;
+				u = std::min((u - leftProbability) / (1.f - leftProbability), OneMinusEpsilon);
+				probability *= 1.f - leftProbability;
+			}
+		}
+
+		lightIndex = m_Nodes[nodeIndex].index;
+		return true;
+	}
+
+	float LightBVH::GetContributionBound(const Node& node, const Vector3& point, const Vector3& normal)
+	{
+		float cosine{};
+		if (!GetCosineBound(node, point, normal, cosine))
+			return -1.f;
+
+		const float minDistanceSquared = GetSquaredDistanceToBounds(point, node.boundsMin, node.boundsMax);
+		if (minDistanceSquared <= 0.f)
+			return FLT_MAX;
+
+		return node.power * cosine / minDistanceSquared;
+	}
+
+	int LightBVH::GetPlaneSide(const Node& node, const Vector3& point, const Vector3& normal)
+	{
+		const Vector3 center = (node.boundsMin + node.boundsMax) * 0.5f;
+		const Vector3 halfExtent = (node.boundsMax - node.boundsMin) * 0.5f;
+
+		const float distance = Vector3::Dot(normal, center - point);
+		const float reach = std::abs(normal.x) * halfExtent.x + std::abs(normal.y) * halfExtent.y + std::abs(normal.z) * halfExtent.z;
+
+		if (distance + reach < 0.f)
+			return -1;
+
+		return distance - reach >= 0.f ? 1 : 0;
+	}
+
+	float LightBVH::GetImportance(const Node& node, const Vector3& point, const Vector3& normal)
+	{
+		float cosine{};
+		if (!GetCosineBound(node, point, normal, cosine))
+			return 0.f;
+
+		// the distance to the center, but never closer than the bounds are large, or one near cluster takes every sample
+		const Vector3 center = (node.boundsMin + node.boundsMax) * 0.5f;
+		const float distanceSquared = std::max((center - point).SqrMagnitude(), (node.boundsMax - center).SqrMagnitude());
+		if (distanceSquared <= 0.f)
+			return node.power * cosine;
+
+		return node.power * cosine / distanceSquared;
+	}
+
+	bool LightBVH::GetCosineBound(const Node& node, const Vector3& point, const Vector3& normal, float& cosine)
+	{
+		const Vector3 center = (node.boundsMin + node.boundsMax) * 0.5f;
+		const Vector3 toCenter = center - point;
+		const float distanceSquared = toCenter.SqrMagnitude();
+		const float radiusSquared = (node.boundsMax - center).SqrMagnitude();
+
+		// inside the bounding sphere any direction can lead to a light
+		if (distanceSquared <= radiusSquared)
+		{
+			cosine = 1.f;
+			return true;
+		}
+
+		// half the angle the bounding sphere covers seen from the point
+		const float distance = sqrtf(distanceSquared);
+		const float sinThetaU = sqrtf(radiusSquared) / distance;
+		const float cosThetaU = sqrtf(std::max(0.f, 1.f - sinThetaU * sinThetaU));
+
+		// lights facing away from the point cannot reach it, whatever their position inside the bounds
+		float emissionCosine{ 1.f };
+		if (node.cosThetaO > -1.f)
+		{
+			const float theta = AngleBetween(node.axis, toCenter / -distance);
+			const float thetaPrime = theta - acosf(node.cosThetaO) - asinf(sinThetaU);
+			if (thetaPrime >= PI_DIV_2)
+				return false;
+
+			emissionCosine = thetaPrime > 0.f ? cosf(thetaPrime) : 1.f;
+		}
+
+		// cos(thetaI - thetaU), the angle to the normal shrunk by what the bounds cover
+		const float cosThetaI = Vector3::Dot(normal, toCenter) / distance;
+		float surfaceCosine{ 1.f };
+		if (cosThetaI < cosThetaU)
+		{
+			const float sinThetaI = sqrtf(std::max(0.f, 1.f - cosThetaI * cosThetaI));
+			surfaceCosine = cosThetaI * cosThetaU + sinThetaI * sinThetaU;
+		}
+
+		if (surfaceCosine < 0.f)
+			return false;
+
+		cosine = surfaceCosine * emissionCosine;
+		return true;
+	}
+
+	LightBVH::Cone LightBVH::GetEmissionCone(const Light&)
+	{
+		// point lights emit in every direction
+		return Cone{};
+	}
+
+	LightBVH::Cone LightBVH::UnionCones(const Cone& a, const Cone& b)
+	{
+		// grow the wider cone just enough to cover the other one
+		if (b.thetaO > a.thetaO)
+			return UnionCones(b, a);
+
+		const float thetaD = AngleBetween(a.axis, b.axis);
+		if (std::min(thetaD + b.thetaO, PI) <= a.thetaO)
+			return a;
+
+		const float thetaO = (a.thetaO + thetaD + b.thetaO) / 2;
+		if (thetaO >= PI)
+			return Cone{ a.axis, PI };
+
+		// rotate a's axis towards b's by the amount the cone grew
+		const float thetaR = thetaO - a.thetaO;
+		Vector3 towardsB = b.axis - a.axis * Vector3::Dot(a.axis, b.axis);
+		if (towardsB.SqrMagnitude() <= 0.f)
+			return Cone{ a.axis, thetaO };
+
+		towardsB.Normalize();
+		return Cone{ (a.axis * cosf(thetaR) + towardsB * sinf(thetaR)).Normalized(), thetaO };
+	}
+
+	float LightBVH::GetOrientationMeasure(const Cone& cone)
+	{
+		// solid angle of the emission directions, widened by a cosine falloff over the hemisphere of one sided emitters
+		const float thetaW = std::min(cone.thetaO + PI_DIV_2, PI);
+		const float sinThetaO = sinf(cone.thetaO);
+		const float cosThetaO = cosf(cone.thetaO);
+
+		return PI_2 * (1.f - cosThetaO)
+			+ PI_DIV_2 * (2.f * thetaW * sinThetaO - cosf(cone.thetaO - 2.f * thetaW) - 2.f * cone.thetaO * sinThetaO + cosThetaO);
+	}
+}
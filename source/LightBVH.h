@@ -0,0 +1,142 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Math.h"
+
+namespace dae
+{
+	struct Light;
+
+	/**
+	 * \brief Binary hierarchy over the point lights of a scene (Conty and Kulla 2018). Every node bounds the
+	 * positions, the total power and the emission directions of the lights below it, which gives a cheap upper
+	 * bound and an importance estimate of what a whole cluster adds to a shading point. Lights without a position,
+	 * such as directional lights, are kept aside and always evaluated.
+	 */
+	class LightBVH final
+	{
+	public:
+		LightBVH() = default;
+		~LightBVH() = default;
+
+		LightBVH(const LightBVH&) = delete;
+		LightBVH(LightBVH&&) noexcept = delete;
+		LightBVH& operator=(const LightBVH&) = delete;
+		LightBVH& operator=(LightBVH&&) noexcept = delete;
+
+		void Build(const std::vector<Light>& lights);
+
+		bool IsEmpty() const { return m_Nodes.empty(); }
+		const std::vector<uint32_t>& GetUnboundedLights() const { return m_UnboundedLights; }
+
+		/**
+		 * \brief Calls visit(lightIndex) for every light that may add at least minContribution to the point. A cluster is
+		 * skipped as a whole when the bound of its radiance times cosine falls below it, or when it lies behind the surface.
+		 * A minContribution of 0 only skips lights that add nothing.
+		 */
+		template<typename Visit>
+		void ForEachLight(const Vector3& point, const Vector3& normal, float minContribution, Visit&& visit) const;
+
+		/**
+		 * \brief Walks down the hierarchy picking a child with a probability proportional to its importance
+		 * \param u uniform random number in [0, 1)
+		 * \param lightIndex picked light
+		 * \param probability chance that this light is picked, divide its contribution by it
+		 * \return false when no light can contribute to the point
+		 */
+		bool SampleLight(const Vector3& point, const Vector3& normal, float u, uint32_t& lightIndex, float& probability) const;
+
+	private:
+		static constexpr uint32_t s_MaxDepth{ 64 }; //deeper nodes split at the median so traversal fits a fixed stack
+		static constexpr uint32_t s_StackSize{ 128 };
+		static constexpr uint32_t s_BinCount{ 12 };
+
+		struct Node
+		{
+			Vector3 boundsMin{};
+			Vector3 boundsMax{};
+
+			//Every light below emits within thetaO of the axis, -1 bounds all directions like a point light does
+			Vector3 axis{ 0.f, 0.f, 1.f };
+			float cosThetaO{ -1.f };
+
+			float power{}; //summed intensity times brightest color channel, so radiance <= power / distance^2
+			uint32_t index{}; //leaf: light index, otherwise the second child, the first child directly follows its parent
+			uint32_t firstLight{}; //the lights below the node, a range of m_LightOrder
+			uint32_t lightCount{};
+			bool isLeaf{};
+		};
+
+		struct Cone
+		{
+			Vector3 axis{ 0.f, 0.f, 1.f };
+			float thetaO{ PI };
+		};
+
+		std::vector<Node> m_Nodes{};
+		std::vector<uint32_t> m_LightOrder{}; //light indices in the order of the leaves
+		std::vector<uint32_t> m_UnboundedLights{};
+
+		uint32_t BuildNode(const std::vector<Light>& lights, std::vector<uint32_t>& lightIndices, uint32_t begin, uint32_t end, uint32_t depth);
+
+		//Upper bound of radiance times cosine, the brightest color channel of everything below the node
+		static float GetContributionBound(const Node& node, const Vector3& point, const Vector3& normal);
+		//Which side of the surface's tangent plane the bounds are on, -1 behind, 1 in front, 0 both
+		static int GetPlaneSide(const Node& node, const Vector3& point, const Vector3& normal);
+		//Like the bound, but from the distance to the center, which estimates far clusters better
+		static float GetImportance(const Node& node, const Vector3& point, const Vector3& normal);
+		//Largest cosine between the normal and any direction towards the bounds, times that of the emission cone, false if both miss
+		static bool GetCosineBound(const Node& node, const Vector3& point, const Vector3& normal, float& cosine);
+
+		static Cone GetEmissionCone(const Light& light);
+		static Cone UnionCones(const Cone& a, const Cone& b);
+		static float GetOrientationMeasure(const Cone& cone);
+	};
+
+	template<typename Visit>
+	void LightBVH::ForEachLight(const Vector3& point, const Vector3& normal, float minContribution, Visit&& visit) const
+	{
+		if (m_Nodes.empty())
+			return;
+
+		uint32_t stack[s_StackSize];
+		uint32_t stackSize{};
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const Node& node = m_Nodes[stack[--stackSize]];
+
+			// the plane test is exact and cheap, without a threshold a cluster fully in front needs no further tests
+			const int side = GetPlaneSide(node, point, normal);
+			if (side < 0)
+				continue;
+
+			if (minContribution > 0.f)
+			{
+				const float bound = GetContributionBound(node, point, normal);
+				if (bound < 0.f || bound < minContribution)
+					continue;
+			}
+			else if (side > 0)
+			{
+				for (uint32_t i{ node.firstLight }; i < node.firstLight + node.lightCount; ++i)
+				{
+					visit(m_LightOrder[i]);
+				}
+				continue;
+			}
+
+			if (node.isLeaf)
+			{
+				visit(node.index);
+				continue;
+			}
+
+			const uint32_t nodeIndex = uint32_t(&node - m_Nodes.data());
+			stack[stackSize++] = node.index;
+			stack[stackSize++] = nodeIndex + 1;
+		}
+	}
+}
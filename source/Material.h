@@ -1,125 +1,174 @@
 #pragma once
+#include <cstdint>
+#include <type_traits>
+
 #include "Math.h"
 #include "DataTypes.h"
 #include "BRDFs.h"
 
 namespace dae
 {
-#pragma region Material BASE
-	class Material
+	enum class MaterialType : uint8_t
 	{
-	public:
-		Material() = default;
-		virtual ~Material() = default;
-
-		Material(const Material&) = delete;
-		Material(Material&&) noexcept = delete;
-		Material& operator=(const Material&) = delete;
-		Material& operator=(Material&&) noexcept = delete;
-
-		/**
-		 * \brief Function used to calculate the correct color for the specific material and its parameters
-		 * \param hitRecord current hitrecord
-		 * \param l light direction
-		 * \param v view direction
-		 * \return color
-		 */
-		virtual ColorRGB Shade(const HitRecord& hitRecord = {}, const Vector3& l = {}, const Vector3& v = {}) = 0;
+		SolidColor = 0,
+		Lambert = 1,
+		LambertPhong = 2,
+		CookTorrence = 3,
+		Max = 4
 	};
-#pragma endregion
 
-#pragma region Material SOLID COLOR
-	//SOLID COLOR
-	//===========
-	class Material_SolidColor final : public Material
+#pragma region Material
+	/**
+	 * \brief One entry of the scene's material table: a type tag and the packed parameters of that type.
+	 * Shading switches on the tag instead of calling through a vtable, so the BRDF inlines into the light loop,
+	 * and loops over hits batched by type can pick the branch once with Dispatch and call Shade<type> directly.
+	 */
+	struct Material
 	{
-	public:
-		Material_SolidColor(const ColorRGB& color): m_Color(color)
+		MaterialType type{ MaterialType::SolidColor };
+		ColorRGB color{ colors::White }; //SolidColor: color, Lambert(Phong): diffuse color, CookTorrence: albedo
+		float param0{}; //Lambert(Phong): kd, CookTorrence: metalness
+		float param1{}; //LambertPhong: ks, CookTorrence: roughness [1.0 > 0.0] >> [ROUGH > SMOOTH]
+		float param2{}; //LambertPhong: Phong exponent
+
+		//Derived from the parameters by the factories
+		ColorRGB f0{}; //CookTorrence: reflectance at normal incidence
+		float alphaSquared{}; //CookTorrence: roughness^4 of the GGX distribution
+		float geometryK{}; //CookTorrence: k of the Schlick-GGX geometry term
+
+		static Material SolidColor(const ColorRGB& color)
 		{
+			return { MaterialType::SolidColor, color };
 		}
 
-		ColorRGB Shade(const HitRecord& hitRecord, const Vector3& l, const Vector3& v) override
+		static Material Lambert(const ColorRGB& diffuseColor, float diffuseReflectance)
 		{
-			return m_Color;
+			return { MaterialType::Lambert, diffuseColor, diffuseReflectance };
 		}
 
-	private:
-		ColorRGB m_Color{colors::White};
-	};
-#pragma endregion
+		static Material LambertPhong(const ColorRGB& diffuseColor, float kd, float ks, float phongExponent)
+		{
+			return { MaterialType::LambertPhong, diffuseColor, kd, ks, phongExponent };
+		}
 
-#pragma region Material LAMBERT
-	//LAMBERT
-	//=======
-	class Material_Lambert final : public Material
-	{
-	public:
-		Material_Lambert(const ColorRGB& diffuseColor, float diffuseReflectance) :
-			m_DiffuseColor(diffuseColor), m_DiffuseReflectance(diffuseReflectance){}
+		static Material CookTorrence(const ColorRGB& albedo, float metalness, float roughness)
+		{
+			Material material{ MaterialType::CookTorrence, albedo, metalness, roughness };
+			material.f0 = (metalness < FLT_EPSILON) ? ColorRGB{ 0.04f, 0.04f, 0.04f } : albedo;
+			material.alphaSquared = roughness * roughness * roughness * roughness;
+			material.geometryK = BRDF::Fast::GetGeometryK(roughness);
+			return material;
+		}
 
-		ColorRGB Shade(const HitRecord& hitRecord = {}, const Vector3& l = {}, const Vector3& v = {}) override
+		/**
+		 * \brief Function used to calculate the correct color for the specific material and its parameters
+		 * \param hitRecord current hitrecord
+		 * \param l light direction
+		 * \param v view direction
+		 * \param precision Fast evaluates Cook-Torrance with BRDF::Fast, within its error bounds
+		 * \return color
+		 */
+		ColorRGB Shade(const HitRecord& hitRecord, const Vector3& l, const Vector3& v, BRDF::Precision precision = BRDF::Precision::Exact) const
 		{
-			return BRDF::Lambert(m_DiffuseReflectance, m_DiffuseColor);
+			switch (type)
+			{
+			case MaterialType::Lambert:
+				return Shade<MaterialType::Lambert>(hitRecord, l, v, precision);
+			case MaterialType::LambertPhong:
+				return Shade<MaterialType::LambertPhong>(hitRecord, l, v, precision);
+			case MaterialType::CookTorrence:
+				return Shade<MaterialType::CookTorrence>(hitRecord, l, v, precision);
+			default:
+				return Shade<MaterialType::SolidColor>(hitRecord, l, v, precision);
+			}
 		}
 
-	private:
-		ColorRGB m_DiffuseColor{colors::White};
-		float m_DiffuseReflectance{1.f}; //kd
-	};
-#pragma endregion
+		//Shade for a material known to be of the given type
+		template<MaterialType shadedType>
+		ColorRGB Shade(const HitRecord& hitRecord, const Vector3& l, const Vector3& v, BRDF::Precision precision = BRDF::Precision::Exact) const;
 
-#pragma region Material LAMBERT PHONG
-	//LAMBERT-PHONG
-	//=============
-	class Material_LambertPhong final : public Material
-	{
-	public:
-		Material_LambertPhong(const ColorRGB& diffuseColor, float kd, float ks, float phongExponent):
-			m_DiffuseColor(diffuseColor), m_DiffuseReflectance(kd), m_SpecularReflectance(ks),
-			m_PhongExponent(phongExponent)
+		/**
+		 * \brief Reflectance of the material's Lambert part, what it reflects of diffuse indirect light
+		 * \return black when the material has none
+		 */
+		ColorRGB GetDiffuseAlbedo() const
 		{
+			switch (type)
+			{
+			case MaterialType::Lambert:
+			case MaterialType::LambertPhong:
+				return color * param0;
+			case MaterialType::CookTorrence:
+				//Metals have no diffuse part, the Fresnel term of dielectrics is left out
+				return (param0 < FLT_EPSILON) ? color : ColorRGB{};
+			default:
+				return {};
+			}
 		}
 
-		ColorRGB Shade(const HitRecord& hitRecord = {}, const Vector3& l = {}, const Vector3& v = {}) override
+		//Calls function(std::integral_constant<MaterialType, type>{}) and returns its result
+		template<typename Function>
+		static decltype(auto) Dispatch(MaterialType type, const Function& function)
 		{
-			return BRDF::Lambert(m_DiffuseReflectance, m_DiffuseColor)
-				+ BRDF::Phong(m_SpecularReflectance, m_PhongExponent, l, -v, hitRecord.normal);
+			switch (type)
+			{
+			case MaterialType::Lambert:
+				return function(std::integral_constant<MaterialType, MaterialType::Lambert>{});
+			case MaterialType::LambertPhong:
+				return function(std::integral_constant<MaterialType, MaterialType::LambertPhong>{});
+			case MaterialType::CookTorrence:
+				return function(std::integral_constant<MaterialType, MaterialType::CookTorrence>{});
+			default:
+				return function(std::integral_constant<MaterialType, MaterialType::SolidColor>{});
+			}
 		}
-
-	private:
-		ColorRGB m_DiffuseColor{colors::White};
-		float m_DiffuseReflectance{0.5f}; //kd
-		float m_SpecularReflectance{0.5f}; //ks
-		float m_PhongExponent{1.f}; //Phong Exponent
 	};
-#pragma endregion
 
-#pragma region Material COOK TORRENCE
-	//COOK TORRENCE
-	class Material_CookTorrence final : public Material
+	template<MaterialType shadedType>
+	ColorRGB Material::Shade(const HitRecord& hitRecord, const Vector3& l, const Vector3& v, BRDF::Precision precision) const
 	{
-	public:
-		Material_CookTorrence(const ColorRGB& albedo, float metalness, float roughness):
-			m_Albedo(albedo), m_Metalness(metalness), m_Roughness(roughness)
+		if constexpr (shadedType == MaterialType::Lambert)
 		{
+			return BRDF::Lambert(param0, color);
 		}
+		else if constexpr (shadedType == MaterialType::LambertPhong)
+		{
+			if (precision == BRDF::Precision::Fast)
+			{
+				return BRDF::Lambert(param0, color) + BRDF::Fast::Phong(param1, param2, l, -v, hitRecord.normal);
+			}
 
-		ColorRGB Shade(const HitRecord& hitRecord = {}, const Vector3& l = {}, const Vector3& v = {}) override
+			return BRDF::Lambert(param0, color)
+				+ BRDF::Phong(param1, param2, l, -v, hitRecord.normal);
+		}
+		else if constexpr (shadedType == MaterialType::CookTorrence)
 		{
+			if (precision == BRDF::Precision::Fast)
+			{
+				const Vector3 halfVector = (l - v).Normalized();
+				const ColorRGB fresnel = BRDF::Fast::FresnelFunction_Schlick(halfVector, -v, f0);
+				const ColorRGB kd = (param0 < FLT_EPSILON) ? ColorRGB{ 1,1,1 } - fresnel : ColorRGB{ 0,0,0 };
+
+				const float specular = BRDF::Fast::NormalDistribution_GGX(hitRecord.normal, halfVector, alphaSquared) * BRDF::Fast::GeometryFunction_Smith(hitRecord.normal, -v, l, geometryK)
+					/ (4 * Vector3::Dot(-v, hitRecord.normal) * Vector3::Dot(l, hitRecord.normal));
+				return BRDF::Lambert(kd, color) + specular * fresnel;
+			}
+
+			const float metalness = param0;
+			const float roughness = param1;
+
 			Vector3 halfVector = -v + l;
 			halfVector.Normalize();
 
-			ColorRGB f0 = (m_Metalness < FLT_EPSILON) ? ColorRGB{ 0.04f, 0.04f, 0.04f } : m_Albedo;
 			ColorRGB fresnel = BRDF::FresnelFunction_Schlick(halfVector, -v, f0);
-			ColorRGB kd = (m_Metalness < FLT_EPSILON) ? ColorRGB{ 1,1,1 } - fresnel : ColorRGB{ 0,0,0 };
+			ColorRGB kd = (metalness < FLT_EPSILON) ? ColorRGB{ 1,1,1 } - fresnel : ColorRGB{ 0,0,0 };
 
-			return  BRDF::Lambert(kd, m_Albedo) + (fresnel * BRDF::NormalDistribution_GGX(hitRecord.normal, halfVector, m_Roughness) * BRDF::GeometryFunction_Smith(hitRecord.normal, -v, l, m_Roughness)) / (4 * Vector3::Dot(-v, hitRecord.normal) * Vector3::Dot(l, hitRecord.normal));
+			return  BRDF::Lambert(kd, color) + (fresnel * BRDF::NormalDistribution_GGX(hitRecord.normal, halfVector, roughness) * BRDF::GeometryFunction_Smith(hitRecord.normal, -v, l, roughness)) / (4 * Vector3::Dot(-v, hitRecord.normal) * Vector3::Dot(l, hitRecord.normal));
 		}
-
-	private:
-		ColorRGB m_Albedo{0.955f, 0.637f, 0.538f}; //Copper
-		float m_Metalness{1.0f};
-		float m_Roughness{0.1f}; // [1.0 > 0.0] >> [ROUGH > SMOOTH]
-	};
+		else
+		{
+			return color;
+		}
+	}
 #pragma endregion
 }
@@ -82,6 +82,71 @@ namespace dae {
 		return out;
 	}
 
+	const Matrix& Matrix::Inverse()
+	{
+		//Cofactor expansion using 2x2 sub-determinants of the upper and lower row pairs
+		const Vector4& r0 = data[0];
+		const Vector4& r1 = data[1];
+		const Vector4& r2 = data[2];
+		const Vector4& r3 = data[3];
+
+		const float s0 = r0.x * r1.y - r1.x * r0.y;
+		const float s1 = r0.x * r1.z - r1.x * r0.z;
+		const float s2 = r0.x * r1.w - r1.x * r0.w;
+		const float s3 = r0.y * r1.z - r1.y * r0.z;
+		const float s4 = r0.y * r1.w - r1.y * r0.w;
+		const float s5 = r0.z * r1.w - r1.z * r0.w;
+
+		const float c5 = r2.z * r3.w - r3.z * r2.w;
+		const float c4 = r2.y * r3.w - r3.y * r2.w;
+		const float c3 = r2.y * r3.z - r3.y * r2.z;
+		const float c2 = r2.x * r3.w - r3.x * r2.w;
+		const float c1 = r2.x * r3.z - r3.x * r2.z;
+		const float c0 = r2.x * r3.y - r3.x * r2.y;
+
+		const float determinant = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+		assert(determinant != 0.f && "Matrix is not invertible");
+
+		const float invDet = 1.f / determinant;
+
+		Matrix result{};
+		result[0] = {
+			(r1.y * c5 - r1.z * c4 + r1.w * c3) * invDet,
+			(-r0.y * c5 + r0.z * c4 - r0.w * c3) * invDet,
+			(r3.y * s5 - r3.z * s4 + r3.w * s3) * invDet,
+			(-r2.y * s5 + r2.z * s4 - r2.w * s3) * invDet };
+		result[1] = {
+			(-r1.x * c5 + r1.z * c2 - r1.w * c1) * invDet,
+			(r0.x * c5 - r0.z * c2 + r0.w * c1) * invDet,
+			(-r3.x * s5 + r3.z * s2 - r3.w * s1) * invDet,
+			(r2.x * s5 - r2.z * s2 + r2.w * s1) * invDet };
+		result[2] = {
+			(r1.x * c4 - r1.y * c2 + r1.w * c0) * invDet,
+			(-r0.x * c4 + r0.y * c2 - r0.w * c0) * invDet,
+			(r3.x * s4 - r3.y * s2 + r3.w * s0) * invDet,
+			(-r2.x * s4 + r2.y * s2 - r2.w * s0) * invDet };
+		result[3] = {
+			(-r1.x * c3 + r1.y * c1 - r1.z * c0) * invDet,
+			(r0.x * c3 - r0.y * c1 + r0.z * c0) * invDet,
+			(-r3.x * s3 + r3.y * s1 - r3.z * s0) * invDet,
+			(r2.x * s3 - r2.y * s1 + r2.z * s0) * invDet };
+
+		data[0] = result[0];
+		data[1] = result[1];
+		data[2] = result[2];
+		data[3] = result[3];
+
+		return *this;
+	}
+
+	Matrix Matrix::Inverse(const Matrix& m)
+	{
+		Matrix out{ m };
+		out.Inverse();
+
+		return out;
+	}
+
 	Vector3 Matrix::GetAxisX() const
 	{
 		return data[0];
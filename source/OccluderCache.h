@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace dae
+{
+	/**
+	 * \brief Remembers per light the primitive that blocked the last shadow ray towards it. Neighbouring shading
+	 * points are mostly shadowed by the same primitive, so Scene::GetOcclusionMask tests that one first and only
+	 * traces the whole scene when it misses. Not thread safe, every thread that shades owns its own cache.
+	 */
+	class OccluderCache final
+	{
+	public:
+		enum class PrimitiveType : uint8_t
+		{
+			None = 0,
+			Plane = 1,
+			Sphere = 2,
+			Triangle = 3
+		};
+
+		struct Occluder
+		{
+			PrimitiveType type{ PrimitiveType::None };
+			uint32_t index{}; //plane or sphere index, for a triangle the offset of its first vertex index
+			uint32_t meshIndex{}; //only used by triangles
+		};
+
+		struct Statistics
+		{
+			size_t queryCount{}; //shadow rays that had a cached occluder to test
+			size_t hitCount{}; //of those, the ones the cached occluder blocked
+
+			float GetHitRate() const { return queryCount > 0 ? hitCount / float(queryCount) : 0.f; }
+		};
+
+		OccluderCache() = default;
+		~OccluderCache() = default;
+
+		OccluderCache(const OccluderCache&) = delete;
+		OccluderCache(OccluderCache&&) noexcept = delete;
+		OccluderCache& operator=(const OccluderCache&) = delete;
+		OccluderCache& operator=(OccluderCache&&) noexcept = delete;
+
+		//Keeps the occluders of lights that still exist, so they carry over between frames
+		void Resize(size_t lightCount) { m_Occluders.resize(lightCount); }
+		void Clear() { m_Occluders.assign(m_Occluders.size(), Occluder{}); }
+
+		Occluder& GetOccluder(uint32_t lightIndex) { return m_Occluders[lightIndex]; }
+
+		Statistics& GetStatistics() { return m_Statistics; }
+		const Statistics& GetStatistics() const { return m_Statistics; }
+		void ResetStatistics() { m_Statistics = {}; }
+
+	private:
+		std::vector<Occluder> m_Occluders{};
+		Statistics m_Statistics{};
+	};
+}
@@ -0,0 +1,67 @@
+//External includes
+#include "SDL.h"
+#include "SDL_surface.h"
+
+//Standard includes
+#include <cassert>
+#include <cstring>
+
+//Project includes
+#include "Presenter.h"
+#include "Framebuffer.h"
+
+using namespace dae;
+
+Presenter::Presenter(SDL_Window* pWindow) :
+	m_pWindow(pWindow),
+	m_pBuffer(SDL_GetWindowSurface(pWindow))
+{
+	//Initialize
+	SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
+
+	const SDL_PixelFormat* pFormat = m_pBuffer->format;
+	m_IsPacked8888 = pFormat->BytesPerPixel == 4 && pFormat->Rloss == 0 && pFormat->Gloss == 0 && pFormat->Bloss == 0;
+	if (m_IsPacked8888)
+		m_Format = PackedPixelFormat{ pFormat->Rshift, pFormat->Gshift, pFormat->Bshift, pFormat->Amask };
+}
+
+void Presenter::Resolve(const Framebuffer& framebuffer, std::vector<uint32_t>& pixels)
+{
+	assert(framebuffer.GetWidth() == m_Width && framebuffer.GetHeight() == m_Height && "Framebuffer does not match the window size");
+
+	pixels.resize(size_t(m_Width) * m_Height);
+	m_Resolver.Resolve(framebuffer, m_Format, pixels.data(), m_Width * static_cast<int>(sizeof(uint32_t)));
+}
+
+void Presenter::Flip(const std::vector<uint32_t>& pixels)
+{
+	assert(pixels.size() == size_t(m_Width) * m_Height && "Pixels do not match the window size");
+
+	const SDL_PixelFormat* pFormat = m_pBuffer->format;
+
+	SDL_LockSurface(m_pBuffer);
+
+	for (int py{}; py < m_Height; ++py)
+	{
+		uint8_t* pRow = static_cast<uint8_t*>(m_pBuffer->pixels) + size_t(py) * m_pBuffer->pitch;
+		const uint32_t* pSourceRow = pixels.data() + size_t(py) * m_Width;
+
+		if (m_IsPacked8888)
+		{
+			memcpy(pRow, pSourceRow, size_t(m_Width) * sizeof(uint32_t));
+			continue;
+		}
+
+		for (int px{}; px < m_Width; ++px)
+		{
+			const uint32_t rgb = pSourceRow[px];
+			const uint32_t pixel = SDL_MapRGB(pFormat, rgb & 0xFF, (rgb >> 8) & 0xFF, (rgb >> 16) & 0xFF);
+			memcpy(pRow + px * pFormat->BytesPerPixel, &pixel, pFormat->BytesPerPixel);
+		}
+	}
+
+	SDL_UnlockSurface(m_pBuffer);
+
+	//Update SDL Surface
+	SDL_UpdateWindowSurface(m_pWindow);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "FramebufferResolver.h"
+
+struct SDL_Window;
+struct SDL_Surface;
+
+namespace dae
+{
+	class Framebuffer;
+
+	//Resolves the renderer's float framebuffer into pixels of the SDL window surface's format, and copies those to the window
+	class Presenter final
+	{
+	public:
+		Presenter(SDL_Window* pWindow);
+		~Presenter() = default;
+
+		Presenter(const Presenter&) = delete;
+		Presenter(Presenter&&) noexcept = delete;
+		Presenter& operator=(const Presenter&) = delete;
+		Presenter& operator=(Presenter&&) noexcept = delete;
+
+		//Touches no SDL state, so it can run on any thread. Only one thread may resolve at a time, it uses the resolver
+		void Resolve(const Framebuffer& framebuffer, std::vector<uint32_t>& pixels);
+		//Copies pixels from Resolve to the window, only on the thread that created it like every SDL window call
+		void Flip(const std::vector<uint32_t>& pixels);
+
+		FramebufferResolver& GetResolver() { return m_Resolver; }
+
+		int GetWidth() const { return m_Width; }
+		int GetHeight() const { return m_Height; }
+
+	private:
+		SDL_Window* m_pWindow{};
+
+		SDL_Surface* m_pBuffer{};
+
+		FramebufferResolver m_Resolver{};
+
+		//Read from the surface once, Resolve packs into it
+		PackedPixelFormat m_Format{};
+		bool m_IsPacked8888{}; //Otherwise Resolve packs 8:8:8 and Flip maps every pixel to the surface format
+
+		int m_Width{};
+		int m_Height{};
+	};
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+namespace dae
+{
+	/**
+	 * \brief Stateless counter based random numbers (Philox4x32-10). A number is a pure function of what it is
+	 * used for: pixel, sample index, dimension and frame, so it does not matter which thread draws it or in what
+	 * order, a render gives the same image however its pixels are scheduled.
+	 */
+	namespace Random
+	{
+		//What a random number is drawn for, every field that differs gives an independent stream
+		struct Key
+		{
+			uint32_t px{};
+			uint32_t py{};
+			uint32_t sampleIndex{};
+			uint32_t frameIndex{};
+			uint32_t seed{};
+		};
+
+		//Consumers of random numbers, so no two of them draw the same value for one sample
+		enum class Dimension : uint32_t
+		{
+			PixelJitter = 0, //Sub-pixel position of a camera ray
+			BlueNoiseMask = 1, //Initial points of BlueNoiseSampler's mask
+			LightSelection = 2, //Light picked from the light hierarchy or alias table, and which resampled candidate is kept
+			AreaLight = 3, //Position within a stratum of an area light
+			Hemisphere = 4, //Position within a stratum of the hemisphere an irradiance estimate samples
+			Environment = 5, //Texel of the environment map a shadow ray goes to
+			EnvironmentTexel = 6, //Position within that texel
+			Count
+		};
+
+		//Ten rounds of Philox4x32 (Salmon et al. 2011), four 32 bit outputs per counter
+		inline std::array<uint32_t, 4> Philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key)
+		{
+			constexpr uint32_t multiplier0{ 0xD2511F53 };
+			constexpr uint32_t multiplier1{ 0xCD9E8D57 };
+			constexpr uint32_t keyIncrement0{ 0x9E3779B9 };
+			constexpr uint32_t keyIncrement1{ 0xBB67AE85 };
+
+			for (int round{}; round < 10; ++round)
+			{
+				const uint64_t product0 = uint64_t(multiplier0) * counter[0];
+				const uint64_t product1 = uint64_t(multiplier1) * counter[2];
+
+				counter = {
+					uint32_t(product1 >> 32) ^ counter[1] ^ key[0],
+					uint32_t(product1),
+					uint32_t(product0 >> 32) ^ counter[3] ^ key[1],
+					uint32_t(product0) };
+
+				key[0] += keyIncrement0;
+				key[1] += keyIncrement1;
+			}
+
+			return counter;
+		}
+
+		//Four independent 32 bit numbers for one dimension of a sample
+		inline std::array<uint32_t, 4> GetUints(const Key& key, Dimension dimension)
+		{
+			return Philox4x32({ key.px, key.py, key.sampleIndex, uint32_t(dimension) }, { key.frameIndex, key.seed });
+		}
+
+		//Uniform in [0, 1), the top 24 bits so every value is exactly representable
+		inline float ToFloat(uint32_t value)
+		{
+			return (value >> 8) * (1.f / 16777216.f);
+		}
+
+		inline float GetFloat(const Key& key, Dimension dimension)
+		{
+			return ToFloat(GetUints(key, dimension)[0]);
+		}
+
+		inline void GetFloat2(const Key& key, Dimension dimension, float& u, float& v)
+		{
+			const std::array<uint32_t, 4> values = GetUints(key, dimension);
+			u = ToFloat(values[0]);
+			v = ToFloat(values[1]);
+		}
+	}
+}
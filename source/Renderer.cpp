@@ -1,6 +1,8 @@
-//External includes
-#include "SDL.h"
-#include "SDL_surface.h"
+//Standard includes
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <chrono>
 
 //Project includes
 #include "Renderer.h"
@@ -9,117 +11,1008 @@
 #include "Material.h"
 #include "Scene.h"
 #include "Utils.h"
+#include "WavefrontRenderer.h"
 
 using namespace dae;
 
-Renderer::Renderer(SDL_Window * pWindow) :
-	m_pWindow(pWindow),
-	m_pBuffer(SDL_GetWindowSurface(pWindow))
+Renderer::Renderer(int width, int height) :
+	m_pSampler(Sampler::Create(m_CurrentSamplerType)),
+	m_Framebuffer(width, height),
+	m_Width(width),
+	m_Height(height),
+	m_pWavefrontRenderer(std::make_unique<WavefrontRenderer>())
 {
-	//Initialize
-	SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
-	m_pBufferPixels = static_cast<uint32_t*>(m_pBuffer->pixels);
 }
 
-void Renderer::Render(Scene* pScene) const
+Renderer::~Renderer() = default;
+
+void Renderer::Render(Scene* pScene)
 {
 	Camera& camera = pScene->GetCamera();
-	auto& materials = pScene->GetMaterials();
-	auto& lights = pScene->GetLights();
+	const auto& materials = pScene->GetMaterials();
+
+	pScene->UpdateLights();
+
+	camera.CalculateCameraToWorld();
+	const CameraFrame cameraFrame = camera.GetFrame(m_Width, m_Height);
+
+	m_OccluderCache.Resize(pScene->GetLights().size());
+	m_OccluderCache.ResetStatistics();
+
+	const auto& lights = pScene->GetLights();
+
+	if (pScene->GetGeneration() != m_CachedSceneGeneration || !pScene->IsStatic())
+	{
+		m_VisibilityCache.Clear();
+		m_IrradianceCache.Clear();
+		m_CachedSceneGeneration = pScene->GetGeneration();
+	}
+	m_VisibilityCache.ResetStatistics();
+	m_IrradianceCache.ResetStatistics();
+
+	const size_t areaLightCount = std::count_if(lights.begin(), lights.end(), [](const Light& light) { return LightUtils::IsAreaLight(light); });
+	m_ShadowSampleBudget.BeginFrame(size_t(m_Width) * m_Height * std::max(m_SamplesPerPixel, 1u) * areaLightCount);
+
+	switch (m_CurrentRenderMode)
+	{
+	case dae::Renderer::RenderMode::Adaptive:
+		RenderAdaptive(pScene, materials, cameraFrame);
+		break;
+	case dae::Renderer::RenderMode::Reprojection:
+		RenderReprojected(pScene, materials, cameraFrame);
+		break;
+	case dae::Renderer::RenderMode::DynamicResolution:
+		RenderDynamicResolution(pScene, materials, cameraFrame);
+		break;
+	case dae::Renderer::RenderMode::Checkerboard:
+		RenderCheckerboard(pScene, materials, cameraFrame);
+		break;
+	case dae::Renderer::RenderMode::Wavefront:
+		if (CanRenderWavefront(pScene))
+		{
+			RenderWavefront(pScene, materials, cameraFrame);
+			break;
+		}
+
+		RenderStandard(pScene, materials, cameraFrame);
+		break;
+	case dae::Renderer::RenderMode::Standard:
+	default:
+		RenderStandard(pScene, materials, cameraFrame);
+		break;
+	}
+
+	m_ShadowSampleBudget.EndFrame();
+	++m_FrameIndex;
+}
+
+bool Renderer::CanRenderWavefront(const Scene* pScene) const
+{
+	if (m_IndirectMode != IndirectMode::Off && m_CurrentLightingMode == LightingMode::Combined)
+		return false;
+
+	const auto& lights = pScene->GetLights();
+	if (lights.size() > RayPacket::maxSize && m_LightSettings.selection != LightSelection::All)
+		return false;
+
+	return std::none_of(lights.begin(), lights.end(), [](const Light& light) { return LightUtils::IsAreaLight(light); });
+}
+
+float Renderer::GetResolutionScale() const
+{
+	return m_CurrentRenderMode == RenderMode::DynamicResolution ? m_DynamicResolution.GetScale() : 1.f;
+}
+
+void Renderer::CycleLightingMode()
+{
+	m_CurrentLightingMode = (LightingMode)((int)m_CurrentLightingMode + 1);
+	m_CurrentLightingMode = (LightingMode)((int)m_CurrentLightingMode % (int)LightingMode::Max);
+
+	InvalidateHistory();
+}
+
+void Renderer::CycleRenderMode()
+{
+	m_CurrentRenderMode = (RenderMode)((int)m_CurrentRenderMode + 1);
+	m_CurrentRenderMode = (RenderMode)((int)m_CurrentRenderMode % (int)RenderMode::Max);
+
+	InvalidateHistory();
+}
+
+void Renderer::SetRenderMode(RenderMode renderMode)
+{
+	m_CurrentRenderMode = renderMode;
+	InvalidateHistory();
+}
+
+void Renderer::CycleLightSelection()
+{
+	m_LightSettings.selection = (LightSelection)(((int)m_LightSettings.selection + 1) % (int)LightSelection::Max);
+	InvalidateHistory();
+}
+
+void Renderer::CycleSamplerType()
+{
+	SetSamplerType((SamplerType)(((int)m_CurrentSamplerType + 1) % (int)SamplerType::Max));
+}
+
+void Renderer::SetSamplerType(SamplerType samplerType)
+{
+	m_CurrentSamplerType = samplerType;
+	m_pSampler = Sampler::Create(samplerType);
+	InvalidateHistory();
+}
+
+void Renderer::ToggleShadows()
+{
+	m_ShadowsEnabled = !m_ShadowsEnabled;
+	InvalidateHistory();
+}
 
-	auto aspectRatio = m_Width / float(m_Height);
-	auto FOV = tan(camera.fovAngle / 2);
+void Renderer::ToggleVisibilityCache()
+{
+	m_IsVisibilityCacheEnabled = !m_IsVisibilityCacheEnabled;
+	InvalidateHistory();
+}
 
-	const Matrix cameraToWorld = camera.CalculateCameraToWorld();
+void Renderer::CycleIndirectMode()
+{
+	SetIndirectMode((IndirectMode)(((int)m_IndirectMode + 1) % (int)IndirectMode::Max));
+}
+
+void Renderer::SetIndirectMode(IndirectMode indirectMode)
+{
+	m_IndirectMode = indirectMode;
+	InvalidateHistory();
+}
+
+void Renderer::RenderStandard(const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame)
+{
+	if (m_LightSettings.selection == LightSelection::Tiled)
+	{
+		RenderTiled(pScene, materials, cameraFrame);
+		return;
+	}
+
+	const uint32_t samplesPerPixel = std::max(m_SamplesPerPixel, 1u);
 
 	for (int px{}; px < m_Width; ++px)
 	{
-		double xcs = ((2 * (px + 0.5) / m_Width) - 1) * aspectRatio * FOV;
+		for (int py{}; py < m_Height; ++py)
+		{
+			if (samplesPerPixel == 1)
+			{
+				WritePixel(px, py, RenderSample(pScene, materials, cameraFrame, px + 0.5f, py + 0.5f));
+				continue;
+			}
+
+			ColorRGB color{};
+			for (uint32_t sampleIndex{}; sampleIndex < samplesPerPixel; ++sampleIndex)
+			{
+				float dx{}, dy{};
+				m_pSampler->Get2D({ uint32_t(px), uint32_t(py), sampleIndex, m_FrameIndex }, Random::Dimension::PixelJitter, dx, dy);
+
+				color += RenderSample(pScene, materials, cameraFrame, px + dx, py + dy);
+			}
+
+			WritePixel(px, py, color / float(samplesPerPixel));
+		}
+	}
+
+	m_AverageSamplesPerPixel = float(samplesPerPixel);
+}
+
+void Renderer::RenderTiled(const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame)
+{
+	const uint32_t samplesPerPixel = std::max(m_SamplesPerPixel, 1u);
+	const int tileSize = std::max(m_TileLightCuller.GetSettings().tileSize, 1);
+
+	m_TileLightCuller.ResetStatistics();
+
+	for (int tileX{}; tileX < m_Width; tileX += tileSize)
+	{
+		for (int tileY{}; tileY < m_Height; tileY += tileSize)
+		{
+			const int tileWidth = std::min(tileSize, m_Width - tileX);
+			const int tileHeight = std::min(tileSize, m_Height - tileY);
+
+			// trace the whole tile first, its hits bound the depths the light list has to cover
+			m_TileViewRays.resize(size_t(tileWidth) * tileHeight * samplesPerPixel);
+			m_TileHits.resize(m_TileViewRays.size());
+			float minDepth{ FLT_MAX };
+			float maxDepth{ 0.f };
+
+			for (int px{ tileX }; px < tileX + tileWidth; ++px)
+			{
+				for (int py{ tileY }; py < tileY + tileHeight; ++py)
+				{
+					for (uint32_t sampleIndex{}; sampleIndex < samplesPerPixel; ++sampleIndex)
+					{
+						float dx{ 0.5f }, dy{ 0.5f };
+						if (samplesPerPixel > 1)
+						{
+							m_pSampler->Get2D({ uint32_t(px), uint32_t(py), sampleIndex, m_FrameIndex }, Random::Dimension::PixelJitter, dx, dy);
+						}
+
+						const size_t sampleOffset = ((px - tileX) * tileHeight + (py - tileY)) * samplesPerPixel + sampleIndex;
+						HitRecord& hitRecord = m_TileHits[sampleOffset];
+						m_TileViewRays[sampleOffset] = cameraFrame.GetViewRay(px + dx, py + dy);
+						hitRecord = HitRecord{};
+						pScene->GetClosestHit(m_TileViewRays[sampleOffset], hitRecord);
+
+						if (hitRecord.didHit)
+						{
+							const float depth = cameraFrame.worldToCamera.TransformPoint(hitRecord.origin).z;
+							minDepth = std::min(minDepth, depth);
+							maxDepth = std::max(maxDepth, depth);
+						}
+					}
+				}
+			}
+
+			if (minDepth <= maxDepth)
+			{
+				m_TileLightCuller.BuildLightList(pScene->GetLights(), cameraFrame, tileX, tileY, tileWidth, tileHeight, minDepth, maxDepth);
+			}
+
+			for (int px{ tileX }; px < tileX + tileWidth; ++px)
+			{
+				for (int py{ tileY }; py < tileY + tileHeight; ++py)
+				{
+					ColorRGB color{};
+					for (uint32_t sampleIndex{}; sampleIndex < samplesPerPixel; ++sampleIndex)
+					{
+						const size_t sampleOffset = ((px - tileX) * tileHeight + (py - tileY)) * samplesPerPixel + sampleIndex;
+
+						// no hit, the environment shows through
+						if (m_TileHits[sampleOffset].didHit)
+						{
+							color += Shade(pScene, materials, m_TileViewRays[sampleOffset], m_TileHits[sampleOffset], &m_TileLightCuller.GetLightList());
+						}
+						else
+						{
+							color += pScene->GetEnvironment().GetRadiance(m_TileViewRays[sampleOffset].direction);
+						}
+					}
+
+					WritePixel(px, py, samplesPerPixel == 1 ? color : color / float(samplesPerPixel));
+				}
+			}
+		}
+	}
+
+	m_AverageSamplesPerPixel = float(samplesPerPixel);
+}
+
+void Renderer::RenderAdaptive(const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame)
+{
+	m_AdaptiveSampler.BeginFrame(m_Width, m_Height);
+
+	// keep adding passes until every tile fell under the noise threshold (or hit the sample cap)
+	while (!m_AdaptiveSampler.IsFrameConverged())
+	{
+		for (const AdaptiveSampler::Tile& tile : m_AdaptiveSampler.GetTiles())
+		{
+			if (tile.isConverged)
+				continue;
+
+			const uint32_t sampleCount = m_AdaptiveSampler.GetSamplesThisPass(tile);
+
+			for (int py{ tile.y }; py < tile.y + tile.height; ++py)
+			{
+				for (int px{ tile.x }; px < tile.x + tile.width; ++px)
+				{
+					for (uint32_t sampleIndex{ tile.sampleCount }; sampleIndex < tile.sampleCount + sampleCount; ++sampleIndex)
+					{
+						float dx{}, dy{};
+						m_pSampler->Get2D({ uint32_t(px), uint32_t(py), sampleIndex, m_FrameIndex }, Random::Dimension::PixelJitter, dx, dy);
 
+						m_AdaptiveSampler.AddSample(px, py, RenderSample(pScene, materials, cameraFrame, px + dx, py + dy));
+					}
+				}
+			}
+		}
+
+		m_AdaptiveSampler.EndPass();
+	}
+
+	for (int px{}; px < m_Width; ++px)
+	{
 		for (int py{}; py < m_Height; ++py)
 		{
-			double ycs = (1 - (2 * (py + 0.5) / m_Height)) * FOV;
+			WritePixel(px, py, m_AdaptiveSampler.GetMean(px, py));
+		}
+	}
 
-			auto rayDirection = cameraToWorld.TransformVector(xcs * Vector3::UnitX + ycs * Vector3::UnitY + Vector3::UnitZ);
-			Ray viewRay{ camera.origin, rayDirection.Normalized() };
+	m_AverageSamplesPerPixel = m_AdaptiveSampler.GetAverageSamplesPerPixel();
+}
 
-			HitRecord closestHit{};
-			ColorRGB finalColor{};
+void Renderer::RenderReprojected(const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame)
+{
+	m_ReprojectionCache.BeginFrame(cameraFrame);
+	const ReprojectionCache::Settings& settings = m_ReprojectionCache.GetSettings();
 
-			pScene->GetClosestHit(viewRay, closestHit);
+	for (int px{}; px < m_Width; ++px)
+	{
+		for (int py{}; py < m_Height; ++py)
+		{
+			const GBufferTexel* pCachedTexel = m_ReprojectionCache.GetReprojectedTexel(px, py);
+			GBufferTexel texel{};
 
-			// no hit, color black
-			if (!closestHit.didHit)
+			if (pCachedTexel)
 			{
-				m_pBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBuffer->format,
-					static_cast<uint8_t>(finalColor.r * 255),
-					static_cast<uint8_t>(finalColor.g * 255),
-					static_cast<uint8_t>(finalColor.b * 255));
+				texel = *pCachedTexel;
+				++texel.age;
+
+				// the hit is still valid, but view dependent shading needs refreshing once the view vector drifted
+				const Vector3 viewDirection = (texel.position - cameraFrame.origin).Normalized();
+				if (Vector3::Dot(viewDirection, texel.viewDirection) < settings.minViewCosine)
+				{
+					const Ray viewRay{ cameraFrame.origin, viewDirection };
+					const HitRecord hitRecord{ texel.position, texel.normal, texel.depth, true, texel.materialIndex };
+
+					texel.color = Shade(pScene, materials, viewRay, hitRecord);
+					texel.viewDirection = viewDirection;
+				}
+			}
+			else
+			{
+				TracePixel(pScene, materials, cameraFrame, px, py, texel);
+				texel.age = m_ReprojectionCache.GetInitialAge(px, py);
+			}
+
+			m_ReprojectionCache.Store(px, py, texel);
+			WritePixel(px, py, texel.color);
+		}
+	}
+
+	m_ReprojectionCache.EndFrame();
+	m_AverageSamplesPerPixel = 1.f;
+}
+
+void Renderer::RenderDynamicResolution(const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame)
+{
+	const auto startTime = std::chrono::steady_clock::now();
+
+	// the scaled frame keeps the window's aspect ratio, only the pixel grid shrinks
+	CameraFrame scaledFrame = cameraFrame;
+	scaledFrame.width = std::max(static_cast<int>(m_Width * m_DynamicResolution.GetScale() + 0.5f), 1);
+	scaledFrame.height = std::max(static_cast<int>(m_Height * m_DynamicResolution.GetScale() + 0.5f), 1);
+
+	m_ScaledBuffer.resize(size_t(scaledFrame.width) * scaledFrame.height);
+
+	for (int px{}; px < scaledFrame.width; ++px)
+	{
+		for (int py{}; py < scaledFrame.height; ++py)
+		{
+			m_ScaledBuffer[px + (py * scaledFrame.width)] = RenderSample(pScene, materials, scaledFrame, px + 0.5f, py + 0.5f);
+		}
+	}
+
+	const auto upscaleStartTime = std::chrono::steady_clock::now();
+	const float renderTime = std::chrono::duration<float>(upscaleStartTime - startTime).count();
+
+	// bilinear upscale into the framebuffer
+	const float scaleX = scaledFrame.width / float(m_Width);
+	const float scaleY = scaledFrame.height / float(m_Height);
+
+	for (int py{}; py < m_Height; ++py)
+	{
+		const float sy = std::clamp((py + 0.5f) * scaleY - 0.5f, 0.f, float(scaledFrame.height - 1));
+		const int y0 = static_cast<int>(sy);
+		const int y1 = std::min(y0 + 1, scaledFrame.height - 1);
+		const float fy = sy - y0;
+
+		for (int px{}; px < m_Width; ++px)
+		{
+			const float sx = std::clamp((px + 0.5f) * scaleX - 0.5f, 0.f, float(scaledFrame.width - 1));
+			const int x0 = static_cast<int>(sx);
+			const int x1 = std::min(x0 + 1, scaledFrame.width - 1);
+			const float fx = sx - x0;
+
+			const ColorRGB top = ColorRGB::Lerp(m_ScaledBuffer[x0 + (y0 * scaledFrame.width)], m_ScaledBuffer[x1 + (y0 * scaledFrame.width)], fx);
+			const ColorRGB bottom = ColorRGB::Lerp(m_ScaledBuffer[x0 + (y1 * scaledFrame.width)], m_ScaledBuffer[x1 + (y1 * scaledFrame.width)], fx);
+
+			WritePixel(px, py, ColorRGB::Lerp(top, bottom, fy));
+		}
+	}
+
+	// the upscale is part of the frame too, at small scales it is a good share of it
+	const float upscaleTime = std::chrono::duration<float>(std::chrono::steady_clock::now() - upscaleStartTime).count();
+	m_DynamicResolution.Update(renderTime, upscaleTime, scaledFrame.width * scaledFrame.height, m_Width * m_Height);
+
+	m_AverageSamplesPerPixel = 1.f;
+}
+
+void Renderer::RenderCheckerboard(const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame)
+{
+	m_CheckerboardResolver.BeginFrame(m_Width, m_Height);
 
+	// trace this frame's half of the checkerboard
+	for (int px{}; px < m_Width; ++px)
+	{
+		for (int py{}; py < m_Height; ++py)
+		{
+			if (!m_CheckerboardResolver.IsTracedThisFrame(px, py))
 				continue;
+
+			GBufferTexel& texel = m_CheckerboardResolver.At(px, py);
+			TracePixel(pScene, materials, cameraFrame, px, py, texel);
+
+			WritePixel(px, py, texel.color);
+		}
+	}
+
+	// reconstruct the other half from last frame and the freshly traced neighbors
+	for (int px{}; px < m_Width; ++px)
+	{
+		for (int py{}; py < m_Height; ++py)
+		{
+			if (m_CheckerboardResolver.IsTracedThisFrame(px, py))
+				continue;
+
+			WritePixel(px, py, m_CheckerboardResolver.Reconstruct(px, py, cameraFrame));
+		}
+	}
+
+	m_CheckerboardResolver.EndFrame();
+	m_AverageSamplesPerPixel = 0.5f;
+}
+
+void Renderer::RenderWavefront(const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame)
+{
+	m_pWavefrontRenderer->Render(*this, pScene, materials, cameraFrame, m_CurrentLightingMode, m_BRDFPrecision, m_ShadowsEnabled, m_Framebuffer);
+	m_AverageSamplesPerPixel = 1.f;
+}
+
+ColorRGB Renderer::RenderSample(const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame, float x, float y) const
+{
+	const Ray viewRay = cameraFrame.GetViewRay(x, y);
+
+	HitRecord closestHit{};
+	pScene->GetClosestHit(viewRay, closestHit);
+
+	// no hit, the environment shows through
+	if (!closestHit.didHit)
+		return pScene->GetEnvironment().GetRadiance(viewRay.direction);
+
+	return Shade(pScene, materials, viewRay, closestHit);
+}
+
+void Renderer::TracePixel(const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame, int px, int py, GBufferTexel& texel) const
+{
+	const Ray viewRay = cameraFrame.GetViewRay(px + 0.5f, py + 0.5f);
+
+	HitRecord closestHit{};
+	pScene->GetClosestHit(viewRay, closestHit);
+
+	texel = GBufferTexel{};
+	texel.viewDirection = viewRay.direction;
+
+	if (!closestHit.didHit)
+	{
+		texel.color = pScene->GetEnvironment().GetRadiance(viewRay.direction);
+		return;
+	}
+
+	float x{}, y{};
+	cameraFrame.Project(closestHit.origin, x, y, texel.depth);
+
+	texel.position = closestHit.origin;
+	texel.normal = closestHit.normal;
+	texel.materialIndex = closestHit.materialIndex;
+	texel.didHit = true;
+	texel.color = Shade(pScene, materials, viewRay, closestHit);
+}
+
+ColorRGB Renderer::Shade(const Scene* pScene, const std::vector<Material>& materials, const Ray& viewRay, const HitRecord& hitRecord,
+	const std::vector<uint32_t>* pLightList, bool isPrimaryHit) const
+{
+	ColorRGB finalColor{};
+	const auto& lights = pScene->GetLights();
+	const LightBVH& lightBVH = pScene->GetLightBVH();
+
+	// the shadow rays of all lights leave the same point, so they are traced together, a packet at a time
+	RayPacket shadowRays;
+	shadowRays.origin = hitRecord.origin + hitRecord.normal * 0.1f;
+	shadowRays.count = 0;
+	const Light* pPacketLights[RayPacket::maxSize];
+	float cosines[RayPacket::maxSize];
+	float weights[RayPacket::maxSize];
+
+	VisibilityCache* pVisibilityCache = m_IsVisibilityCacheEnabled && m_ShadowsEnabled && pScene->IsStatic() ? &m_VisibilityCache : nullptr;
+
+	const auto addContribution = [&](const Light& light, const Vector3& direction, float cosine, float weight)
+		{
+			auto radiance = LightUtils::GetRadiance(light, hitRecord.origin);
+			finalColor += GetLightContribution(m_CurrentLightingMode, materials[hitRecord.materialIndex], hitRecord, direction, viewRay.direction, radiance, cosine, m_BRDFPrecision) * weight;
+		};
+
+	const auto traceShadowRays = [&]
+		{
+			// obstacle in way, light does not give direct hit, also results in giving shadows
+			const uint32_t occlusionMask = m_ShadowsEnabled ? pScene->GetOcclusionMask(shadowRays, m_IsOccluderCacheEnabled ? &m_OccluderCache : nullptr) : 0;
+
+			for (uint32_t i = 0; i < shadowRays.count; ++i)
+			{
+				if (pVisibilityCache)
+				{
+					pVisibilityCache->Record(hitRecord.origin, shadowRays.lightIndex[i], occlusionMask & (1u << i));
+				}
+
+				if (occlusionMask & (1u << i))
+				{
+					continue;
+				}
+
+				addContribution(*pPacketLights[i], { shadowRays.directionX[i], shadowRays.directionY[i], shadowRays.directionZ[i] }, cosines[i], weights[i]);
+			}
+
+			shadowRays.count = 0;
+		};
+
+	const auto addLight = [&](uint32_t lightIndex, float weight)
+		{
+			// area lights trace their own shadow rays, how many depends on what the first ones see
+			if (LightUtils::IsAreaLight(lights[lightIndex]))
+			{
+				finalColor += ShadeAreaLight(pScene, materials[hitRecord.materialIndex], viewRay, hitRecord, lightIndex, isPrimaryHit) * weight;
+				return;
+			}
+
+			auto direction = LightUtils::GetDirectionToLight(lights[lightIndex], hitRecord.origin);
+			const float distance = direction.Normalize();
+
+			// out of the light's reach, it gives no radiance here
+			if (lights[lightIndex].influenceRadius > 0.f && distance > lights[lightIndex].influenceRadius)
+			{
+				return;
+			}
+
+			// light behind or edge on to the surface gives nothing, no need to trace its shadow ray.
+			// Cook-Torrance divides by this cosine, at exactly 0 it would add NaN
+			auto dot = Vector3::Dot(hitRecord.normal, direction);
+			if (dot <= 0)
+			{
+				return;
+			}
+
+			if (pVisibilityCache)
+			{
+				const VisibilityCache::Visibility visibility = pVisibilityCache->Lookup(hitRecord.origin, lightIndex);
+				if (visibility == VisibilityCache::Visibility::Occluded)
+				{
+					return;
+				}
+
+				if (visibility == VisibilityCache::Visibility::Visible)
+				{
+					addContribution(lights[lightIndex], direction, dot, weight);
+					return;
+				}
+			}
+
+			shadowRays.directionX[shadowRays.count] = direction.x;
+			shadowRays.directionY[shadowRays.count] = direction.y;
+			shadowRays.directionZ[shadowRays.count] = direction.z;
+			shadowRays.max[shadowRays.count] = distance;
+			shadowRays.lightIndex[shadowRays.count] = lightIndex;
+			pPacketLights[shadowRays.count] = &lights[lightIndex];
+			cosines[shadowRays.count] = dot;
+			weights[shadowRays.count] = weight;
+
+			if (++shadowRays.count == RayPacket::maxSize)
+			{
+				traceShadowRays();
+			}
+		};
+
+	// a single packet covers a handful of lights, the hierarchy only pays off beyond that
+	const LightSelection lightSelection = lights.size() > RayPacket::maxSize ? m_LightSettings.selection : LightSelection::All;
+
+	if (pLightList)
+	{
+		for (const uint32_t lightIndex : *pLightList)
+		{
+			addLight(lightIndex, 1.f);
+		}
+	}
+	else if (lightSelection == LightSelection::Sampled && !lightBVH.IsEmpty())
+	{
+		// keyed by the hit position, so the same point picks the same lights on every thread and in every mode
+		const Random::Key key{ std::bit_cast<uint32_t>(hitRecord.origin.x), std::bit_cast<uint32_t>(hitRecord.origin.y), 0, m_FrameIndex, std::bit_cast<uint32_t>(hitRecord.origin.z) };
+		const uint32_t sampleCount = std::max(m_LightSettings.sampleCount, 1u);
+
+		for (uint32_t sampleIndex{}; sampleIndex < sampleCount; ++sampleIndex)
+		{
+			Random::Key sampleKey{ key };
+			sampleKey.sampleIndex = sampleIndex;
+
+			float u{}, v{};
+			m_pSampler->Get2D(sampleKey, Random::Dimension::LightSelection, u, v);
+
+			uint32_t lightIndex{};
+			float probability{};
+			if (lightBVH.SampleLight(hitRecord.origin, hitRecord.normal, u, lightIndex, probability))
+			{
+				addLight(lightIndex, 1.f / (sampleCount * probability));
 			}
+		}
 
-			auto lights = pScene->GetLights();
+		for (const uint32_t lightIndex : lightBVH.GetUnboundedLights())
+		{
+			addLight(lightIndex, 1.f);
+		}
+	}
+	else if (lightSelection == LightSelection::Power && !pScene->GetLightAliasTable().IsEmpty())
+	{
+		const AliasTable& aliasTable = pScene->GetLightAliasTable();
+		const Random::Key key{ std::bit_cast<uint32_t>(hitRecord.origin.x), std::bit_cast<uint32_t>(hitRecord.origin.y), 0, m_FrameIndex, std::bit_cast<uint32_t>(hitRecord.origin.z) };
+		const uint32_t sampleCount = std::max(m_LightSettings.sampleCount, 1u);
+		const uint32_t candidateCount = std::max(m_LightSettings.candidateCount, 1u);
+
+		// the table only knows power, resampling its candidates by their unshadowed radiance times cosine
+		// brings in the distance, the kept light is weighted by the mean candidate weight over its own
+		for (uint32_t sampleIndex{}; sampleIndex < sampleCount; ++sampleIndex)
+		{
+			uint32_t pickedLightIndex{};
+			float pickedTarget{};
+			float weightSum{};
 
-			for (size_t i = 0; i < lights.size(); i++)
+			for (uint32_t candidateIndex{}; candidateIndex < candidateCount; ++candidateIndex)
 			{
-				auto direction = LightUtils::GetDirectionToLight(lights[i], closestHit.origin).Normalized();
+				Random::Key sampleKey{ key };
+				sampleKey.sampleIndex = sampleIndex * candidateCount + candidateIndex;
 
-				// obstacle in way, light does not give direct hit, also results in giving shadows
-				if (m_ShadowsEnabled && pScene->DoesHit({ closestHit.origin + closestHit.normal * 0.1f, direction.Normalized(), 0.0001f, direction.Magnitude() }))
+				float u{}, v{};
+				m_pSampler->Get2D(sampleKey, Random::Dimension::LightSelection, u, v);
+
+				float probability{};
+				const uint32_t lightIndex = aliasTable.Sample(u, probability);
+
+				auto direction = LightUtils::GetDirectionToLight(lights[lightIndex], hitRecord.origin);
+				direction.Normalize();
+				const float dot = Vector3::Dot(hitRecord.normal, direction);
+				if (dot <= 0)
 				{
 					continue;
 				}
 
-				auto dot = Vector3::Dot(closestHit.normal, direction);
+				const ColorRGB radiance = LightUtils::GetRadiance(lights[lightIndex], hitRecord.origin);
+				const float target = std::max({ radiance.r, radiance.g, radiance.b }) * dot;
+				const float weight = target / probability;
+				weightSum += weight;
 
-				if (dot < 0)
+				if (v * weightSum < weight)
+				{
+					pickedLightIndex = lightIndex;
+					pickedTarget = target;
+				}
+			}
+
+			if (weightSum > 0.f)
+			{
+				addLight(pickedLightIndex, weightSum / (candidateCount * sampleCount * pickedTarget));
+			}
+		}
+
+		for (const uint32_t lightIndex : lightBVH.GetUnboundedLights())
+		{
+			addLight(lightIndex, 1.f);
+		}
+	}
+	else if (lightSelection == LightSelection::Culled && !lightBVH.IsEmpty())
+	{
+		lightBVH.ForEachLight(hitRecord.origin, hitRecord.normal, m_LightSettings.minContribution, [&](uint32_t lightIndex) { addLight(lightIndex, 1.f); });
+
+		for (const uint32_t lightIndex : lightBVH.GetUnboundedLights())
+		{
+			addLight(lightIndex, 1.f);
+		}
+	}
+	else
+	{
+		for (uint32_t lightIndex = 0; lightIndex < lights.size(); ++lightIndex)
+		{
+			addLight(lightIndex, 1.f);
+		}
+	}
+
+	if (shadowRays.count > 0)
+	{
+		traceShadowRays();
+	}
+
+	// like indirect light, the environment only lights the final image, the other lighting modes show single lights
+	if (!pScene->GetEnvironment().IsEmpty() && m_CurrentLightingMode == LightingMode::Combined)
+	{
+		finalColor += ShadeEnvironment(pScene, materials[hitRecord.materialIndex], viewRay, hitRecord);
+	}
+
+	if (isPrimaryHit && m_IndirectMode != IndirectMode::Off && m_CurrentLightingMode == LightingMode::Combined)
+	{
+		// Lambert BRDF times irradiance
+		const ColorRGB albedo = materials[hitRecord.materialIndex].GetDiffuseAlbedo();
+		if (albedo.r > 0.f || albedo.g > 0.f || albedo.b > 0.f)
+		{
+			finalColor += (1.f / PI) * (albedo * GetIndirectIrradiance(pScene, materials, hitRecord));
+		}
+	}
+
+	return finalColor;
+}
+
+ColorRGB Renderer::GetIndirectIrradiance(const Scene* pScene, const std::vector<Material>& materials, const HitRecord& hitRecord) const
+{
+	// keyed by the hit position like light selection, a record's hemisphere does not depend on the pixel that placed it
+	const Random::Key key{ std::bit_cast<uint32_t>(hitRecord.origin.x), std::bit_cast<uint32_t>(hitRecord.origin.y), 0, m_FrameIndex, std::bit_cast<uint32_t>(hitRecord.origin.z) };
+
+	const Vector3 origin = hitRecord.origin + hitRecord.normal * 0.1f;
+
+	const auto jitter = [&](uint32_t sampleIndex, float& u, float& v)
+		{
+			Random::Key sampleKey{ key };
+			sampleKey.sampleIndex = sampleIndex;
+			m_pSampler->Get2D(sampleKey, Random::Dimension::Hemisphere, u, v);
+		};
+
+	const auto traceRadiance = [&](const Vector3& direction, float& distance)
+		{
+			const Ray ray{ origin, direction };
+			HitRecord closestHit{};
+			pScene->GetClosestHit(ray, closestHit);
+
+			// the sky is already direct light, see ShadeEnvironment, indirect light only carries what bounced off the scene
+			if (!closestHit.didHit)
+			{
+				distance = FLT_MAX;
+				return ColorRGB{};
+			}
+
+			// surfaces seen edge on or from behind send nothing back, the BRDFs divide by the cosine to the viewer
+			distance = closestHit.t;
+			if (Vector3::Dot(closestHit.normal, direction) >= 0.f)
+			{
+				return ColorRGB{};
+			}
+
+			return Shade(pScene, materials, ray, closestHit, nullptr, false);
+		};
+
+	if (m_IndirectMode == IndirectMode::Sampled)
+	{
+		return m_IrradianceCache.ComputeIrradiance(hitRecord.normal, jitter, traceRadiance);
+	}
+
+	ColorRGB irradiance{};
+	if (m_IrradianceCache.Interpolate(hitRecord.origin, hitRecord.normal, irradiance))
+	{
+		return irradiance;
+	}
+
+	return m_IrradianceCache.AddRecord(hitRecord.origin, hitRecord.normal, jitter, traceRadiance);
+}
+
+ColorRGB Renderer::ShadeAreaLight(const Scene* pScene, const Material& material, const Ray& viewRay, const HitRecord& hitRecord, uint32_t lightIndex, bool isPrimaryHit) const
+{
+	const Light& light = pScene->GetLights()[lightIndex];
+	const ColorRGB emittedRadiance = light.color * light.intensity;
+
+	// keyed by the hit position like light selection, each light draws its own sequence
+	const Random::Key key{ std::bit_cast<uint32_t>(hitRecord.origin.x), std::bit_cast<uint32_t>(hitRecord.origin.y), 0, m_FrameIndex,
+		std::bit_cast<uint32_t>(hitRecord.origin.z) ^ (lightIndex * 0x9E3779B9u) };
+
+	RayPacket shadowRays;
+	shadowRays.origin = hitRecord.origin + hitRecord.normal * 0.1f;
+	shadowRays.count = 0;
+	ColorRGB radiances[RayPacket::maxSize];
+	float cosines[RayPacket::maxSize];
+
+	ColorRGB color{};
+	uint32_t sampleCount{};
+	uint32_t tracedCount{};
+	uint32_t visibleCount{};
+
+	const auto traceShadowRays = [&]
+		{
+			const uint32_t occlusionMask = m_ShadowsEnabled ? pScene->GetOcclusionMask(shadowRays, m_IsOccluderCacheEnabled ? &m_OccluderCache : nullptr) : 0;
+
+			for (uint32_t i = 0; i < shadowRays.count; ++i)
+			{
+				if (occlusionMask & (1u << i))
 				{
 					continue;
 				}
 
-				auto radiance = LightUtils::GetRadiance(lights[i], closestHit.origin);
+				const Vector3 direction{ shadowRays.directionX[i], shadowRays.directionY[i], shadowRays.directionZ[i] };
+				color += GetLightContribution(m_CurrentLightingMode, material, hitRecord, direction, viewRay.direction, radiances[i], cosines[i], m_BRDFPrecision);
+				++visibleCount;
+			}
+
+			tracedCount += shadowRays.count;
+			shadowRays.count = 0;
+		};
 
-				switch (m_CurrentLightingMode)
+	// one jittered sample in each cell of a gridSize x gridSize grid over the light's sample space
+	const auto sampleGrid = [&](uint32_t gridSize)
+		{
+			for (uint32_t cell{}; cell < gridSize * gridSize; ++cell)
+			{
+				Random::Key sampleKey{ key };
+				sampleKey.sampleIndex = sampleCount++;
+
+				float u{}, v{};
+				m_pSampler->Get2D(sampleKey, Random::Dimension::AreaLight, u, v);
+				u = (cell % gridSize + u) / gridSize;
+				v = (cell / gridSize + v) / gridSize;
+
+				Vector3 direction{};
+				float distance{}, pdf{};
+				// sampled from where the shadow ray starts, so its length ends on the light rather than behind it
+				if (!LightUtils::SampleAreaLight(light, shadowRays.origin, u, v, direction, distance, pdf))
 				{
-				case dae::Renderer::LightingMode::ObservedArea:
-					finalColor += { dot, dot, dot };
-					break;
-				case dae::Renderer::LightingMode::Radiance:
-					finalColor += radiance * dot;
-					break;
-				case dae::Renderer::LightingMode::BRDF:
-					finalColor += materials[closestHit.materialIndex]->Shade(closestHit, direction, viewRay.direction);
-					break;
-				case dae::Renderer::LightingMode::Combined:
-					finalColor += radiance * materials[closestHit.materialIndex]->Shade(closestHit, direction, viewRay.direction) * dot;
-					break;
-				default:
-					break;
+					continue;
+				}
+
+				const float dot = Vector3::Dot(hitRecord.normal, direction);
+				if (dot <= 0)
+				{
+					continue;
+				}
+
+				shadowRays.directionX[shadowRays.count] = direction.x;
+				shadowRays.directionY[shadowRays.count] = direction.y;
+				shadowRays.directionZ[shadowRays.count] = direction.z;
+				shadowRays.max[shadowRays.count] = distance;
+				shadowRays.lightIndex[shadowRays.count] = lightIndex;
+				radiances[shadowRays.count] = emittedRadiance * (1.f / pdf);
+				cosines[shadowRays.count] = dot;
+
+				if (++shadowRays.count == RayPacket::maxSize)
+				{
+					traceShadowRays();
 				}
 			}
 
-			finalColor.MaxToOne();
+			if (shadowRays.count > 0)
+			{
+				traceShadowRays();
+			}
+		};
+
+	sampleGrid(std::max(m_ShadowSampleBudget.GetSettings().baseGridSize, 1u));
+	const uint32_t baseTracedCount = tracedCount;
+
+	// only some of the light is blocked, the shadow edge needs more samples than the flat parts
+	const bool isPenumbra = visibleCount > 0 && visibleCount < tracedCount;
+	if (isPenumbra && m_ShadowSampleBudget.GetPenumbraGridSize() > 0)
+	{
+		sampleGrid(m_ShadowSampleBudget.GetPenumbraGridSize());
+	}
 
-			m_pBufferPixels[px + (py * m_Width)] = SDL_MapRGB(m_pBuffer->format,
-				static_cast<uint8_t>(finalColor.r * 255),
-				static_cast<uint8_t>(finalColor.g * 255),
-				static_cast<uint8_t>(finalColor.b * 255));
+	if (isPrimaryHit)
+	{
+		m_ShadowSampleBudget.AddShadingPoint(baseTracedCount, tracedCount - baseTracedCount, isPenumbra);
+	}
+
+	// samples that missed the light or fell below the surface still count, they add nothing
+	return color * (1.f / sampleCount);
+}
+
+ColorRGB Renderer::ShadeEnvironment(const Scene* pScene, const Material& material, const Ray& viewRay, const HitRecord& hitRecord) const
+{
+	const EnvironmentMap& environment = pScene->GetEnvironment();
+	const uint32_t sampleCount = GetEnvironmentSampleCount();
+
+	RayPacket shadowRays;
+	shadowRays.origin = hitRecord.origin + hitRecord.normal * 0.1f;
+	shadowRays.count = 0;
+	ColorRGB radiances[RayPacket::maxSize];
+	float cosines[RayPacket::maxSize];
+
+	ColorRGB color{};
+
+	// the environment is no light of the scene, so its rays have no occluder cache entry to try first
+	const auto traceShadowRays = [&]
+		{
+			const uint32_t occlusionMask = m_ShadowsEnabled ? pScene->GetOcclusionMask(shadowRays) : 0;
+
+			for (uint32_t i = 0; i < shadowRays.count; ++i)
+			{
+				if (occlusionMask & (1u << i))
+				{
+					continue;
+				}
+
+				const Vector3 direction{ shadowRays.directionX[i], shadowRays.directionY[i], shadowRays.directionZ[i] };
+				color += GetLightContribution(m_CurrentLightingMode, material, hitRecord, direction, viewRay.direction, radiances[i], cosines[i], m_BRDFPrecision);
+			}
+
+			shadowRays.count = 0;
+		};
+
+	for (uint32_t sampleIndex{}; sampleIndex < sampleCount; ++sampleIndex)
+	{
+		Vector3 direction{};
+		if (!SampleEnvironment(environment, hitRecord, sampleIndex, direction, radiances[shadowRays.count], cosines[shadowRays.count]))
+		{
+			continue;
+		}
+
+		shadowRays.directionX[shadowRays.count] = direction.x;
+		shadowRays.directionY[shadowRays.count] = direction.y;
+		shadowRays.directionZ[shadowRays.count] = direction.z;
+		shadowRays.max[shadowRays.count] = FLT_MAX;
+		shadowRays.lightIndex[shadowRays.count] = 0;
+
+		if (++shadowRays.count == RayPacket::maxSize)
+		{
+			traceShadowRays();
 		}
 	}
 
-	//@END
-	//Update SDL Surface
-	SDL_UpdateWindowSurface(m_pWindow);
+	if (shadowRays.count > 0)
+	{
+		traceShadowRays();
+	}
+
+	return color;
 }
 
-bool Renderer::SaveBufferToImage() const
+uint32_t Renderer::GetEnvironmentSampleCount() const
 {
-	return SDL_SaveBMP(m_pBuffer, "RayTracing_Buffer.bmp");
+	return std::max(m_EnvironmentSettings.sampleCount, 1u);
 }
 
-void Renderer::CycleLightingMode()
+bool Renderer::SampleEnvironment(const EnvironmentMap& environment, const HitRecord& hitRecord, uint32_t sampleIndex, Vector3& direction, ColorRGB& radiance, float& cosine) const
 {
-	m_CurrentLightingMode = (LightingMode)((int)m_CurrentLightingMode + 1);
-	m_CurrentLightingMode = (LightingMode)((int)m_CurrentLightingMode % (int)LightingMode::Max);
+	// keyed by the hit position like light selection
+	const Random::Key key{ std::bit_cast<uint32_t>(hitRecord.origin.x), std::bit_cast<uint32_t>(hitRecord.origin.y), sampleIndex, m_FrameIndex, std::bit_cast<uint32_t>(hitRecord.origin.z) };
+
+	float u{}, v{}, s{}, t{};
+	m_pSampler->Get2D(key, Random::Dimension::Environment, u, v);
+	m_pSampler->Get2D(key, Random::Dimension::EnvironmentTexel, s, t);
+
+	float pdf{};
+	if (m_EnvironmentSettings.sampling == EnvironmentSampling::Importance)
+	{
+		environment.Sample(u, v, s, t, direction, pdf);
+	}
+	else
+	{
+		const float y = 1.f - 2.f * u;
+		const float radius = sqrtf(std::max(1.f - y * y, 0.f));
+		direction = { radius * cosf(PI_2 * v), y, radius * sinf(PI_2 * v) };
+		pdf = 1.f / PI_4;
+	}
+
+	cosine = Vector3::Dot(hitRecord.normal, direction);
+	if (cosine <= 0.f || pdf <= 0.f)
+	{
+		return false;
+	}
+
+	const ColorRGB texelRadiance = environment.GetRadiance(direction);
+	if (texelRadiance.r <= 0.f && texelRadiance.g <= 0.f && texelRadiance.b <= 0.f)
+	{
+		return false;
+	}
+
+	radiance = (1.f / (pdf * GetEnvironmentSampleCount())) * texelRadiance;
+	return true;
+}
+
+void Renderer::WritePixel(int px, int py, const ColorRGB& color)
+{
+	//Linear radiance, tone mapping happens when the framebuffer is resolved
+	m_Framebuffer.At(px, py) = color;
+}
+
+void Renderer::InvalidateHistory()
+{
+	m_ReprojectionCache.Invalidate();
+	m_CheckerboardResolver.Invalidate();
+	m_ShadowSampleBudget.Invalidate();
+	//What the records saw depends on the settings that changed
+	m_IrradianceCache.Clear();
 }
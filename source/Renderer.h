@@ -1,32 +1,87 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
+#include <vector>
 
-struct SDL_Window;
-struct SDL_Surface;
+#include "AdaptiveSampler.h"
+#include "CheckerboardResolver.h"
+#include "DynamicResolution.h"
+#include "Framebuffer.h"
+#include "IrradianceCache.h"
+#include "Material.h"
+#include "OccluderCache.h"
+#include "ReprojectionCache.h"
+#include "Sampler.h"
+#include "ShadowSampleBudget.h"
+#include "TileLightCuller.h"
+#include "VisibilityCache.h"
 
 namespace dae
 {
+	class EnvironmentMap;
 	class Scene;
+	class WavefrontRenderer;
+	struct CameraFrame;
+	struct HitRecord;
+	struct Ray;
 
 	class Renderer final
 	{
 	public:
-		Renderer(SDL_Window* pWindow);
-		~Renderer() = default;
+		enum class RenderMode
+		{
+			Standard = 0,
+			Adaptive = 1, //Offline: keeps sampling each tile until its noise estimate converges
+			Reprojection = 2, //Interactive: reuses last frame's hits and colors, traces only invalid pixels
+			DynamicResolution = 3, //Interactive: scales the internal resolution to hold a frame time budget
+			Checkerboard = 4, //Interactive: traces half the pixels per frame, reconstructs the rest
+			Wavefront = 5, //Standard's image traced stage by stage over ray queues, frames it cannot trace render as Standard, see CanRenderWavefront
+			Max = 6
+		};
 
-		Renderer(const Renderer&) = delete;
-		Renderer(Renderer&&) noexcept = delete;
-		Renderer& operator=(const Renderer&) = delete;
-		Renderer& operator=(Renderer&&) noexcept = delete;
+		//Which lights a shading point evaluates once the scene has more than fit in one shadow ray packet
+		enum class LightSelection
+		{
+			All = 0,
+			Culled = 1, //Skips clusters of the light hierarchy whose bounded contribution is below minContribution, at 0 that is none
+			Sampled = 2, //Picks sampleCount lights by importance, unbiased but noisy
+			Power = 3, //Picks sampleCount lights from the scene's alias table, each resampled from candidateCount by its radiance here
+			Tiled = 4, //Standard mode shades tile by tile with the lights whose influence radius reaches the tile, others evaluate all
+			Max = 5
+		};
 
-		void Render(Scene* pScene) const;
-		bool SaveBufferToImage() const;
+		struct LightSettings
+		{
+			LightSelection selection{ LightSelection::Culled };
+			uint32_t sampleCount{ 8 };
+			uint32_t candidateCount{ 8 }; //per pick in Power, 1 picks by power alone
+			float minContribution{ 0.f }; //radiance times cosine, 0 keeps the image exact
+		};
 
-		void CycleLightingMode();
-		void ToggleShadows() { m_ShadowsEnabled = !m_ShadowsEnabled; }
+		//How shadow rays towards the scene's environment map pick their direction
+		enum class EnvironmentSampling
+		{
+			Uniform = 0, //Uniform over the sphere of directions
+			Importance = 1, //Texels by their radiance times solid angle, from the map's alias table
+			Max = 2
+		};
+
+		struct EnvironmentSettings
+		{
+			EnvironmentSampling sampling{ EnvironmentSampling::Importance };
+			uint32_t sampleCount{ 4 }; //shadow rays per shading point
+		};
+
+		//Diffuse light bounced once off the scene, reflected by the Lambert part of materials in Combined lighting
+		enum class IndirectMode
+		{
+			Off = 0,
+			Sampled = 1, //Every shading point samples its own hemisphere, the reference
+			Cached = 2, //Shading points interpolate irradiance records, kept across frames of static scenes
+			Max = 3
+		};
 
-	private:
 		enum class LightingMode
 		{
 			ObservedArea = 0,
@@ -36,15 +91,184 @@ namespace dae
 			Max = 4
 		};
 
+		Renderer(int width, int height);
+		~Renderer();
+
+		Renderer(const Renderer&) = delete;
+		Renderer(Renderer&&) noexcept = delete;
+		Renderer& operator=(const Renderer&) = delete;
+		Renderer& operator=(Renderer&&) noexcept = delete;
+
+		void Render(Scene* pScene);
+		Framebuffer& GetFramebuffer() { return m_Framebuffer; }
+		const Framebuffer& GetFramebuffer() const { return m_Framebuffer; }
+
+		void CycleLightingMode();
+		void CycleRenderMode();
+		void CycleSamplerType();
+		void CycleLightSelection();
+		void ToggleShadows();
+		void ToggleVisibilityCache();
+		void CycleIndirectMode();
+
+		void SetRenderMode(RenderMode renderMode);
+		RenderMode GetRenderMode() const { return m_CurrentRenderMode; }
+
+		LightSettings& GetLightSettings() { return m_LightSettings; }
+
+		void SetBRDFPrecision(BRDF::Precision precision) { m_BRDFPrecision = precision; }
+		BRDF::Precision GetBRDFPrecision() const { return m_BRDFPrecision; }
+		EnvironmentSettings& GetEnvironmentSettings() { return m_EnvironmentSettings; }
+
+		void SetSamplerType(SamplerType samplerType);
+		SamplerType GetSamplerType() const { return m_CurrentSamplerType; }
+
+		//Jittered samples per pixel of the standard render mode, 1 traces through the pixel centers
+		void SetSamplesPerPixel(uint32_t samplesPerPixel) { m_SamplesPerPixel = samplesPerPixel; }
+
+		//Shadow rays test the primitive that last blocked their light before tracing the scene
+		void SetOccluderCacheEnabled(bool isEnabled) { m_IsOccluderCacheEnabled = isEnabled; }
+		const OccluderCache::Statistics& GetOccluderCacheStatistics() const { return m_OccluderCache.GetStatistics(); }
+
+		//Point light shadow rays of static scenes are answered from voxels whose earlier rays all agreed
+		void SetVisibilityCacheEnabled(bool isEnabled) { m_IsVisibilityCacheEnabled = isEnabled; }
+		VisibilityCache& GetVisibilityCache() { return m_VisibilityCache; }
+		const VisibilityCache& GetVisibilityCache() const { return m_VisibilityCache; }
+
+		void SetIndirectMode(IndirectMode indirectMode);
+		IndirectMode GetIndirectMode() const { return m_IndirectMode; }
+		IrradianceCache& GetIrradianceCache() { return m_IrradianceCache; }
+		const IrradianceCache& GetIrradianceCache() const { return m_IrradianceCache; }
+
+		ShadowSampleBudget& GetShadowSampleBudget() { return m_ShadowSampleBudget; }
+		const ShadowSampleBudget& GetShadowSampleBudget() const { return m_ShadowSampleBudget; }
+
+		TileLightCuller& GetTileLightCuller() { return m_TileLightCuller; }
+		const TileLightCuller& GetTileLightCuller() const { return m_TileLightCuller; }
+
+		float GetAverageSamplesPerPixel() const { return m_AverageSamplesPerPixel; }
+		float GetResolutionScale() const;
+
+		//False when the wavefront stages cannot give Standard's image of the scene, Wavefront mode then renders as Standard:
+		//area lights, which sample their stratified soft shadows per shading point, indirect light, which traces its
+		//hemisphere rays and their shading recursively, and light selection, the stages shade every hit with every light
+		bool CanRenderWavefront(const Scene* pScene) const;
+
+		WavefrontRenderer& GetWavefrontRenderer() { return *m_pWavefrontRenderer; }
+		const WavefrontRenderer& GetWavefrontRenderer() const { return *m_pWavefrontRenderer; }
+
+		//What a single unoccluded light adds to a hit in the given lighting mode
+		static ColorRGB GetLightContribution(LightingMode lightingMode, const Material& material, const HitRecord& hitRecord,
+			const Vector3& lightDirection, const Vector3& viewDirection, const ColorRGB& radiance, float cosine, BRDF::Precision precision)
+		{
+			return Material::Dispatch(material.type, [&](auto typeConstant)
+				{
+					return GetLightContribution<decltype(typeConstant)::value>(lightingMode, material, hitRecord, lightDirection, viewDirection, radiance, cosine, precision);
+				});
+		}
+
+		//Same for a material known to be of shadedType, for loops over hits batched by material type
+		template<MaterialType shadedType>
+		static ColorRGB GetLightContribution(LightingMode lightingMode, const Material& material, const HitRecord& hitRecord,
+			const Vector3& lightDirection, const Vector3& viewDirection, const ColorRGB& radiance, float cosine, BRDF::Precision precision);
+
+		//Shadow rays ShadeEnvironment traces per shading point
+		uint32_t GetEnvironmentSampleCount() const;
+
+		//Direction of environment shadow ray sampleIndex from the hit and the radiance it brings, already divided by its pdf
+		//and the sample count, false when the direction is below the surface or dark and the ray is not traced
+		bool SampleEnvironment(const EnvironmentMap& environment, const HitRecord& hitRecord, uint32_t sampleIndex,
+			Vector3& direction, ColorRGB& radiance, float& cosine) const;
+
+	private:
 		LightingMode m_CurrentLightingMode{ LightingMode::Combined };
+		RenderMode m_CurrentRenderMode{ RenderMode::Standard };
 		bool m_ShadowsEnabled{ true };
+		uint32_t m_SamplesPerPixel{ 1 };
+		LightSettings m_LightSettings{};
+		BRDF::Precision m_BRDFPrecision{ BRDF::Precision::Exact };
+		EnvironmentSettings m_EnvironmentSettings{};
+
+		SamplerType m_CurrentSamplerType{ SamplerType::Sobol };
+		std::unique_ptr<Sampler> m_pSampler;
+		//Part of every sampler key, so the jitter, light picks and strata of a frame are independent of the last one
+		uint32_t m_FrameIndex{};
+
+		//Shading runs on the calling thread only, so one cache serves the whole frame
+		bool m_IsOccluderCacheEnabled{ true };
+		mutable OccluderCache m_OccluderCache{};
+		mutable ShadowSampleBudget m_ShadowSampleBudget{};
 
-		SDL_Window* m_pWindow{};
+		//Only valid for the scene they were filled for, and only while that scene is static
+		bool m_IsVisibilityCacheEnabled{ false };
+		mutable VisibilityCache m_VisibilityCache{};
+		IndirectMode m_IndirectMode{ IndirectMode::Off };
+		mutable IrradianceCache m_IrradianceCache{};
+		uint64_t m_CachedSceneGeneration{}; //see Scene::GetGeneration, 0 is never one
 
-		SDL_Surface* m_pBuffer{};
-		uint32_t* m_pBufferPixels{};
+		Framebuffer m_Framebuffer{};
 
 		int m_Width{};
 		int m_Height{};
+
+		AdaptiveSampler m_AdaptiveSampler{};
+		float m_AverageSamplesPerPixel{ 1.f };
+
+		ReprojectionCache m_ReprojectionCache{};
+
+		DynamicResolution m_DynamicResolution{};
+		std::vector<ColorRGB> m_ScaledBuffer{};
+
+		CheckerboardResolver m_CheckerboardResolver{};
+
+		//Primary rays and hits of the tile being shaded, traced before its light list is built
+		TileLightCuller m_TileLightCuller{};
+		std::vector<Ray> m_TileViewRays{};
+		std::vector<HitRecord> m_TileHits{};
+
+		std::unique_ptr<WavefrontRenderer> m_pWavefrontRenderer;
+
+		void RenderStandard(const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame);
+		void RenderTiled(const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame);
+		void RenderAdaptive(const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame);
+		void RenderReprojected(const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame);
+		void RenderDynamicResolution(const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame);
+		void RenderCheckerboard(const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame);
+		void RenderWavefront(const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame);
+
+		ColorRGB RenderSample(const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame, float x, float y) const;
+		void TracePixel(const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame, int px, int py, GBufferTexel& texel) const;
+		//Evaluates the lights of pLightList when given, otherwise the ones the light settings select.
+		//Indirect light is only added at primary hits, hemisphere rays shade what they hit with direct light alone
+		ColorRGB Shade(const Scene* pScene, const std::vector<Material>& materials, const Ray& viewRay, const HitRecord& hitRecord,
+			const std::vector<uint32_t>* pLightList = nullptr, bool isPrimaryHit = true) const;
+		//Irradiance arriving at the hit from the rest of the scene, see IndirectMode
+		ColorRGB GetIndirectIrradiance(const Scene* pScene, const std::vector<Material>& materials, const HitRecord& hitRecord) const;
+		//Stratified soft shadow estimate of one area light, refined where the first samples disagree.
+		//Only primary hits count toward the shadow sample budget, it is planned per pixel
+		ColorRGB ShadeAreaLight(const Scene* pScene, const Material& material, const Ray& viewRay, const HitRecord& hitRecord, uint32_t lightIndex, bool isPrimaryHit) const;
+		//Light arriving from the scene's environment map, sampled with sampleCount shadow rays
+		ColorRGB ShadeEnvironment(const Scene* pScene, const Material& material, const Ray& viewRay, const HitRecord& hitRecord) const;
+		void WritePixel(int px, int py, const ColorRGB& color);
+		void InvalidateHistory();
 	};
+
+	template<MaterialType shadedType>
+	ColorRGB Renderer::GetLightContribution(LightingMode lightingMode, const Material& material, const HitRecord& hitRecord,
+		const Vector3& lightDirection, const Vector3& viewDirection, const ColorRGB& radiance, float cosine, BRDF::Precision precision)
+	{
+		switch (lightingMode)
+		{
+		case LightingMode::ObservedArea:
+			return { cosine, cosine, cosine };
+		case LightingMode::Radiance:
+			return radiance * cosine;
+		case LightingMode::BRDF:
+			return material.Shade<shadedType>(hitRecord, lightDirection, viewDirection, precision);
+		case LightingMode::Combined:
+			return radiance * material.Shade<shadedType>(hitRecord, lightDirection, viewDirection, precision) * cosine;
+		default:
+			return {};
+		}
+	}
 }
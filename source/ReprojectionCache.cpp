@@ -0,0 +1,120 @@
+#include "ReprojectionCache.h"
+
+#include <algorithm>
+
+#include "Camera.h"
+
+namespace dae
+{
+	void ReprojectionCache::BeginFrame(const CameraFrame& cameraFrame)
+	{
+		if (m_Current.GetWidth() != cameraFrame.width || m_Current.GetHeight() != cameraFrame.height)
+		{
+			m_History.Resize(cameraFrame.width, cameraFrame.height);
+			m_Current.Resize(cameraFrame.width, cameraFrame.height);
+			m_Reprojected.Resize(cameraFrame.width, cameraFrame.height);
+			m_HasHistory = false;
+		}
+
+		m_IsValid.assign(size_t(cameraFrame.width) * cameraFrame.height, false);
+
+		if (!m_HasHistory)
+			return;
+
+		Scatter(cameraFrame);
+		Validate(cameraFrame);
+	}
+
+	void ReprojectionCache::EndFrame()
+	{
+		std::swap(m_History, m_Current);
+		m_HasHistory = true;
+
+		const size_t validCount = std::count(m_IsValid.begin(), m_IsValid.end(), true);
+		m_ReuseRatio = m_IsValid.empty() ? 0.f : validCount / float(m_IsValid.size());
+	}
+
+	const GBufferTexel* ReprojectionCache::GetReprojectedTexel(int px, int py) const
+	{
+		if (!m_IsValid[px + (py * m_Reprojected.GetWidth())])
+			return nullptr;
+
+		return &m_Reprojected.At(px, py);
+	}
+
+	void ReprojectionCache::Store(int px, int py, const GBufferTexel& texel)
+	{
+		m_Current.At(px, py) = texel;
+	}
+
+	uint8_t ReprojectionCache::GetInitialAge(int px, int py) const
+	{
+		const uint32_t stagger = std::max(m_Settings.maxAge / 2, 1);
+		return static_cast<uint8_t>((uint32_t(px) * 7u + uint32_t(py) * 13u) % stagger);
+	}
+
+	void ReprojectionCache::Scatter(const CameraFrame& cameraFrame)
+	{
+		m_Reprojected.Clear();
+
+		for (int py{}; py < m_History.GetHeight(); ++py)
+		{
+			for (int px{}; px < m_History.GetWidth(); ++px)
+			{
+				const GBufferTexel& texel = m_History.At(px, py);
+				if (!texel.didHit || texel.age >= m_Settings.maxAge)
+					continue;
+
+				float x{}, y{}, depth{};
+				if (!cameraFrame.Project(texel.position, x, y, depth))
+					continue;
+
+				const int targetX = static_cast<int>(floorf(x));
+				const int targetY = static_cast<int>(floorf(y));
+				if (targetX < 0 || targetX >= cameraFrame.width || targetY < 0 || targetY >= cameraFrame.height)
+					continue;
+
+				// z-buffered scatter, the nearest surface wins
+				GBufferTexel& target = m_Reprojected.At(targetX, targetY);
+				if (depth < target.depth)
+				{
+					target = texel;
+					target.depth = depth;
+				}
+			}
+		}
+	}
+
+	void ReprojectionCache::Validate(const CameraFrame& cameraFrame)
+	{
+		for (int py{}; py < cameraFrame.height; ++py)
+		{
+			for (int px{}; px < cameraFrame.width; ++px)
+			{
+				const GBufferTexel& texel = m_Reprojected.At(px, py);
+				if (!texel.didHit)
+					continue;
+
+				// normal test: the cached surface has to face the new view
+				const Vector3 viewDirection = (texel.position - cameraFrame.origin).Normalized();
+				if (Vector3::Dot(texel.normal, -viewDirection) < m_Settings.minFacing)
+					continue;
+
+				// depth test: a texel much farther than its neighbors shows through a crack in a closer surface
+				float nearestDepth{ texel.depth };
+				for (int ny{ std::max(py - 1, 0) }; ny <= std::min(py + 1, cameraFrame.height - 1); ++ny)
+				{
+					for (int nx{ std::max(px - 1, 0) }; nx <= std::min(px + 1, cameraFrame.width - 1); ++nx)
+					{
+						nearestDepth = std::min(nearestDepth, m_Reprojected.At(nx, ny).depth);
+					}
+				}
+
+				if (texel.depth > nearestDepth * m_Settings.maxDepthRatio)
+					continue;
+
+				m_IsValid[px + (py * cameraFrame.width)] = true;
+			}
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "GBuffer.h"
+
+namespace dae
+{
+	struct CameraFrame;
+
+	/**
+	 * \brief Keeps last frame's primary hits and shaded colors and scatters them into the new view.
+	 * Reprojected texels pass a depth test (z-buffered scatter plus a neighborhood crack test) and a normal
+	 * test (surface must still face the camera); every pixel that fails or receives nothing must be re-traced.
+	 */
+	class ReprojectionCache final
+	{
+	public:
+		struct Settings
+		{
+			float maxDepthRatio{ 1.05f }; //farther than this ratio of the nearest neighbor means background leaking through a crack
+			float minFacing{ 0.05f }; //cosine between normal and view vector, below this the surface turned away
+			float minViewCosine{ 0.9995f }; //larger view direction changes re-shade the cached hit (view dependent BRDFs)
+			uint8_t maxAge{ 16 }; //frames a texel may be reused before it is traced again
+		};
+
+		ReprojectionCache() = default;
+		~ReprojectionCache() = default;
+
+		ReprojectionCache(const ReprojectionCache&) = delete;
+		ReprojectionCache(ReprojectionCache&&) noexcept = delete;
+		ReprojectionCache& operator=(const ReprojectionCache&) = delete;
+		ReprojectionCache& operator=(ReprojectionCache&&) noexcept = delete;
+
+		void BeginFrame(const CameraFrame& cameraFrame);
+		void EndFrame();
+		void Invalidate() { m_HasHistory = false; }
+
+		//Returns the reprojected texel for this pixel, or nullptr when it has to be traced
+		const GBufferTexel* GetReprojectedTexel(int px, int py) const;
+		void Store(int px, int py, const GBufferTexel& texel);
+
+		//Age to give a freshly traced texel, staggered so the whole screen never expires in the same frame
+		uint8_t GetInitialAge(int px, int py) const;
+
+		float GetReuseRatio() const { return m_ReuseRatio; }
+		Settings& GetSettings() { return m_Settings; }
+
+	private:
+		Settings m_Settings{};
+
+		GBuffer m_History{};
+		GBuffer m_Current{};
+		GBuffer m_Reprojected{};
+		std::vector<bool> m_IsValid{};
+
+		bool m_HasHistory{ false };
+		float m_ReuseRatio{};
+
+		void Scatter(const CameraFrame& cameraFrame);
+		void Validate(const CameraFrame& cameraFrame);
+	};
+}
@@ -0,0 +1,219 @@
+#include "Sampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace dae
+{
+	namespace
+	{
+		uint32_t ReverseBits(uint32_t x)
+		{
+			x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+			x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+			x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+			x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+			return (x >> 16) | (x << 16);
+		}
+
+		//Hash that only lets a bit depend on the bits below it, applied to reversed bits it is an Owen scramble
+		uint32_t LaineKarrasPermutation(uint32_t x, uint32_t seed)
+		{
+			x += seed;
+			x ^= x * 0x6C50B47Cu;
+			x ^= x * 0xB82F1E52u;
+			x ^= x * 0xC7AFE638u;
+			x ^= x * 0x8D22F6E6u;
+			return x;
+		}
+
+		uint32_t NestedUniformScramble(uint32_t x, uint32_t seed)
+		{
+			return ReverseBits(LaineKarrasPermutation(ReverseBits(x), seed));
+		}
+
+		//The first Sobol dimension is the van der Corput sequence, the second has direction numbers v ^= v >> 1
+		uint32_t SobolFirstDimension(uint32_t index)
+		{
+			return ReverseBits(index);
+		}
+
+		uint32_t SobolSecondDimension(uint32_t index)
+		{
+			uint32_t result{};
+			for (uint32_t direction{ 1u << 31 }; index != 0; index >>= 1, direction ^= direction >> 1)
+			{
+				if (index & 1)
+					result ^= direction;
+			}
+
+			return result;
+		}
+	}
+
+	std::unique_ptr<Sampler> Sampler::Create(SamplerType samplerType)
+	{
+		switch (samplerType)
+		{
+		case SamplerType::Random:
+			return std::make_unique<RandomSampler>();
+		case SamplerType::BlueNoise:
+			return std::make_unique<BlueNoiseSampler>();
+		case SamplerType::Sobol:
+		default:
+			return std::make_unique<SobolSampler>();
+		}
+	}
+
+	void RandomSampler::Get2D(const Random::Key& key, Random::Dimension dimension, float& u, float& v) const
+	{
+		Random::GetFloat2(key, dimension, u, v);
+	}
+
+	void SobolSampler::Get2D(const Random::Key& key, Random::Dimension dimension, float& u, float& v) const
+	{
+		const std::array<uint32_t, 4> seeds = Random::GetUints({ key.px, key.py, 0, key.frameIndex, key.seed }, dimension);
+
+		const uint32_t index = NestedUniformScramble(key.sampleIndex, seeds[0]);
+		u = Random::ToFloat(NestedUniformScramble(SobolFirstDimension(index), seeds[1]));
+		v = Random::ToFloat(NestedUniformScramble(SobolSecondDimension(index), seeds[2]));
+	}
+
+	BlueNoiseSampler::BlueNoiseSampler()
+	{
+		BuildMask();
+	}
+
+	void BlueNoiseSampler::Get2D(const Random::Key& key, Random::Dimension dimension, float& u, float& v) const
+	{
+		constexpr uint32_t wrap{ maskSize - 1 };
+		const std::array<uint32_t, 4> offsets = Random::GetUints({ 0, 0, 0, key.frameIndex, key.seed }, dimension);
+
+		u = m_Mask[((key.px + offsets[0]) & wrap) + ((key.py + offsets[1]) & wrap) * maskSize];
+		v = m_Mask[((key.px + offsets[2]) & wrap) + ((key.py + offsets[3]) & wrap) * maskSize];
+
+		//R2 sequence constants
+		u += key.sampleIndex * 0.7548776662f;
+		v += key.sampleIndex * 0.5698402910f;
+
+		u -= floorf(u);
+		v -= floorf(v);
+	}
+
+	void BlueNoiseSampler::BuildMask()
+	{
+		//Void-and-cluster (Ulichney 1993): every texel gets a rank, the texels of any rank prefix are spread evenly
+		constexpr int texelCount{ maskSize * maskSize };
+		constexpr int wrap{ maskSize - 1 };
+		constexpr float sigma{ 1.5f };
+
+		//Gaussian of the wrapped distance, so the mask tiles without seams
+		std::vector<float> kernel(texelCount);
+		for (int y{}; y < maskSize; ++y)
+		{
+			for (int x{}; x < maskSize; ++x)
+			{
+				const float dx = float(std::min(x, maskSize - x));
+				const float dy = float(std::min(y, maskSize - y));
+				kernel[x + y * maskSize] = expf(-(dx * dx + dy * dy) / (2 * sigma * sigma));
+			}
+		}
+
+		std::vector<bool> isSet(texelCount);
+		std::vector<float> energy(texelCount);
+
+		const auto update = [&](int texel, bool set)
+			{
+				isSet[texel] = set;
+
+				const float sign = set ? 1.f : -1.f;
+				const int texelX = texel % maskSize;
+				const int texelY = texel / maskSize;
+				for (int y{}; y < maskSize; ++y)
+				{
+					for (int x{}; x < maskSize; ++x)
+					{
+						energy[x + y * maskSize] += sign * kernel[((x - texelX) & wrap) + ((y - texelY) & wrap) * maskSize];
+					}
+				}
+			};
+
+		//Highest energy of the set texels is the tightest cluster, lowest of the empty ones the largest void
+		const auto findTightestCluster = [&]
+			{
+				int best{ -1 };
+				for (int texel{}; texel < texelCount; ++texel)
+				{
+					if (isSet[texel] && (best < 0 || energy[texel] > energy[best]))
+						best = texel;
+				}
+				return best;
+			};
+
+		const auto findLargestVoid = [&]
+			{
+				int best{ -1 };
+				for (int texel{}; texel < texelCount; ++texel)
+				{
+					if (!isSet[texel] && (best < 0 || energy[texel] < energy[best]))
+						best = texel;
+				}
+				return best;
+			};
+
+		//Random initial points on a tenth of the texels
+		for (uint32_t i{}; i < texelCount / 10; ++i)
+		{
+			const int texel = int(Random::GetUints({ i }, Random::Dimension::BlueNoiseMask)[0] % texelCount);
+			if (!isSet[texel])
+				update(texel, true);
+		}
+
+		//Spread them: move the tightest cluster to the largest void until that puts it back where it was
+		while (true)
+		{
+			const int cluster = findTightestCluster();
+			update(cluster, false);
+
+			const int largestVoid = findLargestVoid();
+			update(largestVoid, true);
+
+			if (largestVoid == cluster)
+				break;
+		}
+
+		int initialCount{};
+		for (int texel{}; texel < texelCount; ++texel)
+		{
+			initialCount += isSet[texel];
+		}
+
+		const std::vector<bool> initialIsSet = isSet;
+		const std::vector<float> initialEnergy = energy;
+		std::vector<int> ranks(texelCount);
+
+		//Rank the initial points, the tightest cluster is removed first and gets the highest rank
+		for (int rank{ initialCount - 1 }; rank >= 0; --rank)
+		{
+			const int cluster = findTightestCluster();
+			update(cluster, false);
+			ranks[cluster] = rank;
+		}
+
+		//Then fill the largest void until every texel is ranked
+		isSet = initialIsSet;
+		energy = initialEnergy;
+		for (int rank{ initialCount }; rank < texelCount; ++rank)
+		{
+			const int largestVoid = findLargestVoid();
+			update(largestVoid, true);
+			ranks[largestVoid] = rank;
+		}
+
+		m_Mask.resize(texelCount);
+		for (int texel{}; texel < texelCount; ++texel)
+		{
+			m_Mask[texel] = (ranks[texel] + 0.5f) / texelCount;
+		}
+	}
+}
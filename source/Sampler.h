@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Random.h"
+
+namespace dae
+{
+	enum class SamplerType
+	{
+		Random = 0, //Independent uniform points
+		Sobol = 1, //Owen scrambled Sobol, the lowest error per sample count
+		BlueNoise = 2, //Pixel pattern from a blue noise mask, error spread as high frequency noise
+		Max = 3
+	};
+
+	/**
+	 * \brief Source of the 2D points used for stochastic sampling. A point is a pure function of its key and
+	 * dimension, so one sampler is shared by every thread and a render stays deterministic. Every dimension
+	 * gets its own decorrelated pattern, see Random::Dimension.
+	 */
+	class Sampler
+	{
+	public:
+		Sampler() = default;
+		virtual ~Sampler() = default;
+
+		Sampler(const Sampler&) = delete;
+		Sampler(Sampler&&) noexcept = delete;
+		Sampler& operator=(const Sampler&) = delete;
+		Sampler& operator=(Sampler&&) noexcept = delete;
+
+		/**
+		 * \param key pixel, sample index and frame the point is drawn for
+		 * \param dimension what the point is used for
+		 * \param u first coordinate in [0, 1)
+		 * \param v second coordinate in [0, 1)
+		 */
+		virtual void Get2D(const Random::Key& key, Random::Dimension dimension, float& u, float& v) const = 0;
+
+		static std::unique_ptr<Sampler> Create(SamplerType samplerType);
+	};
+
+	class RandomSampler final : public Sampler
+	{
+	public:
+		void Get2D(const Random::Key& key, Random::Dimension dimension, float& u, float& v) const override;
+	};
+
+	/**
+	 * \brief First two Sobol dimensions with hash based Owen scrambling and a shuffled index (Burley 2020).
+	 * The scramble seeds come from the key without its sample index, so the samples of one pixel stay a
+	 * single stratified sequence while neighbouring pixels and other dimensions are decorrelated.
+	 */
+	class SobolSampler final : public Sampler
+	{
+	public:
+		void Get2D(const Random::Key& key, Random::Dimension dimension, float& u, float& v) const override;
+	};
+
+	/**
+	 * \brief Reads both coordinates from a tiled blue noise mask, built once with void-and-cluster, at an offset
+	 * per dimension. Later samples of a pixel add an R2 step, which keeps every sample index a blue noise
+	 * pattern across the screen.
+	 */
+	class BlueNoiseSampler final : public Sampler
+	{
+	public:
+		static constexpr int maskSize{ 64 };
+
+		BlueNoiseSampler();
+
+		void Get2D(const Random::Key& key, Random::Dimension dimension, float& u, float& v) const override;
+
+	private:
+		std::vector<float> m_Mask{};
+
+		void BuildMask();
+	};
+}
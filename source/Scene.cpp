@@ -1,13 +1,23 @@
 #include "Scene.h"
+
+#include <algorithm>
+#include <atomic>
+
 #include "Utils.h"
-#include "Material.h"
 
 namespace dae {
 
+	namespace
+	{
+		//Shared by every scene, so no two scene objects ever have the same generation
+		std::atomic<uint64_t> s_NextGeneration{ 1 };
+	}
+
 #pragma region Base Scene
 	//Initialize Scene with Default Solid Color Material (RED)
 	Scene::Scene() :
-		m_Materials({ new Material_SolidColor({1,0,0}) })
+		m_Generation(s_NextGeneration++),
+		m_Materials({ Material::SolidColor({1,0,0}) })
 	{
 		m_SphereGeometries.reserve(32);
 		m_PlaneGeometries.reserve(32);
@@ -15,17 +25,6 @@ namespace dae {
 		m_Lights.reserve(32);
 	}
 
-	Scene::~Scene()
-	{
-		for (auto& pMaterial : m_Materials)
-		{
-			delete pMaterial;
-			pMaterial = nullptr;
-		}
-
-		m_Materials.clear();
-	}
-
 	void dae::Scene::GetClosestHit(const Ray& ray, HitRecord& closestHit) const
 	{
 		for (size_t i = 0; i < m_SphereGeometries.size(); i++)
@@ -88,8 +87,258 @@ namespace dae {
 		return false;
 	}
 
+	uint32_t Scene::GetOcclusionMask(const RayPacket& packet, OccluderCache* pOccluderCache) const
+	{
+		// same tests as DoesHit, with every primitive set up once for the whole packet: whatever only depends on the
+		// shared origin is computed outside the ray loop. Blocked rays leave the packet, so like DoesHit every ray
+		// stops at its first hit, and tracing ends once none are left
+		const Vector3& origin = packet.origin;
+		uint32_t activeCount{};
+		uint32_t occlusionMask{};
+
+		float directionX[RayPacket::maxSize];
+		float directionY[RayPacket::maxSize];
+		float directionZ[RayPacket::maxSize];
+		float maxDistance[RayPacket::maxSize];
+		uint32_t rayIndices[RayPacket::maxSize];
+		uint32_t isOccluded[RayPacket::maxSize];
+
+		for (uint32_t i = 0; i < packet.count; i++)
+		{
+			// whatever blocked the previous ray to this light is the likeliest thing to block this one too
+			if (pOccluderCache)
+			{
+				const OccluderCache::Occluder& occluder = pOccluderCache->GetOccluder(packet.lightIndex[i]);
+				if (occluder.type != OccluderCache::PrimitiveType::None)
+				{
+					OccluderCache::Statistics& statistics = pOccluderCache->GetStatistics();
+					++statistics.queryCount;
+
+					if (DoesOccluderHit(occluder, { origin, { packet.directionX[i], packet.directionY[i], packet.directionZ[i] }, packet.min, packet.max[i] }))
+					{
+						++statistics.hitCount;
+						occlusionMask |= 1u << i;
+						continue;
+					}
+				}
+			}
+
+			directionX[activeCount] = packet.directionX[i];
+			directionY[activeCount] = packet.directionY[i];
+			directionZ[activeCount] = packet.directionZ[i];
+			maxDistance[activeCount] = packet.max[i];
+			rayIndices[activeCount] = i;
+			++activeCount;
+		}
+
+		if (activeCount == 0)
+			return occlusionMask;
+
+		const auto removeOccluded = [&](const OccluderCache::Occluder& occluder)
+			{
+				uint32_t keptCount{};
+				for (uint32_t i = 0; i < activeCount; i++)
+				{
+					if (isOccluded[i])
+					{
+						occlusionMask |= 1u << rayIndices[i];
+						if (pOccluderCache)
+							pOccluderCache->GetOccluder(packet.lightIndex[rayIndices[i]]) = occluder;
+
+						continue;
+					}
+
+					directionX[keptCount] = directionX[i];
+					directionY[keptCount] = directionY[i];
+					directionZ[keptCount] = directionZ[i];
+					maxDistance[keptCount] = maxDistance[i];
+					rayIndices[keptCount] = rayIndices[i];
+					++keptCount;
+				}
+
+				activeCount = keptCount;
+				return activeCount == 0;
+			};
+
+		for (uint32_t planeIndex = 0; planeIndex < m_PlaneGeometries.size(); planeIndex++)
+		{
+			const Plane& plane = m_PlaneGeometries[planeIndex];
+			const float numerator = Vector3::Dot(plane.origin - origin, plane.normal);
+
+			uint32_t hitCount{};
+			for (uint32_t i = 0; i < activeCount; i++)
+			{
+				const float t = numerator / (directionX[i] * plane.normal.x + directionY[i] * plane.normal.y + directionZ[i] * plane.normal.z);
+				isOccluded[i] = !(t < packet.min || t > maxDistance[i]);
+				hitCount += isOccluded[i];
+			}
+
+			if (hitCount > 0 && removeOccluded({ OccluderCache::PrimitiveType::Plane, planeIndex }))
+				return occlusionMask;
+		}
+
+		for (uint32_t sphereIndex = 0; sphereIndex < m_SphereGeometries.size(); sphereIndex++)
+		{
+			const Sphere& sphere = m_SphereGeometries[sphereIndex];
+			const Vector3 diffRayToSphere = origin - sphere.origin;
+			const float C = Vector3::Dot(diffRayToSphere, diffRayToSphere) - sphere.radius * sphere.radius;
+
+			uint32_t hitCount{};
+			for (uint32_t i = 0; i < activeCount; i++)
+			{
+				isOccluded[i] = 0;
+
+				const float B = (2 * directionX[i]) * diffRayToSphere.x + (2 * directionY[i]) * diffRayToSphere.y + (2 * directionZ[i]) * diffRayToSphere.z;
+				const float discriminant = B * B - 4 * C;
+				if (discriminant < 0.00001f)
+					continue;
+
+				const float t = (-B - sqrtf(discriminant)) / 2;
+				isOccluded[i] = !(t < packet.min || t > maxDistance[i]);
+				hitCount += isOccluded[i];
+			}
+
+			if (hitCount > 0 && removeOccluded({ OccluderCache::PrimitiveType::Sphere, sphereIndex }))
+				return occlusionMask;
+		}
+
+		for (uint32_t meshIndex = 0; meshIndex < m_TriangleMeshGeometries.size(); meshIndex++)
+		{
+			const TriangleMesh& mesh = m_TriangleMeshGeometries[meshIndex];
+			const bool cullsFrontFaces = mesh.cullMode == TriangleCullMode::FrontFaceCulling;
+			const bool cullsBackFaces = mesh.cullMode == TriangleCullMode::BackFaceCulling;
+
+			for (uint32_t index = 0; index < mesh.indices.size(); index += 3)
+			{
+				const Vector3& v0 = mesh.transformedPositions[mesh.indices[index]];
+				const Vector3& v1 = mesh.transformedPositions[mesh.indices[index + 1]];
+				const Vector3& v2 = mesh.transformedPositions[mesh.indices[index + 2]];
+				const Vector3& normal = mesh.transformedNormals[index / 3];
+
+				const float numerator = Vector3::Dot(v0 - origin, normal);
+
+				// the edge tests of GeometryUtils::HitTest_Triangle, n . (edge x (p - start)) written out per component
+				const auto isInsideEdge = [&](const Vector3& start, const Vector3& end, float pX, float pY, float pZ)
+					{
+						const Vector3 edge = end - start;
+						const float qX = pX - start.x;
+						const float qY = pY - start.y;
+						const float qZ = pZ - start.z;
+
+						return normal.x * (edge.y * qZ - edge.z * qY) + normal.y * (edge.z * qX - edge.x * qZ) + normal.z * (edge.x * qY - edge.y * qX) >= 0;
+					};
+
+				uint32_t hitCount{};
+				for (uint32_t i = 0; i < activeCount; i++)
+				{
+					isOccluded[i] = 0;
+
+					const float dot = normal.x * directionX[i] + normal.y * directionY[i] + normal.z * directionZ[i];
+					if ((cullsFrontFaces && dot < 0) || (cullsBackFaces && dot > 0))
+						continue;
+
+					const float t = numerator / dot;
+					if (t < packet.min || t > maxDistance[i])
+						continue;
+
+					const float pX = origin.x + t * directionX[i];
+					const float pY = origin.y + t * directionY[i];
+					const float pZ = origin.z + t * directionZ[i];
+
+					isOccluded[i] = isInsideEdge(v0, v1, pX, pY, pZ) && isInsideEdge(v1, v2, pX, pY, pZ) && isInsideEdge(v2, v0, pX, pY, pZ);
+					hitCount += isOccluded[i];
+				}
+
+				if (hitCount > 0 && removeOccluded({ OccluderCache::PrimitiveType::Triangle, index, meshIndex }))
+					return occlusionMask;
+			}
+		}
+
+		// these lights are visible, the next shading point is most likely lit as well and skips the cache test
+		if (pOccluderCache)
+		{
+			for (uint32_t i = 0; i < activeCount; i++)
+			{
+				pOccluderCache->GetOccluder(packet.lightIndex[rayIndices[i]]) = {};
+			}
+		}
+
+		return occlusionMask;
+	}
+
+	bool Scene::DoesOccluderHit(const OccluderCache::Occluder& occluder, const Ray& ray) const
+	{
+		// the cache may outlive geometry, an occluder that no longer exists just misses
+		switch (occluder.type)
+		{
+		case OccluderCache::PrimitiveType::Plane:
+			return occluder.index < m_PlaneGeometries.size() && GeometryUtils::HitTest_Plane(m_PlaneGeometries[occluder.index], ray);
+		case OccluderCache::PrimitiveType::Sphere:
+			return occluder.index < m_SphereGeometries.size() && GeometryUtils::HitTest_Sphere(m_SphereGeometries[occluder.index], ray);
+		case OccluderCache::PrimitiveType::Triangle:
+		{
+			if (occluder.meshIndex >= m_TriangleMeshGeometries.size())
+				return false;
+
+			const TriangleMesh& mesh = m_TriangleMeshGeometries[occluder.meshIndex];
+			if (occluder.index + 2 >= mesh.indices.size())
+				return false;
+
+			// same culling as the mesh test
+			Triangle triangle = { mesh.transformedPositions[mesh.indices[occluder.index]], mesh.transformedPositions[mesh.indices[occluder.index + 1]], mesh.transformedPositions[mesh.indices[occluder.index + 2]] };
+			triangle.normal = mesh.transformedNormals[occluder.index / 3];
+			triangle.cullMode = mesh.cullMode;
+
+			HitRecord hitRecord{};
+			return GeometryUtils::HitTest_Triangle(triangle, ray, hitRecord);
+		}
+		case OccluderCache::PrimitiveType::None:
+		default:
+			return false;
+		}
+	}
+
+	void Scene::SetLightInfluenceThreshold(float minRadiance)
+	{
+		for (Light& light : m_Lights)
+		{
+			if (light.type == LightType::Point)
+			{
+				light.influenceRadius = minRadiance > 0.f ? LightUtils::GetInfluenceRadius(light, minRadiance) : 0.f;
+			}
+		}
+	}
+
+	void Scene::MarkLightsChanged()
+	{
+		m_AreLightsDirty = true;
+		m_Generation = s_NextGeneration++;
+	}
+
+	void Scene::UpdateLights()
+	{
+		if (!m_AreLightsDirty)
+			return;
+
+		m_LightBVH.Build(m_Lights);
+
+		// same power as the hierarchy's nodes, the radiance of a point light without its falloff
+		std::vector<float> lightPowers(m_Lights.size());
+		for (size_t i{}; i < m_Lights.size(); ++i)
+		{
+			const Light& light = m_Lights[i];
+			if (light.type == LightType::Point)
+			{
+				lightPowers[i] = light.intensity * std::max({ light.color.r, light.color.g, light.color.b });
+			}
+		}
+		m_LightAliasTable.Build(lightPowers);
+
+		m_AreLightsDirty = false;
+	}
+
 #pragma region Scene Helpers
-	Sphere* Scene::AddSphere(const Vector3& origin, float radius, unsigned char materialIndex)
+	Sphere* Scene::AddSphere(const Vector3& origin, float radius, uint32_t materialIndex)
 	{
 		Sphere s;
 		s.origin = origin;
@@ -100,7 +349,7 @@ namespace dae {
 		return &m_SphereGeometries.back();
 	}
 
-	Plane* Scene::AddPlane(const Vector3& origin, const Vector3& normal, unsigned char materialIndex)
+	Plane* Scene::AddPlane(const Vector3& origin, const Vector3& normal, uint32_t materialIndex)
 	{
 		Plane p;
 		p.origin = origin;
@@ -111,7 +360,7 @@ namespace dae {
 		return &m_PlaneGeometries.back();
 	}
 
-	TriangleMesh* Scene::AddTriangleMesh(TriangleCullMode cullMode, unsigned char materialIndex)
+	TriangleMesh* Scene::AddTriangleMesh(TriangleCullMode cullMode, uint32_t materialIndex)
 	{
 		TriangleMesh m{};
 		m.cullMode = cullMode;
@@ -121,7 +370,41 @@ namespace dae {
 		return &m_TriangleMeshGeometries.back();
 	}
 
-	Light* Scene::AddPointLight(const Vector3& origin, float intensity, const ColorRGB& color)
+	TriangleMesh* Scene::AddTriangleMeshFromOBJ(const std::string& filename, TriangleCullMode cullMode, uint32_t materialIndex,
+		const std::unordered_map<std::string, uint32_t>& materialsByName)
+	{
+		TriangleMesh* pMesh = AddTriangleMesh(cullMode, materialIndex);
+
+		std::vector<std::string> materialNames{};
+		std::vector<uint32_t> triangleMaterials{};
+		Utils::ParseOBJ(filename, pMesh->positions, pMesh->normals, pMesh->indices, materialNames, triangleMaterials);
+
+		std::vector<uint32_t> groupMaterials(materialNames.size(), materialIndex);
+		bool hasOtherMaterial{ false };
+		for (size_t group = 0; group < materialNames.size(); ++group)
+		{
+			const auto it = materialsByName.find(materialNames[group]);
+			if (it != materialsByName.end())
+			{
+				groupMaterials[group] = it->second;
+				hasOtherMaterial |= it->second != materialIndex;
+			}
+		}
+
+		// a mesh of one material keeps materialIndices empty, so its triangles need no lookup
+		if (hasOtherMaterial)
+		{
+			pMesh->materialIndices.reserve(triangleMaterials.size());
+			for (const uint32_t group : triangleMaterials)
+			{
+				pMesh->materialIndices.push_back(groupMaterials[group]);
+			}
+		}
+
+		return pMesh;
+	}
+
+	const Light* Scene::AddPointLight(const Vector3& origin, float intensity, const ColorRGB& color)
 	{
 		Light l;
 		l.origin = origin;
@@ -130,10 +413,11 @@ namespace dae {
 		l.type = LightType::Point;
 
 		m_Lights.emplace_back(l);
+		MarkLightsChanged();
 		return &m_Lights.back();
 	}
 
-	Light* Scene::AddDirectionalLight(const Vector3& direction, float intensity, const ColorRGB& color)
+	const Light* Scene::AddDirectionalLight(const Vector3& direction, float intensity, const ColorRGB& color)
 	{
 		Light l;
 		l.direction = direction;
@@ -142,13 +426,59 @@ namespace dae {
 		l.type = LightType::Directional;
 
 		m_Lights.emplace_back(l);
+		MarkLightsChanged();
 		return &m_Lights.back();
 	}
 
-	unsigned char Scene::AddMaterial(Material* pMaterial)
+	const Light* Scene::AddRectLight(const Vector3& origin, const Vector3& halfExtentU, const Vector3& halfExtentV, float intensity, const ColorRGB& color)
 	{
-		m_Materials.push_back(pMaterial);
-		return static_cast<unsigned char>(m_Materials.size() - 1);
+		Light l;
+		l.origin = origin;
+		l.direction = Vector3::Cross(halfExtentU, halfExtentV).Normalized();
+		l.halfExtentU = halfExtentU;
+		l.halfExtentV = halfExtentV;
+		l.intensity = intensity;
+		l.color = color;
+		l.type = LightType::Rect;
+
+		m_Lights.emplace_back(l);
+		MarkLightsChanged();
+		return &m_Lights.back();
+	}
+
+	const Light* Scene::AddDiskLight(const Vector3& origin, const Vector3& normal, float radius, float intensity, const ColorRGB& color)
+	{
+		Light l;
+		l.origin = origin;
+		l.direction = normal.Normalized();
+		l.radius = radius;
+		l.intensity = intensity;
+		l.color = color;
+		l.type = LightType::Disk;
+
+		m_Lights.emplace_back(l);
+		MarkLightsChanged();
+		return &m_Lights.back();
+	}
+
+	const Light* Scene::AddSphereLight(const Vector3& origin, float radius, float intensity, const ColorRGB& color)
+	{
+		Light l;
+		l.origin = origin;
+		l.radius = radius;
+		l.intensity = intensity;
+		l.color = color;
+		l.type = LightType::Sphere;
+
+		m_Lights.emplace_back(l);
+		MarkLightsChanged();
+		return &m_Lights.back();
+	}
+
+	uint32_t Scene::AddMaterial(const Material& material)
+	{
+		m_Materials.push_back(material);
+		return static_cast<uint32_t>(m_Materials.size() - 1);
 	}
 #pragma endregion
 #pragma endregion
@@ -157,12 +487,12 @@ namespace dae {
 	void Scene_W1::Initialize()
 	{
 				//default: Material id0 >> SolidColor Material (RED)
-		constexpr unsigned char matId_Solid_Red = 0;
-		const unsigned char matId_Solid_Blue = AddMaterial(new Material_SolidColor{ colors::Blue });
+		constexpr uint32_t matId_Solid_Red = 0;
+		const uint32_t matId_Solid_Blue = AddMaterial(Material::SolidColor(colors::Blue));
 
-		const unsigned char matId_Solid_Yellow = AddMaterial(new Material_SolidColor{ colors::Yellow });
-		const unsigned char matId_Solid_Green = AddMaterial(new Material_SolidColor{ colors::Green });
-		const unsigned char matId_Solid_Magenta = AddMaterial(new Material_SolidColor{ colors::Magenta });
+		const uint32_t matId_Solid_Yellow = AddMaterial(Material::SolidColor(colors::Yellow));
+		const uint32_t matId_Solid_Green = AddMaterial(Material::SolidColor(colors::Green));
+		const uint32_t matId_Solid_Magenta = AddMaterial(Material::SolidColor(colors::Magenta));
 
 		// Spheres
 		AddSphere({ -25.f, 0.f, 100.f }, 50.f, matId_Solid_Red);
@@ -183,12 +513,12 @@ namespace dae {
 		m_Camera.origin = { 0.0f, 3.0f, -9.0f };
 		m_Camera.fovAngle = 45.0f;
 
-		constexpr unsigned char matId_Solid_Red = 0;
-		const unsigned char matId_Solid_Blue = AddMaterial(new Material_SolidColor{ colors::Blue });
+		constexpr uint32_t matId_Solid_Red = 0;
+		const uint32_t matId_Solid_Blue = AddMaterial(Material::SolidColor(colors::Blue));
 
-		const unsigned char matId_Solid_Yellow = AddMaterial(new Material_SolidColor{ colors::Yellow });
-		const unsigned char matId_Solid_Green = AddMaterial(new Material_SolidColor{ colors::Green });
-		const unsigned char matId_Solid_Magenta = AddMaterial(new Material_SolidColor{ colors::Magenta });
+		const uint32_t matId_Solid_Yellow = AddMaterial(Material::SolidColor(colors::Yellow));
+		const uint32_t matId_Solid_Green = AddMaterial(Material::SolidColor(colors::Green));
+		const uint32_t matId_Solid_Magenta = AddMaterial(Material::SolidColor(colors::Magenta));
 
 		// Planes
 		AddPlane({ -5.f, 0.f, 0.f }, { 1.f, 0.f, 0.f }, matId_Solid_Green);
@@ -216,15 +546,15 @@ namespace dae {
 		m_Camera.origin = { 0.0f, 3.0f, -9.0f };
 		m_Camera.fovAngle = 45.0f;
 
-		const auto matCT_GrayRoughMetal = AddMaterial(new Material_CookTorrence({ 0.972f, 0.960f, 0.915f }, 1.0f, 1.0f));
-		const auto matCT_GrayMediumMetal = AddMaterial(new Material_CookTorrence({ 0.972f, 0.960f, 0.915f }, 1.0f, 0.6f));
-		const auto matCT_GraySmoothMetal = AddMaterial(new Material_CookTorrence({ 0.972f, 0.960f, 0.915f }, 1.0f, 0.1f));
-		const auto matCT_GrayRoughPlastic = AddMaterial(new Material_CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.0f, 1.0f));
-		const auto matCT_GrayMediumPlastic = AddMaterial(new Material_CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.0f, 0.6f));
-		const auto matCT_GraySmoothPlastic = AddMaterial(new Material_CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.0f, 0.1f));
+		const auto matCT_GrayRoughMetal = AddMaterial(Material::CookTorrence({ 0.972f, 0.960f, 0.915f }, 1.0f, 1.0f));
+		const auto matCT_GrayMediumMetal = AddMaterial(Material::CookTorrence({ 0.972f, 0.960f, 0.915f }, 1.0f, 0.6f));
+		const auto matCT_GraySmoothMetal = AddMaterial(Material::CookTorrence({ 0.972f, 0.960f, 0.915f }, 1.0f, 0.1f));
+		const auto matCT_GrayRoughPlastic = AddMaterial(Material::CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.0f, 1.0f));
+		const auto matCT_GrayMediumPlastic = AddMaterial(Material::CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.0f, 0.6f));
+		const auto matCT_GraySmoothPlastic = AddMaterial(Material::CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.0f, 0.1f));
 
-		constexpr unsigned char matId_Solid_Red = 0;
-		const unsigned char matLambert_GrayBlue = AddMaterial(new Material_Lambert{ { 0.49f, 0.57f, 0.57f }, 1.0f });
+		constexpr uint32_t matId_Solid_Red = 0;
+		const uint32_t matLambert_GrayBlue = AddMaterial(Material::Lambert({ 0.49f, 0.57f, 0.57f }, 1.0f));
 
 		// Planes
 		AddPlane({ 0.0f, 0.0f, 10.0f }, { 0.0f, 0.0f, -1.0f }, matLambert_GrayBlue);
@@ -254,8 +584,8 @@ namespace dae {
 		m_Camera.origin = { 0.0f, 1.0f, -5.0f };
 		m_Camera.fovAngle = 45.0f;
 
-		const auto matLambert_GrayBlue = AddMaterial(new Material_Lambert({ 0.49f, 0.57f, 0.57f }, 1.f));
-		const auto matLambert_White = AddMaterial(new Material_Lambert(colors::White, 1.f));
+		const auto matLambert_GrayBlue = AddMaterial(Material::Lambert({ 0.49f, 0.57f, 0.57f }, 1.f));
+		const auto matLambert_White = AddMaterial(Material::Lambert(colors::White, 1.f));
 
 		// Plane
 		AddPlane(Vector3{ 0.f, 0.f, 10.f }, Vector3{ 0.f, 0.f,-1.f }, matLambert_GrayBlue); // BACK
@@ -265,8 +595,7 @@ namespace dae {
 		AddPlane(Vector3{ -5.f, 0.f, 0.f }, Vector3{ 1.f, 0.f,0.f }, matLambert_GrayBlue); // LEFT
 
 		// Triangle Mesh
-		pMesh = AddTriangleMesh(TriangleCullMode::NoCulling, matLambert_White);
-		Utils::ParseOBJ("Resources/simple_cube.obj", pMesh->positions, pMesh->normals, pMesh->indices);
+		pMesh = AddTriangleMeshFromOBJ("Resources/simple_cube.obj", TriangleCullMode::NoCulling, matLambert_White);
 
 		//pMesh->Translate({ 0, 1, 0 });
 		//pMesh->Scale({ 2, 2, 2 });
@@ -291,15 +620,15 @@ namespace dae {
 		m_Camera.origin = { 0.f, 3.f, -9.f };
 		m_Camera.fovAngle = 45.f;
 
-		const auto matCT_GrayRoughMetal = AddMaterial(new Material_CookTorrence({ 0.972f, 0.960f, 0.915f }, 1.f, 1.f));
-		const auto matCT_GrayMediumMetal = AddMaterial(new Material_CookTorrence({ 0.972f, 0.960f, 0.915f }, 1.f, 0.6f));
-		const auto matCT_GraySmoothMetal = AddMaterial(new Material_CookTorrence({ 0.972f, 0.960f, 0.915f }, 1.f, 0.1f));
-		const auto matCT_GrayRoughPlastic = AddMaterial(new Material_CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 1.f));
-		const auto matCT_GrayMediumPlastic = AddMaterial(new Material_CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 0.6f));
-		const auto matCT_GraySmoothPlastic = AddMaterial(new Material_CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 0.1f));
+		const auto matCT_GrayRoughMetal = AddMaterial(Material::CookTorrence({ 0.972f, 0.960f, 0.915f }, 1.f, 1.f));
+		const auto matCT_GrayMediumMetal = AddMaterial(Material::CookTorrence({ 0.972f, 0.960f, 0.915f }, 1.f, 0.6f));
+		const auto matCT_GraySmoothMetal = AddMaterial(Material::CookTorrence({ 0.972f, 0.960f, 0.915f }, 1.f, 0.1f));
+		const auto matCT_GrayRoughPlastic = AddMaterial(Material::CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 1.f));
+		const auto matCT_GrayMediumPlastic = AddMaterial(Material::CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 0.6f));
+		const auto matCT_GraySmoothPlastic = AddMaterial(Material::CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 0.1f));
 
-		const auto matLambert_GrayBlue = AddMaterial(new Material_Lambert({ 0.49f, 0.57f, 0.57f }, 1.f));
-		const auto matLambert_White = AddMaterial(new Material_Lambert(colors::White, 1.f));
+		const auto matLambert_GrayBlue = AddMaterial(Material::Lambert({ 0.49f, 0.57f, 0.57f }, 1.f));
+		const auto matLambert_White = AddMaterial(Material::Lambert(colors::White, 1.f));
 
 		// Planes
 		AddPlane(Vector3{ 0.f, 0.f, 10.f }, Vector3{ 0.f, 0.f,-1.f }, matLambert_GrayBlue); // BACK
@@ -345,8 +674,8 @@ namespace dae {
 		m_Camera.origin = { 0.f, 3.f, -9.f };
 		m_Camera.fovAngle = 45.f;
 
-		const auto matLambert_GrayBlue = AddMaterial(new Material_Lambert({ 0.49f, 0.57f, 0.57f }, 1.f));
-		const auto matLambert_White = AddMaterial(new Material_Lambert(colors::White, 1.f));
+		const auto matLambert_GrayBlue = AddMaterial(Material::Lambert({ 0.49f, 0.57f, 0.57f }, 1.f));
+		const auto matLambert_White = AddMaterial(Material::Lambert(colors::White, 1.f));
 
 		// Planes
 		AddPlane(Vector3{ 0.f, 0.f, 10.f }, Vector3{ 0.f, 0.f,-1.f }, matLambert_GrayBlue); // BACK
@@ -355,8 +684,8 @@ namespace dae {
 		AddPlane(Vector3{ 5.f, 0.f, 0.f }, Vector3{ -1.f, 0.f,0.f }, matLambert_GrayBlue); // RIGHT
 		AddPlane(Vector3{ -5.f, 0.f, 0.f }, Vector3{ 1.f, 0.f,0.f }, matLambert_GrayBlue); // LEFT
 
-		pMesh = AddTriangleMesh(TriangleCullMode::NoCulling, matLambert_White);
-		Utils::ParseOBJ("Resources/lowpoly_bunny.obj", pMesh->positions, pMesh->normals, pMesh->indices);
+		pMesh = AddTriangleMeshFromOBJ("Resources/lowpoly_bunny.obj", TriangleCullMode::NoCulling, matLambert_White);
+		pMesh->UpdateTransforms();
 
 		//Lights
 		AddPointLight(Vector3{ 0.f, 5.f, 5.f }, 50.f, ColorRGB{ 1.f, 0.61f, 0.45f }); // Backlight
@@ -364,4 +693,108 @@ namespace dae {
 		AddPointLight(Vector3{ 2.5f, 2.5f, -5.f }, 50.f, ColorRGB{ 0.34f, 0.47f, 0.68f });
 	}
 #pragma endregion
+
+#pragma region SCENE MANY LIGHTS
+	void Scene_ManyLights::Initialize()
+	{
+		sceneName = "Many Lights Scene";
+		m_Camera.origin = { 0.f, 3.f, -9.f };
+		m_Camera.fovAngle = 45.f;
+
+		const auto matLambert_GrayBlue = AddMaterial(Material::Lambert({ 0.49f, 0.57f, 0.57f }, 1.f));
+		const auto matLambertPhong_White = AddMaterial(Material::LambertPhong(colors::White, 0.5f, 0.5f, 60.f));
+
+		// Planes
+		AddPlane(Vector3{ 0.f, 0.f, 10.f }, Vector3{ 0.f, 0.f,-1.f }, matLambert_GrayBlue); // BACK
+		AddPlane(Vector3{ 0.f, 0.f, 0.f }, Vector3{ 0.f, 1.f,0.f }, matLambert_GrayBlue); // BOTTOM
+		AddPlane(Vector3{ 0.f, 10.f, 0.f }, Vector3{ 0.f, -1.f,0.f }, matLambert_GrayBlue); // TOP
+		AddPlane(Vector3{ 5.f, 0.f, 0.f }, Vector3{ -1.f, 0.f,0.f }, matLambert_GrayBlue); // RIGHT
+		AddPlane(Vector3{ -5.f, 0.f, 0.f }, Vector3{ 1.f, 0.f,0.f }, matLambert_GrayBlue); // LEFT
+
+		// Spheres
+		AddSphere({ -1.75f, 1.f, 2.f }, 0.75f, matLambertPhong_White);
+		AddSphere({ 0.f, 1.f, 2.f }, 0.75f, matLambertPhong_White);
+		AddSphere({ 1.75f, 1.f, 2.f }, 0.75f, matLambertPhong_White);
+		AddSphere({ -1.75f, 3.f, 2.f }, 0.75f, matLambertPhong_White);
+		AddSphere({ 0.f, 3.f, 2.f }, 0.75f, matLambertPhong_White);
+		AddSphere({ 1.75f, 3.f, 2.f }, 0.75f, matLambertPhong_White);
+
+		// Lights, a grid of small warm and cool lights just above the floor, like a city seen from above at night
+		constexpr uint32_t gridSize{ 64 };
+		for (uint32_t z{}; z < gridSize; ++z)
+		{
+			for (uint32_t x{}; x < gridSize; ++x)
+			{
+				const Vector3 origin{ -4.75f + 9.5f * x / (gridSize - 1), 0.25f, -2.f + 11.5f * z / (gridSize - 1) };
+				const float warmth = ((x * 7 + z * 13) % 16) / 15.f;
+				AddPointLight(origin, 0.05f + 0.1f * warmth, ColorRGB{ 1.f, 0.55f + 0.3f * warmth, 0.3f + 0.5f * (1.f - warmth) });
+			}
+		}
+	}
+#pragma endregion
+
+#pragma region SCENE AREA LIGHTS
+	void Scene_AreaLights::Initialize()
+	{
+		sceneName = "Area Lights Scene";
+		m_Camera.origin = { 0.f, 3.f, -9.f };
+		m_Camera.fovAngle = 45.f;
+
+		const auto matLambert_GrayBlue = AddMaterial(Material::Lambert({ 0.49f, 0.57f, 0.57f }, 1.f));
+		const auto matLambertPhong_White = AddMaterial(Material::LambertPhong(colors::White, 0.5f, 0.5f, 60.f));
+		const auto matCT_GrayRoughPlastic = AddMaterial(Material::CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 1.f));
+
+		// Planes
+		AddPlane(Vector3{ 0.f, 0.f, 10.f }, Vector3{ 0.f, 0.f,-1.f }, matLambert_GrayBlue); // BACK
+		AddPlane(Vector3{ 0.f, 0.f, 0.f }, Vector3{ 0.f, 1.f,0.f }, matLambert_GrayBlue); // BOTTOM
+		AddPlane(Vector3{ 0.f, 10.f, 0.f }, Vector3{ 0.f, -1.f,0.f }, matLambert_GrayBlue); // TOP
+		AddPlane(Vector3{ 5.f, 0.f, 0.f }, Vector3{ -1.f, 0.f,0.f }, matLambert_GrayBlue); // RIGHT
+		AddPlane(Vector3{ -5.f, 0.f, 0.f }, Vector3{ 1.f, 0.f,0.f }, matLambert_GrayBlue); // LEFT
+
+		// Spheres
+		AddSphere({ -1.75f, 1.f, 2.f }, 0.75f, matLambertPhong_White);
+		AddSphere({ 0.f, 1.f, 2.f }, 0.75f, matCT_GrayRoughPlastic);
+		AddSphere({ 1.75f, 1.f, 2.f }, 0.75f, matLambertPhong_White);
+
+		// Lights, a soft box above, a disk on the left wall and a small warm bulb, each giving a different penumbra
+		AddRectLight({ 0.f, 9.9f, 2.f }, { 1.5f, 0.f, 0.f }, { 0.f, 0.f, 1.f }, 40.f, ColorRGB{ 1.f, 0.95f, 0.9f });
+		AddDiskLight({ -4.9f, 2.5f, 1.f }, { 1.f, 0.f, 0.f }, 0.75f, 15.f, ColorRGB{ 0.45f, 0.6f, 1.f });
+		AddSphereLight({ 2.5f, 3.f, -0.5f }, 0.35f, 30.f, ColorRGB{ 1.f, 0.7f, 0.4f });
+	}
+#pragma endregion
+
+#pragma region SCENE OUTDOOR
+	void Scene_Outdoor::Initialize()
+	{
+		sceneName = "Outdoor Scene";
+		m_Camera.origin = { 0.f, 3.f, -9.f };
+		m_Camera.fovAngle = 45.f;
+
+		const auto matLambert_Ground = AddMaterial(Material::Lambert({ 0.55f, 0.5f, 0.42f }, 1.f));
+		const auto matLambertPhong_White = AddMaterial(Material::LambertPhong(colors::White, 0.5f, 0.5f, 60.f));
+		const auto matCT_GrayRoughPlastic = AddMaterial(Material::CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 1.f));
+		const auto matCT_GrayMediumMetal = AddMaterial(Material::CookTorrence({ 0.972f, 0.960f, 0.915f }, 1.f, 0.6f));
+		const auto matLambert_Roof = AddMaterial(Material::Lambert({ 0.6f, 0.25f, 0.15f }, 1.f));
+
+		// Ground, open to the sky everywhere else
+		AddPlane(Vector3{ 0.f, 0.f, 0.f }, Vector3{ 0.f, 1.f, 0.f }, matLambert_Ground);
+
+		// Spheres
+		AddSphere({ -1.75f, 1.f, 2.f }, 0.75f, matLambertPhong_White);
+		AddSphere({ 0.f, 1.f, 2.f }, 0.75f, matCT_GrayRoughPlastic);
+		AddSphere({ 1.75f, 1.f, 2.f }, 0.75f, matCT_GrayMediumMetal);
+		AddSphere({ 0.f, 2.75f, 4.f }, 1.f, matLambertPhong_White);
+
+		// A hut with a roof of its own material, from the OBJ's usemtl groups
+		TriangleMesh* pHut = AddTriangleMeshFromOBJ("Resources/simple_object.obj", TriangleCullMode::NoCulling, matLambertPhong_White,
+			{ { "Roof", matLambert_Roof } });
+		pHut->RotateY(PI_DIV_4);
+		pHut->Translate({ 3.5f, 1.f, 6.f });
+		pHut->UpdateTransforms();
+
+		// No lights, only the sky. The sun is a few texels wide and outshines the rest of it, low enough for long shadows
+		m_Environment.CreateSky(1024, 512, { -0.6f, 0.55f, 0.5f }, 0.02f, ColorRGB{ 4000.f, 3600.f, 3000.f },
+			ColorRGB{ 0.25f, 0.4f, 0.8f }, ColorRGB{ 0.75f, 0.8f, 0.9f }, ColorRGB{ 0.3f, 0.27f, 0.22f });
+	}
+#pragma endregion
 }
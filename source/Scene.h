@@ -1,16 +1,21 @@
 #pragma once
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "Math.h"
 #include "DataTypes.h"
 #include "Camera.h"
+#include "AliasTable.h"
+#include "EnvironmentMap.h"
+#include "LightBVH.h"
+#include "Material.h"
+#include "OccluderCache.h"
 
 namespace dae
 {
 	//Forward Declarations
 	class Timer;
-	class Material;
 	struct Plane;
 	struct Sphere;
 	struct Light;
@@ -20,7 +25,7 @@ namespace dae
 	{
 	public:
 		Scene();
-		virtual ~Scene();
+		virtual ~Scene() = default;
 
 		Scene(const Scene&) = delete;
 		Scene(Scene&&) noexcept = delete;
@@ -32,15 +37,33 @@ namespace dae
 		{
 			m_Camera.Update(pTimer);
 		}
+		//Lights and geometry never move, only the camera does, so shadow ray answers can be kept between frames
+		virtual bool IsStatic() const { return true; }
+		//Unique to this scene object and renewed whenever a light is added. Caches kept across frames compare it,
+		//a scene's address can be reused by the next one
+		uint64_t GetGeneration() const { return m_Generation; }
 
 		Camera& GetCamera() { return m_Camera; }
 		void GetClosestHit(const Ray& ray, HitRecord& closestHit) const;
 		bool DoesHit(const Ray& ray) const;
+		//Bit i is set when ray i of the packet hits anything, see DoesHit. The cache is read and updated per packet.lightIndex
+		uint32_t GetOcclusionMask(const RayPacket& packet, OccluderCache* pOccluderCache = nullptr) const;
 
 		const std::vector<Plane>& GetPlaneGeometries() const { return m_PlaneGeometries; }
 		const std::vector<Sphere>& GetSphereGeometries() const { return m_SphereGeometries; }
+		const std::vector<TriangleMesh>& GetTriangleMeshGeometries() const { return m_TriangleMeshGeometries; }
 		const std::vector<Light>& GetLights() const { return m_Lights; }
-		const std::vector<Material*> GetMaterials() const { return m_Materials; }
+		const LightBVH& GetLightBVH() const { return m_LightBVH; }
+		//Point lights weighted by their power, directional lights have no weight
+		const AliasTable& GetLightAliasTable() const { return m_LightAliasTable; }
+		//Gives every point light the radius at which its radiance falls to minRadiance, 0 removes the radii again
+		void SetLightInfluenceThreshold(float minRadiance);
+		//Rebuilds the light hierarchy and alias table if lights were added since the last call
+		void UpdateLights();
+		const std::vector<Material>& GetMaterials() const { return m_Materials; }
+		//Radiance of rays that miss every primitive, an empty map leaves them black
+		EnvironmentMap& GetEnvironment() { return m_Environment; }
+		const EnvironmentMap& GetEnvironment() const { return m_Environment; }
 
 	protected:
 		std::string	sceneName;
@@ -49,17 +72,36 @@ namespace dae
 		std::vector<Sphere> m_SphereGeometries{};
 		std::vector<TriangleMesh> m_TriangleMeshGeometries{};
 		std::vector<Light> m_Lights{};
-		std::vector<Material*> m_Materials{};
+		LightBVH m_LightBVH{};
+		AliasTable m_LightAliasTable{};
+		bool m_AreLightsDirty{ true };
+		uint64_t m_Generation{};
+		std::vector<Material> m_Materials{};
+		EnvironmentMap m_Environment{};
 
 		Camera m_Camera{};
 
-		Sphere* AddSphere(const Vector3& origin, float radius, unsigned char materialIndex = 0);
-		Plane* AddPlane(const Vector3& origin, const Vector3& normal, unsigned char materialIndex = 0);
-		TriangleMesh* AddTriangleMesh(TriangleCullMode cullMode, unsigned char materialIndex = 0);
+		bool DoesOccluderHit(const OccluderCache::Occluder& occluder, const Ray& ray) const;
 
-		Light* AddPointLight(const Vector3& origin, float intensity, const ColorRGB& color);
-		Light* AddDirectionalLight(const Vector3& direction, float intensity, const ColorRGB& color);
-		unsigned char AddMaterial(Material* pMaterial);
+		Sphere* AddSphere(const Vector3& origin, float radius, uint32_t materialIndex = 0);
+		Plane* AddPlane(const Vector3& origin, const Vector3& normal, uint32_t materialIndex = 0);
+		TriangleMesh* AddTriangleMesh(TriangleCullMode cullMode, uint32_t materialIndex = 0);
+		//Loads the OBJ into a new mesh, triangles of usemtl groups named in materialsByName get that material, the rest materialIndex
+		TriangleMesh* AddTriangleMeshFromOBJ(const std::string& filename, TriangleCullMode cullMode, uint32_t materialIndex = 0,
+			const std::unordered_map<std::string, uint32_t>& materialsByName = {});
+
+		//Read only, the light hierarchy and alias table are only rebuilt when a light is added
+		const Light* AddPointLight(const Vector3& origin, float intensity, const ColorRGB& color);
+		const Light* AddDirectionalLight(const Vector3& direction, float intensity, const ColorRGB& color);
+		//Emits towards Cross(halfExtentU, halfExtentV), the extents should be perpendicular
+		const Light* AddRectLight(const Vector3& origin, const Vector3& halfExtentU, const Vector3& halfExtentV, float intensity, const ColorRGB& color);
+		const Light* AddDiskLight(const Vector3& origin, const Vector3& normal, float radius, float intensity, const ColorRGB& color);
+		const Light* AddSphereLight(const Vector3& origin, float radius, float intensity, const ColorRGB& color);
+		uint32_t AddMaterial(const Material& material);
+
+	private:
+		//Rebuilds the light hierarchy and renews the generation
+		void MarkLightsChanged();
 	};
 
 	//+++++++++++++++++++++++++++++++++++++++++
@@ -125,6 +167,7 @@ namespace dae
 
 		void Initialize() override;
 		void Update(Timer* pTimer) override;
+		bool IsStatic() const override { return false; }
 
 	private:
 		TriangleMesh* pMesh{ nullptr };
@@ -167,4 +210,52 @@ namespace dae
 	private:
 		TriangleMesh* pMesh{ nullptr };
 	};
+
+	//+++++++++++++++++++++++++++++++++++++++++
+	//MANY LIGHTS Scene
+	class Scene_ManyLights final : public Scene
+	{
+	public:
+		Scene_ManyLights() = default;
+		~Scene_ManyLights() override = default;
+
+		Scene_ManyLights(const Scene_ManyLights&) = delete;
+		Scene_ManyLights(Scene_ManyLights&&) noexcept = delete;
+		Scene_ManyLights& operator=(const Scene_ManyLights&) = delete;
+		Scene_ManyLights& operator=(Scene_ManyLights&&) noexcept = delete;
+
+		void Initialize() override;
+	};
+
+	//+++++++++++++++++++++++++++++++++++++++++
+	//AREA LIGHTS Scene
+	class Scene_AreaLights final : public Scene
+	{
+	public:
+		Scene_AreaLights() = default;
+		~Scene_AreaLights() override = default;
+
+		Scene_AreaLights(const Scene_AreaLights&) = delete;
+		Scene_AreaLights(Scene_AreaLights&&) noexcept = delete;
+		Scene_AreaLights& operator=(const Scene_AreaLights&) = delete;
+		Scene_AreaLights& operator=(Scene_AreaLights&&) noexcept = delete;
+
+		void Initialize() override;
+	};
+
+	//+++++++++++++++++++++++++++++++++++++++++
+	//OUTDOOR Scene
+	class Scene_Outdoor final : public Scene
+	{
+	public:
+		Scene_Outdoor() = default;
+		~Scene_Outdoor() override = default;
+
+		Scene_Outdoor(const Scene_Outdoor&) = delete;
+		Scene_Outdoor(Scene_Outdoor&&) noexcept = delete;
+		Scene_Outdoor& operator=(const Scene_Outdoor&) = delete;
+		Scene_Outdoor& operator=(Scene_Outdoor&&) noexcept = delete;
+
+		void Initialize() override;
+	};
 }
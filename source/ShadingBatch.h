@@ -0,0 +1,164 @@
+#pragma once
+#include <cstdint>
+
+#include "FloatLanes.h"
+#include "Material.h"
+
+namespace dae
+{
+	/**
+	 * \brief Up to maxSize shading points of one material type, stored per component so Shade evaluates the BRDF
+	 * of all of them with FloatLanes instead of one Material::Shade call each. It evaluates the BRDF::Fast formulas,
+	 * so it only serves BRDF::Precision::Fast. Only LambertPhong and CookTorrence are batched, the BRDF of Lambert and
+	 * solid colors is a constant of the material. Lanes past count hold whatever the previous batch left there, they are
+	 * shaded along and ignored.
+	 */
+	struct ShadingBatch
+	{
+		static constexpr uint32_t maxSize{ 8 };
+		static_assert(maxSize % FloatLanes::width == 0, "Shade steps through the batch a full register at a time");
+
+		alignas(32) float normalX[maxSize]{}, normalY[maxSize]{}, normalZ[maxSize]{};
+		alignas(32) float lightDirectionX[maxSize]{}, lightDirectionY[maxSize]{}, lightDirectionZ[maxSize]{};
+		alignas(32) float viewDirectionX[maxSize]{}, viewDirectionY[maxSize]{}, viewDirectionZ[maxSize]{};
+
+		//Material of every point, see Material for what the parameters mean per type
+		alignas(32) float colorR[maxSize]{}, colorG[maxSize]{}, colorB[maxSize]{};
+		alignas(32) float param0[maxSize]{}, param1[maxSize]{}, param2[maxSize]{};
+		alignas(32) float f0R[maxSize]{}, f0G[maxSize]{}, f0B[maxSize]{};
+		alignas(32) float alphaSquared[maxSize]{}, geometryK[maxSize]{};
+
+		//Written by Shade
+		alignas(32) float brdfR[maxSize]{}, brdfG[maxSize]{}, brdfB[maxSize]{};
+
+		uint32_t count{};
+
+		bool IsFull() const { return count == maxSize; }
+
+		static constexpr bool IsBatched(MaterialType type) { return type == MaterialType::LambertPhong || type == MaterialType::CookTorrence; }
+
+		//Appends a point, with only what shading the material as shadedType reads
+		template<MaterialType shadedType>
+		void Add(const Material& material, const Vector3& normal, const Vector3& lightDirection, const Vector3& viewDirection);
+
+		ColorRGB GetBRDF(uint32_t i) const { return { brdfR[i], brdfG[i], brdfB[i] }; }
+
+		//Material::Shade<shadedType> with BRDF::Precision::Fast for every point, into brdfR/G/B
+		template<MaterialType shadedType>
+		void Shade();
+	};
+
+	template<MaterialType shadedType>
+	void ShadingBatch::Add(const Material& material, const Vector3& normal, const Vector3& lightDirection, const Vector3& viewDirection)
+	{
+		static_assert(IsBatched(shadedType), "Lambert and solid colors are shaded per point");
+
+		const uint32_t i = count++;
+		colorR[i] = material.color.r; colorG[i] = material.color.g; colorB[i] = material.color.b;
+		param0[i] = material.param0;
+		normalX[i] = normal.x; normalY[i] = normal.y; normalZ[i] = normal.z;
+		lightDirectionX[i] = lightDirection.x; lightDirectionY[i] = lightDirection.y; lightDirectionZ[i] = lightDirection.z;
+		viewDirectionX[i] = viewDirection.x; viewDirectionY[i] = viewDirection.y; viewDirectionZ[i] = viewDirection.z;
+
+		if constexpr (shadedType == MaterialType::LambertPhong)
+		{
+			param1[i] = material.param1;
+			param2[i] = material.param2;
+		}
+		else if constexpr (shadedType == MaterialType::CookTorrence)
+		{
+			f0R[i] = material.f0.r; f0G[i] = material.f0.g; f0B[i] = material.f0.b;
+			alphaSquared[i] = material.alphaSquared;
+			geometryK[i] = material.geometryK;
+		}
+	}
+
+	template<MaterialType shadedType>
+	void ShadingBatch::Shade()
+	{
+		static_assert(IsBatched(shadedType), "Lambert and solid colors are shaded per point");
+
+		using Lanes = FloatLanes;
+
+		const Lanes zero = Lanes::Broadcast(0.f);
+		const Lanes one = Lanes::Broadcast(1.f);
+		const Lanes pi = Lanes::Broadcast(PI);
+
+		for (uint32_t i{}; i < count; i += Lanes::width)
+		{
+			const Lanes cR = Lanes::Load(colorR + i), cG = Lanes::Load(colorG + i), cB = Lanes::Load(colorB + i);
+
+			if constexpr (shadedType == MaterialType::LambertPhong)
+			{
+				const Lanes nX = Lanes::Load(normalX + i), nY = Lanes::Load(normalY + i), nZ = Lanes::Load(normalZ + i);
+				const Lanes lX = Lanes::Load(lightDirectionX + i), lY = Lanes::Load(lightDirectionY + i), lZ = Lanes::Load(lightDirectionZ + i);
+				const Lanes vX = Lanes::Load(viewDirectionX + i), vY = Lanes::Load(viewDirectionY + i), vZ = Lanes::Load(viewDirectionZ + i);
+
+				// reflected light direction against the direction towards the viewer, as BRDF::Phong
+				const Lanes twoDotNL = Lanes::Broadcast(2.f) * (nX * lX + nY * lY + nZ * lZ);
+				const Lanes cosAlpha = (lX - twoDotNL * nX) * (zero - vX) + (lY - twoDotNL * nY) * (zero - vY) + (lZ - twoDotNL * nZ) * (zero - vZ);
+
+				// BRDF::Fast::Pow needs integer lanes FloatLanes does not have, it does not branch so the compiler vectorizes this loop
+				alignas(32) float cosines[Lanes::width];
+				alignas(32) float powers[Lanes::width];
+				cosAlpha.Store(cosines);
+				for (uint32_t lane{}; lane < Lanes::width; ++lane)
+					powers[lane] = BRDF::Fast::Pow(cosines[lane], param2[i + lane]);
+
+				const Lanes kd = Lanes::Load(param0 + i);
+				const Lanes reflection = Lanes::Load(param1 + i) * Lanes::Load(powers);
+				(kd * cR / pi + reflection).Store(brdfR + i);
+				(kd * cG / pi + reflection).Store(brdfG + i);
+				(kd * cB / pi + reflection).Store(brdfB + i);
+			}
+			else if constexpr (shadedType == MaterialType::CookTorrence)
+			{
+				const Lanes nX = Lanes::Load(normalX + i), nY = Lanes::Load(normalY + i), nZ = Lanes::Load(normalZ + i);
+				const Lanes lX = Lanes::Load(lightDirectionX + i), lY = Lanes::Load(lightDirectionY + i), lZ = Lanes::Load(lightDirectionZ + i);
+				const Lanes toViewX = zero - Lanes::Load(viewDirectionX + i);
+				const Lanes toViewY = zero - Lanes::Load(viewDirectionY + i);
+				const Lanes toViewZ = zero - Lanes::Load(viewDirectionZ + i);
+
+				Lanes hX = lX + toViewX, hY = lY + toViewY, hZ = lZ + toViewZ;
+				const Lanes halfLength = Lanes::Sqrt(hX * hX + hY * hY + hZ * hZ);
+				hX = hX / halfLength;
+				hY = hY / halfLength;
+				hZ = hZ / halfLength;
+
+				const Lanes dotNH = nX * hX + nY * hY + nZ * hZ;
+				const Lanes dotNV = nX * toViewX + nY * toViewY + nZ * toViewZ;
+				const Lanes dotNL = nX * lX + nY * lY + nZ * lZ;
+
+				// BRDF::Fast::FresnelFunction_Schlick
+				const Lanes x = one - (hX * toViewX + hY * toViewY + hZ * toViewZ);
+				const Lanes x2 = x * x;
+				const Lanes x5 = x2 * x2 * x;
+				const Lanes f0r = Lanes::Load(f0R + i), f0g = Lanes::Load(f0G + i), f0b = Lanes::Load(f0B + i);
+				const Lanes fresnelR = f0r + x5 * (one - f0r);
+				const Lanes fresnelG = f0g + x5 * (one - f0g);
+				const Lanes fresnelB = f0b + x5 * (one - f0b);
+
+				// BRDF::Fast::NormalDistribution_GGX
+				const Lanes a2 = Lanes::Load(alphaSquared + i);
+				const Lanes denominator = dotNH * dotNH * (a2 - one) + one;
+				const Lanes distribution = a2 / (pi * denominator * denominator);
+
+				// BRDF::Fast::GeometryFunction_Smith
+				const Lanes k = Lanes::Load(geometryK + i);
+				const Lanes geometry = dotNV / (dotNV * (one - k) + k) * (dotNL / (dotNL * (one - k) + k));
+
+				const Lanes specular = distribution * geometry / (Lanes::Broadcast(4.f) * dotNV * dotNL);
+
+				// dielectrics diffuse what they do not reflect, metals nothing
+				const Lanes isDielectric = Lanes::LessThan(Lanes::Load(param0 + i), Lanes::Broadcast(FLT_EPSILON));
+				const Lanes kdR = Lanes::Select(isDielectric, one - fresnelR, zero);
+				const Lanes kdG = Lanes::Select(isDielectric, one - fresnelG, zero);
+				const Lanes kdB = Lanes::Select(isDielectric, one - fresnelB, zero);
+
+				(kdR * cR / pi + specular * fresnelR).Store(brdfR + i);
+				(kdG * cG / pi + specular * fresnelG).Store(brdfG + i);
+				(kdB * cB / pi + specular * fresnelB).Store(brdfB + i);
+			}
+		}
+	}
+}
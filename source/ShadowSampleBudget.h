@@ -0,0 +1,89 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace dae
+{
+	/**
+	 * \brief Spreads a per-frame shadow sample budget over area lights. Every shading point takes a small stratified
+	 * grid of samples per area light, and only where those disagree, in a penumbra, a second finer grid is added.
+	 * Its size for the next frame is picked from the last frame's counts so the frame is expected to land on the budget.
+	 */
+	class ShadowSampleBudget final
+	{
+	public:
+		struct Settings
+		{
+			uint32_t baseGridSize{ 4 }; //every shading point takes baseGridSize^2 samples per area light
+			uint32_t maxPenumbraGridSize{ 12 }; //penumbra points add up to maxPenumbraGridSize^2 more
+			size_t frameBudget{}; //shadow samples per frame, 0 always refines with the largest grid. The base grids are always taken
+		};
+
+		struct Statistics
+		{
+			size_t shadingPointCount{}; //per area light
+			size_t penumbraCount{};
+			size_t baseSampleCount{}; //traced shadow rays, samples off the light or below the surface are not traced
+			size_t penumbraSampleCount{};
+
+			size_t GetSampleCount() const { return baseSampleCount + penumbraSampleCount; }
+			float GetPenumbraFraction() const { return shadingPointCount > 0 ? penumbraCount / float(shadingPointCount) : 0.f; }
+		};
+
+		/**
+		 * \param expectedShadingPointCount shading points times area lights, only used before the first frame
+		 * gave real counts, then every point is assumed to be in a penumbra
+		 */
+		void BeginFrame(size_t expectedShadingPointCount)
+		{
+			const size_t baseSampleCount = m_HasHistory ? m_LastStatistics.baseSampleCount : expectedShadingPointCount * m_Settings.baseGridSize * m_Settings.baseGridSize;
+			const size_t penumbraCount = m_HasHistory ? m_LastStatistics.penumbraCount : expectedShadingPointCount;
+
+			m_PenumbraGridSize = m_Settings.maxPenumbraGridSize;
+			if (m_Settings.frameBudget > 0 && penumbraCount > 0)
+			{
+				const size_t spare = m_Settings.frameBudget > baseSampleCount ? m_Settings.frameBudget - baseSampleCount : 0;
+				const uint32_t gridSize = static_cast<uint32_t>(sqrtf(spare / float(penumbraCount)));
+				m_PenumbraGridSize = std::min(gridSize, m_Settings.maxPenumbraGridSize);
+			}
+
+			m_Statistics = {};
+		}
+
+		void EndFrame()
+		{
+			// a frame without area light shading says nothing about the next one
+			if (m_Statistics.shadingPointCount == 0)
+				return;
+
+			m_LastStatistics = m_Statistics;
+			m_HasHistory = true;
+		}
+
+		void Invalidate() { m_HasHistory = false; }
+
+		uint32_t GetPenumbraGridSize() const { return m_PenumbraGridSize; }
+
+		void AddShadingPoint(uint32_t baseSampleCount, uint32_t penumbraSampleCount, bool isPenumbra)
+		{
+			++m_Statistics.shadingPointCount;
+			m_Statistics.penumbraCount += isPenumbra ? 1 : 0;
+			m_Statistics.baseSampleCount += baseSampleCount;
+			m_Statistics.penumbraSampleCount += penumbraSampleCount;
+		}
+
+		Settings& GetSettings() { return m_Settings; }
+		const Settings& GetSettings() const { return m_Settings; }
+		const Statistics& GetStatistics() const { return m_Statistics; }
+
+	private:
+		Settings m_Settings{};
+		Statistics m_Statistics{};
+		Statistics m_LastStatistics{};
+		bool m_HasHistory{ false };
+
+		uint32_t m_PenumbraGridSize{};
+	};
+}
@@ -0,0 +1,54 @@
+#include "TileLightCuller.h"
+
+#include <cmath>
+
+#include "Camera.h"
+#include "DataTypes.h"
+
+namespace dae
+{
+	void TileLightCuller::BuildLightList(const std::vector<Light>& lights, const CameraFrame& cameraFrame, int x, int y, int width, int height, float minDepth, float maxDepth)
+	{
+		m_LightList.clear();
+
+		// the tile's side planes pass through the camera, in camera space a point is inside when
+		// xMin <= x / z <= xMax and yMin <= y / z <= yMax, same mapping as CameraFrame::GetViewRay
+		const float scaleX = cameraFrame.aspectRatio * cameraFrame.fov;
+		const float xMin = ((2.f * x / cameraFrame.width) - 1) * scaleX;
+		const float xMax = ((2.f * (x + width) / cameraFrame.width) - 1) * scaleX;
+		const float yMax = (1 - (2.f * y / cameraFrame.height)) * cameraFrame.fov;
+		const float yMin = (1 - (2.f * (y + height) / cameraFrame.height)) * cameraFrame.fov;
+
+		// a plane x = s * z has the normal (1, 0, -s) / sqrt(1 + s^2)
+		const float xMinScale = 1.f / sqrtf(1.f + xMin * xMin);
+		const float xMaxScale = 1.f / sqrtf(1.f + xMax * xMax);
+		const float yMinScale = 1.f / sqrtf(1.f + yMin * yMin);
+		const float yMaxScale = 1.f / sqrtf(1.f + yMax * yMax);
+
+		for (uint32_t lightIndex{}; lightIndex < lights.size(); ++lightIndex)
+		{
+			const Light& light = lights[lightIndex];
+			const float radius = light.influenceRadius;
+
+			if (light.type != LightType::Point || radius <= 0.f)
+			{
+				m_LightList.push_back(lightIndex);
+				continue;
+			}
+
+			// conservative, a sphere near a frustum corner may pass all planes without touching the frustum
+			const Vector3 center = cameraFrame.worldToCamera.TransformPoint(light.origin);
+			if (center.z + radius < minDepth || center.z - radius > maxDepth)
+				continue;
+			if ((xMin * center.z - center.x) * xMinScale > radius || (center.x - xMax * center.z) * xMaxScale > radius)
+				continue;
+			if ((yMin * center.z - center.y) * yMinScale > radius || (center.y - yMax * center.z) * yMaxScale > radius)
+				continue;
+
+			m_LightList.push_back(lightIndex);
+		}
+
+		++m_Statistics.tileCount;
+		m_Statistics.lightCount += m_LightList.size();
+	}
+}
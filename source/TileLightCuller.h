@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dae
+{
+	struct CameraFrame;
+	struct Light;
+
+	/**
+	 * \brief Clustered shading on the CPU: before a screen tile is shaded, its primary hits give the range of depths
+	 * it covers, and only lights whose influence sphere overlaps the tile's frustum between those depths make its
+	 * light list. Lights without an influence radius, and directional lights, are in every list.
+	 */
+	class TileLightCuller final
+	{
+	public:
+		struct Settings
+		{
+			int tileSize{ 16 }; //pixels along each side of a tile
+		};
+
+		struct Statistics
+		{
+			size_t tileCount{};
+			size_t lightCount{}; //summed over all tile lists
+
+			float GetAverageLightCount() const { return tileCount > 0 ? lightCount / float(tileCount) : 0.f; }
+		};
+
+		TileLightCuller() = default;
+		~TileLightCuller() = default;
+
+		TileLightCuller(const TileLightCuller&) = delete;
+		TileLightCuller(TileLightCuller&&) noexcept = delete;
+		TileLightCuller& operator=(const TileLightCuller&) = delete;
+		TileLightCuller& operator=(TileLightCuller&&) noexcept = delete;
+
+		/**
+		 * \brief Replaces the light list with the lights that can reach the tile
+		 * \param x, y, width, height tile in pixels of the camera frame
+		 * \param minDepth, maxDepth range of the tile's hits along the camera's forward axis
+		 */
+		void BuildLightList(const std::vector<Light>& lights, const CameraFrame& cameraFrame, int x, int y, int width, int height, float minDepth, float maxDepth);
+		const std::vector<uint32_t>& GetLightList() const { return m_LightList; }
+
+		Settings& GetSettings() { return m_Settings; }
+		const Statistics& GetStatistics() const { return m_Statistics; }
+		void ResetStatistics() { m_Statistics = {}; }
+
+	private:
+		Settings m_Settings{};
+		Statistics m_Statistics{};
+
+		std::vector<uint32_t> m_LightList{};
+	};
+}
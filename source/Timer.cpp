@@ -1,16 +1,25 @@
 #include "Timer.h"
-#include "SDL.h"
+
+#include <chrono>
 using namespace dae;
 
+namespace
+{
+	uint64_t GetPerformanceCounter()
+	{
+		return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+	}
+}
+
 Timer::Timer()
 {
-	const uint64_t countsPerSecond = SDL_GetPerformanceFrequency();
-	m_SecondsPerCount = 1.0f / static_cast<float>(countsPerSecond);
+	const double secondsPerCount = std::chrono::steady_clock::period::num / static_cast<double>(std::chrono::steady_clock::period::den);
+	m_SecondsPerCount = static_cast<float>(secondsPerCount);
 }
 
 void Timer::Reset()
 {
-	const uint64_t currentTime = SDL_GetPerformanceCounter();
+	const uint64_t currentTime = GetPerformanceCounter();
 
 	m_BaseTime = currentTime;
 	m_PreviousTime = currentTime;
@@ -22,7 +31,7 @@ void Timer::Reset()
 
 void Timer::Start()
 {
-	const uint64_t startTime = SDL_GetPerformanceCounter();
+	const uint64_t startTime = GetPerformanceCounter();
 
 	if (m_IsStopped)
 	{
@@ -44,12 +53,18 @@ void Timer::Update()
 		return;
 	}
 
-	const uint64_t currentTime = SDL_GetPerformanceCounter();
+	const uint64_t currentTime = GetPerformanceCounter();
 	m_CurrentTime = currentTime;
 
 	m_ElapsedTime = (float)((m_CurrentTime - m_PreviousTime) * m_SecondsPerCount);
 	m_PreviousTime = m_CurrentTime;
 
+	if (m_FixedElapsedTime > 0.0f)
+	{
+		m_ElapsedTime = m_FixedElapsedTime;
+		m_FixedTotalTime += m_FixedElapsedTime;
+	}
+
 	if (m_ElapsedTime < 0.0f)
 		m_ElapsedTime = 0.0f;
 
@@ -59,6 +74,8 @@ void Timer::Update()
 	}
 
 	m_TotalTime = (float)(((m_CurrentTime - m_PausedTime) - m_BaseTime) * m_SecondsPerCount);
+	if (m_FixedElapsedTime > 0.0f)
+		m_TotalTime = m_FixedTotalTime;
 
 	//FPS LOGIC
 	m_FPSTimer += m_ElapsedTime;
@@ -76,7 +93,7 @@ void Timer::Stop()
 {
 	if (!m_IsStopped)
 	{
-		const uint64_t currentTime = SDL_GetPerformanceCounter();
+		const uint64_t currentTime = GetPerformanceCounter();
 
 		m_StopTime = currentTime;
 		m_IsStopped = true;
@@ -21,6 +21,9 @@ namespace dae
 		void Update();
 		void Stop();
 
+		//Advances by a constant step per Update instead of wall clock time, used for deterministic offline renders
+		void SetFixedElapsed(float elapsedTime) { m_FixedElapsedTime = elapsedTime; }
+
 		uint32_t GetFPS() const { return m_FPS; };
 		float GetdFPS() const { return m_dFPS; };
 		float GetElapsed() const { return m_ElapsedTime; };
@@ -43,6 +46,8 @@ namespace dae
 		float m_SecondsPerCount = 0.0f;
 		float m_ElapsedUpperBound = 0.03f;
 		float m_FPSTimer = 0.0f;
+		float m_FixedElapsedTime = 0.0f;
+		float m_FixedTotalTime = 0.0f;
 
 		bool m_IsStopped = true;
 		bool m_ForceElapsedUpperBound = false;
@@ -1,6 +1,10 @@
 #pragma once
+#include <algorithm>
 #include <cassert>
 #include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include "Math.h"
 #include "DataTypes.h"
 
@@ -95,7 +99,7 @@ namespace dae
 				}
 			}
 
-			auto L = triangle.v0 + triangle.v1 + triangle.v2 / 3 - ray.origin;
+			auto L = triangle.v0 - ray.origin;
 			auto t = Vector3::Dot(L, triangle.normal) / Vector3::Dot(ray.direction, triangle.normal);
 
 			// out of range of ray
@@ -149,7 +153,7 @@ namespace dae
 			{
 				Triangle triangle = { mesh.transformedPositions[mesh.indices[i]], mesh.transformedPositions[mesh.indices[i + 1]], mesh.transformedPositions[mesh.indices[i + 2]] };
 				triangle.normal = mesh.transformedNormals[i / 3];
-				triangle.materialIndex = mesh.materialIndex;
+				triangle.materialIndex = mesh.GetMaterialIndex(i / 3);
 				triangle.cullMode = mesh.cullMode;
 
 				HitRecord lastHit;
@@ -176,43 +180,254 @@ namespace dae
 
 	namespace LightUtils
 	{
-		//Direction from target to light
+		//Directional lights are treated as this far away, beyond any scene geometry but still safe to square
+		constexpr float DIRECTIONAL_LIGHT_DISTANCE{ 1e6f };
+
+		inline bool IsAreaLight(const Light& light)
+		{
+			return light.type == LightType::Rect || light.type == LightType::Disk || light.type == LightType::Sphere;
+		}
+
+		//Direction from target to light, area lights are approximated by their center
 		inline Vector3 GetDirectionToLight(const Light& light, const Vector3 origin)
 		{
-			if (light.type == LightType::Point)
+			if (light.type == LightType::Directional)
 			{
-				return light.origin - origin;
-			}
-			else
-			{
-				// shrug
+				return -light.direction.Normalized() * DIRECTIONAL_LIGHT_DISTANCE;
 			}
+
+			return light.origin - origin;
+		}
+
+		//Distance at which a point light's brightest color channel falls to minRadiance
+		inline float GetInfluenceRadius(const Light& light, float minRadiance)
+		{
+			return sqrtf(light.intensity * std::max({ light.color.r, light.color.g, light.color.b }) / minRadiance);
 		}
 
 		inline ColorRGB GetRadiance(const Light& light, const Vector3& target)
 		{
 			if (light.type == LightType::Point)
 			{
-				return light.color * light.intensity / (light.origin - target).SqrMagnitude();
+				const float sqrDistance = (light.origin - target).SqrMagnitude();
+				if (light.influenceRadius > 0.f && sqrDistance > light.influenceRadius * light.influenceRadius)
+				{
+					return {};
+				}
+
+				return light.color * light.intensity / sqrDistance;
+			}
+			else if (IsAreaLight(light))
+			{
+				// unshadowed estimate as if all of it were at the center, SampleAreaLight gives the exact integrand
+				const Vector3 toTarget = target - light.origin;
+				const float sqrDistance = toTarget.SqrMagnitude();
+
+				float projectedArea{ PI * light.radius * light.radius };
+				if (light.type != LightType::Sphere)
+				{
+					const float area = light.type == LightType::Rect ? 4.f * Vector3::Cross(light.halfExtentU, light.halfExtentV).Magnitude() : projectedArea;
+					projectedArea = area * std::max(Vector3::Dot(light.direction, toTarget) / sqrtf(sqrDistance), 0.f);
+				}
+
+				return light.color * (light.intensity * projectedArea / sqrDistance);
 			}
 			else
 			{
 				return light.color * light.intensity;
 			}
 		}
+
+		//Two unit vectors perpendicular to the unit vector n and to each other (Duff et al. 2017)
+		inline void GetOrthonormalBasis(const Vector3& n, Vector3& tangent, Vector3& bitangent)
+		{
+			const float sign = n.z >= 0.f ? 1.f : -1.f;
+			const float a = -1.f / (sign + n.z);
+			const float b = n.x * n.y * a;
+			tangent = Vector3{ 1.f + sign * n.x * n.x * a, sign * b, -sign * n.x };
+			bitangent = Vector3{ b, sign + n.y * n.y * a, -n.y };
+		}
+
+		//Solid angle sampling of a rectangle (Urena et al. 2013), uniform over the part of the sphere of directions it covers
+		inline bool SampleRectLight(const Light& light, const Vector3& point, float u, float v, Vector3& direction, float& distance, float& pdf)
+		{
+			const Vector3 corner = light.origin - light.halfExtentU - light.halfExtentV;
+			if (Vector3::Dot(point - light.origin, light.direction) <= 0.f)
+				return false;
+
+			const float extentX = 2.f * light.halfExtentU.Magnitude();
+			const float extentY = 2.f * light.halfExtentV.Magnitude();
+			const Vector3 axisX = light.halfExtentU / (0.5f * extentX);
+			const Vector3 axisY = light.halfExtentV / (0.5f * extentY);
+			Vector3 axisZ = Vector3::Cross(axisX, axisY);
+
+			// local frame with the point at the origin and the rectangle at z0 < 0
+			const Vector3 toCorner = corner - point;
+			float z0 = Vector3::Dot(toCorner, axisZ);
+			if (z0 > 0.f)
+			{
+				axisZ = -axisZ;
+				z0 = -z0;
+			}
+
+			const float x0 = Vector3::Dot(toCorner, axisX);
+			const float y0 = Vector3::Dot(toCorner, axisY);
+			const float x1 = x0 + extentX;
+			const float y1 = y0 + extentY;
+
+			// normals of the spherical rectangle's edges, and its interior angles
+			const Vector3 v00{ x0, y0, z0 };
+			const Vector3 v01{ x0, y1, z0 };
+			const Vector3 v10{ x1, y0, z0 };
+			const Vector3 v11{ x1, y1, z0 };
+			const Vector3 n0 = Vector3::Cross(v00, v10).Normalized();
+			const Vector3 n1 = Vector3::Cross(v10, v11).Normalized();
+			const Vector3 n2 = Vector3::Cross(v11, v01).Normalized();
+			const Vector3 n3 = Vector3::Cross(v01, v00).Normalized();
+
+			const float g0 = acosf(std::clamp(-Vector3::Dot(n0, n1), -1.f, 1.f));
+			const float g1 = acosf(std::clamp(-Vector3::Dot(n1, n2), -1.f, 1.f));
+			const float g2 = acosf(std::clamp(-Vector3::Dot(n2, n3), -1.f, 1.f));
+			const float g3 = acosf(std::clamp(-Vector3::Dot(n3, n0), -1.f, 1.f));
+
+			const float k = PI_2 - g2 - g3;
+			const float solidAngle = g0 + g1 - k;
+			if (solidAngle <= 1e-7f)
+				return false;
+
+			// u picks the x coordinate by the solid angle left of it
+			const float au = u * solidAngle + k;
+			const float fu = (cosf(au) * n0.z - n2.z) / sinf(au);
+			const float cu = std::clamp((fu > 0.f ? 1.f : -1.f) / sqrtf(fu * fu + n0.z * n0.z), -1.f, 1.f);
+			const float xu = std::clamp(-(cu * z0) / std::max(sqrtf(1.f - cu * cu), 1e-7f), x0, x1);
+
+			// v picks y uniformly in the projected height of that column
+			const float d = sqrtf(xu * xu + z0 * z0);
+			const float h0 = y0 / sqrtf(d * d + y0 * y0);
+			const float h1 = y1 / sqrtf(d * d + y1 * y1);
+			const float hv = h0 + v * (h1 - h0);
+			const float yv = hv * hv < 1.f - 1e-6f ? (hv * d) / sqrtf(1.f - hv * hv) : y1;
+
+			direction = axisX * xu + axisY * yv + axisZ * z0;
+			distance = direction.Normalize();
+			pdf = 1.f / solidAngle;
+			return true;
+		}
+
+		//Uniform over the cone of directions the sphere covers
+		inline bool SampleSphereLight(const Light& light, const Vector3& point, float u, float v, Vector3& direction, float& distance, float& pdf)
+		{
+			Vector3 toCenter = light.origin - point;
+			const float centerDistance = toCenter.Normalize();
+			if (centerDistance <= light.radius)
+				return false;
+
+			// 1 - cos written through the sine, which keeps small, far away lights from cancelling to 0
+			const float sinThetaMax2 = light.radius * light.radius / (centerDistance * centerDistance);
+			const float cosThetaMax = sqrtf(std::max(1.f - sinThetaMax2, 0.f));
+			const float oneMinusCosThetaMax = sinThetaMax2 / (1.f + cosThetaMax);
+
+			const float cosTheta = 1.f - u * oneMinusCosThetaMax;
+			const float sinTheta = sqrtf(std::max(1.f - cosTheta * cosTheta, 0.f));
+			const float phi = PI_2 * v;
+
+			Vector3 tangent{}, bitangent{};
+			GetOrthonormalBasis(toCenter, tangent, bitangent);
+			direction = tangent * (sinTheta * cosf(phi)) + bitangent * (sinTheta * sinf(phi)) + toCenter * cosTheta;
+
+			// nearest intersection with the sphere along the direction
+			const float projection = centerDistance * cosTheta;
+			const float halfChord2 = light.radius * light.radius - (centerDistance * centerDistance - projection * projection);
+			distance = projection - sqrtf(std::max(halfChord2, 0.f));
+			pdf = 1.f / (PI_2 * oneMinusCosThetaMax);
+			return true;
+		}
+
+		//Uniform over the disk's area (concentric mapping, Shirley and Chiu 1997), the pdf converted to solid angle
+		inline bool SampleDiskLight(const Light& light, const Vector3& point, float u, float v, Vector3& direction, float& distance, float& pdf)
+		{
+			const float a = 2.f * u - 1.f;
+			const float b = 2.f * v - 1.f;
+
+			float r{}, phi{};
+			if (a * a > b * b)
+			{
+				r = a;
+				phi = (PI / 4.f) * (b / a);
+			}
+			else if (b != 0.f)
+			{
+				r = b;
+				phi = PI / 2.f - (PI / 4.f) * (a / b);
+			}
+
+			Vector3 tangent{}, bitangent{};
+			GetOrthonormalBasis(light.direction, tangent, bitangent);
+			const Vector3 samplePoint = light.origin + (tangent * cosf(phi) + bitangent * sinf(phi)) * (r * light.radius);
+
+			direction = samplePoint - point;
+			distance = direction.Normalize();
+
+			const float cosLight = -Vector3::Dot(direction, light.direction);
+			if (cosLight <= 0.f)
+				return false;
+
+			pdf = distance * distance / (PI * light.radius * light.radius * cosLight);
+			return true;
+		}
+
+		/**
+		 * \brief Picks a point on an area light as seen from point
+		 * \param u, v uniform random numbers in [0, 1), stratifying them stratifies the light
+		 * \param direction unit direction from point towards the light
+		 * \param distance to the light along direction
+		 * \param pdf of direction per unit solid angle, the sample adds radiance / pdf
+		 * \return false when the light cannot be seen from point, or the sample falls on its back
+		 */
+		inline bool SampleAreaLight(const Light& light, const Vector3& point, float u, float v, Vector3& direction, float& distance, float& pdf)
+		{
+			switch (light.type)
+			{
+			case LightType::Rect:
+				return SampleRectLight(light, point, u, v, direction, distance, pdf);
+			case LightType::Disk:
+				return SampleDiskLight(light, point, u, v, direction, distance, pdf);
+			case LightType::Sphere:
+				return SampleSphereLight(light, point, u, v, direction, distance, pdf);
+			default:
+				return false;
+			}
+		}
 	}
 
 	namespace Utils
 	{
-		//Just parses vertices and indices
+		/**
+		 * \brief Parses vertices and indices, and the usemtl group every triangle belongs to
+		 * \param materialNames names of the usemtl groups in order of first use, faces before the first usemtl get an empty name
+		 * \param triangleMaterials index into materialNames per triangle, so the caller can map groups to scene materials
+		 */
 #pragma warning(push)
 #pragma warning(disable : 4505) //Warning unreferenced local function
-		static bool ParseOBJ(const std::string& filename, std::vector<Vector3>& positions, std::vector<Vector3>& normals, std::vector<int>& indices)
+		static bool ParseOBJ(const std::string& filename, std::vector<Vector3>& positions, std::vector<Vector3>& normals, std::vector<int>& indices,
+			std::vector<std::string>& materialNames, std::vector<uint32_t>& triangleMaterials)
 		{
 			std::ifstream file(filename);
 			if (!file)
 				return false;
 
+			std::unordered_map<std::string, uint32_t> materialGroups{};
+			const auto getMaterialGroup = [&](const std::string& name)
+			{
+				const auto [it, isNew] = materialGroups.try_emplace(name, static_cast<uint32_t>(materialNames.size()));
+				if (isNew)
+					materialNames.push_back(name);
+				return it->second;
+			};
+
+			bool hasMaterialGroup{ false };
+			uint32_t materialGroup{};
+
 			std::string sCommand;
 			// start a while iteration ending when the end of file is reached (ios::eof)
 			while (!file.eof())
@@ -239,6 +454,20 @@ namespace dae
 					indices.push_back((int)i0 - 1);
 					indices.push_back((int)i1 - 1);
 					indices.push_back((int)i2 - 1);
+
+					if (!hasMaterialGroup)
+					{
+						materialGroup = getMaterialGroup("");
+						hasMaterialGroup = true;
+					}
+					triangleMaterials.push_back(materialGroup);
+				}
+				else if (sCommand == "usemtl")
+				{
+					std::string name;
+					file >> name;
+					materialGroup = getMaterialGroup(name);
+					hasMaterialGroup = true;
 				}
 				//read till end of line and ignore all remaining chars
 				file.ignore(1000, '\n');
@@ -258,13 +487,13 @@ namespace dae
 				Vector3 edgeV0V2 = positions[i2] - positions[i0];
 				Vector3 normal = Vector3::Cross(edgeV0V1, edgeV0V2);
 
-				if(isnan(normal.x))
+				if(std::isnan(normal.x))
 				{
 					int k = 0;
 				}
 
 				normal.Normalize();
-				if (isnan(normal.x))
+				if (std::isnan(normal.x))
 				{
 					int k = 0;
 				}
@@ -274,6 +503,14 @@ namespace dae
 
 			return true;
 		}
+
+		//Just parses vertices and indices
+		static bool ParseOBJ(const std::string& filename, std::vector<Vector3>& positions, std::vector<Vector3>& normals, std::vector<int>& indices)
+		{
+			std::vector<std::string> materialNames{};
+			std::vector<uint32_t> triangleMaterials{};
+			return ParseOBJ(filename, positions, normals, indices, materialNames, triangleMaterials);
+		}
 #pragma warning(pop)
 	}
 }
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "VisibilityCache.h"
+
+#include <cmath>
+
+namespace dae
+{
+	void VisibilityCache::Clear()
+	{
+		m_Cells.clear();
+		m_UsedCount = 0;
+	}
+
+	VisibilityCache::Visibility VisibilityCache::Lookup(const Vector3& point, uint32_t lightIndex)
+	{
+		if (lightIndex > s_MaxLightIndex)
+			return Visibility::Unknown;
+
+		++m_Statistics.queryCount;
+
+		int x{}, y{}, z{};
+		GetVoxel(point, x, y, z);
+
+		const Cell* pCell = FindCell(GetKey(x, y, z, lightIndex), false);
+		if (!pCell || pCell->isBoundary)
+			return Visibility::Unknown;
+
+		if (pCell->occludedCount == 0 && pCell->visibleCount >= m_Settings.minAgreeingCount)
+		{
+			++m_Statistics.hitCount;
+			return Visibility::Visible;
+		}
+
+		if (pCell->visibleCount == 0 && pCell->occludedCount >= m_Settings.minAgreeingCount)
+		{
+			++m_Statistics.hitCount;
+			return Visibility::Occluded;
+		}
+
+		return Visibility::Unknown;
+	}
+
+	void VisibilityCache::Record(const Vector3& point, uint32_t lightIndex, bool isOccluded)
+	{
+		if (lightIndex > s_MaxLightIndex)
+			return;
+
+		int x{}, y{}, z{};
+		GetVoxel(point, x, y, z);
+
+		Cell* pCell = FindCell(GetKey(x, y, z, lightIndex), true);
+		if (!pCell || pCell->isBoundary)
+			return;
+
+		uint16_t& count = isOccluded ? pCell->occludedCount : pCell->visibleCount;
+		if (count < UINT16_MAX)
+			++count;
+
+		if (pCell->visibleCount == 0 || pCell->occludedCount == 0)
+			return;
+
+		// a shadow edge runs through the voxel, it may just as well clip the neighbors without any of their samples seeing it
+		for (int dz{ -1 }; dz <= 1; ++dz)
+		{
+			for (int dy{ -1 }; dy <= 1; ++dy)
+			{
+				for (int dx{ -1 }; dx <= 1; ++dx)
+				{
+					if (Cell* pNeighbor = FindCell(GetKey(x + dx, y + dy, z + dz, lightIndex), true))
+					{
+						pNeighbor->isBoundary = true;
+					}
+				}
+			}
+		}
+	}
+
+	uint64_t VisibilityCache::GetKey(int x, int y, int z, uint32_t lightIndex)
+	{
+		return (uint64_t(uint16_t(x)) << 48) | (uint64_t(uint16_t(y)) << 32) | (uint64_t(uint16_t(z)) << 16) | uint64_t(lightIndex);
+	}
+
+	void VisibilityCache::GetVoxel(const Vector3& point, int& x, int& y, int& z) const
+	{
+		const float inverseSize = 1.f / m_Settings.voxelSize;
+		x = static_cast<int>(std::floor(point.x * inverseSize));
+		y = static_cast<int>(std::floor(point.y * inverseSize));
+		z = static_cast<int>(std::floor(point.z * inverseSize));
+	}
+
+	VisibilityCache::Cell* VisibilityCache::FindCell(uint64_t key, bool insert)
+	{
+		if (m_Cells.empty())
+		{
+			if (!insert)
+				return nullptr;
+
+			// power of two, so the probe wraps with a mask
+			size_t capacity{ 16 };
+			while (capacity < m_Settings.capacity)
+			{
+				capacity <<= 1;
+			}
+			m_Cells.resize(capacity);
+		}
+
+		const size_t mask = m_Cells.size() - 1;
+
+		// splitmix64 finalizer, neighboring voxels would otherwise land in neighboring slots and cluster
+		uint64_t hash = key;
+		hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+		hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+		hash ^= hash >> 31;
+
+		for (size_t slot = hash & mask;; slot = (slot + 1) & mask)
+		{
+			Cell& cell = m_Cells[slot];
+			if (cell.key == key)
+				return &cell;
+
+			if (cell.key != s_EmptyKey)
+				continue;
+
+			// half full keeps the probes short, later voxels are simply never cached
+			if (!insert || m_UsedCount * 2 >= m_Cells.size())
+				return nullptr;
+
+			cell.key = key;
+			++m_UsedCount;
+			return &cell;
+		}
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Math.h"
+
+namespace dae
+{
+	/**
+	 * \brief Remembers whether a point light is visible from the shading points in a voxel, for scenes whose lights and
+	 * geometry never move. The grid is sparse and filled by the shadow rays that are traced anyway: once enough of
+	 * them agree, a voxel answers later queries without tracing. A voxel that saw both answers holds a shadow boundary,
+	 * it and its neighbors keep being traced exactly. An approximation: a shadow thinner than a voxel that none of its
+	 * samples saw is missed. Not thread safe, like the occluder cache.
+	 */
+	class VisibilityCache final
+	{
+	public:
+		enum class Visibility : uint8_t
+		{
+			Unknown = 0, //trace the shadow ray and record the answer
+			Visible = 1,
+			Occluded = 2
+		};
+
+		struct Settings
+		{
+			float voxelSize{ 0.1f };
+			uint16_t minAgreeingCount{ 16 }; //traced answers a voxel needs, all the same, before it answers itself
+			uint32_t capacity{ 1u << 20 }; //voxel and light pairs, once half are used further voxels are always traced
+		};
+
+		struct Statistics
+		{
+			size_t queryCount{};
+			size_t hitCount{}; //queries answered without tracing
+
+			float GetHitRate() const { return queryCount > 0 ? hitCount / float(queryCount) : 0.f; }
+		};
+
+		VisibilityCache() = default;
+		~VisibilityCache() = default;
+
+		VisibilityCache(const VisibilityCache&) = delete;
+		VisibilityCache(VisibilityCache&&) noexcept = delete;
+		VisibilityCache& operator=(const VisibilityCache&) = delete;
+		VisibilityCache& operator=(VisibilityCache&&) noexcept = delete;
+
+		void Clear();
+
+		Visibility Lookup(const Vector3& point, uint32_t lightIndex);
+		void Record(const Vector3& point, uint32_t lightIndex, bool isOccluded);
+
+		Settings& GetSettings() { return m_Settings; }
+		const Statistics& GetStatistics() const { return m_Statistics; }
+		void ResetStatistics() { m_Statistics = {}; }
+
+	private:
+		static constexpr uint64_t s_EmptyKey{ ~0ull };
+		static constexpr uint32_t s_MaxLightIndex{ 0xFFFE }; //lights past it are never cached, 0xFFFF could form the empty key
+
+		struct Cell
+		{
+			uint64_t key{ s_EmptyKey };
+			uint16_t visibleCount{};
+			uint16_t occludedCount{};
+			bool isBoundary{};
+		};
+
+		Settings m_Settings{};
+		Statistics m_Statistics{};
+
+		std::vector<Cell> m_Cells{}; //open addressing with linear probing, allocated on first use
+		size_t m_UsedCount{};
+
+		//16 bits per voxel coordinate and for the light
+		static uint64_t GetKey(int x, int y, int z, uint32_t lightIndex);
+		void GetVoxel(const Vector3& point, int& x, int& y, int& z) const;
+		//nullptr when the cell is missing and insert is false, or the table is too full to insert
+		Cell* FindCell(uint64_t key, bool insert);
+	};
+}
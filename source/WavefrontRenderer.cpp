@@ -0,0 +1,793 @@
+//Standard includes
+#include <algorithm>
+#include <cfloat>
+#include <execution>
+#include <numeric>
+
+//Project includes
+#include "WavefrontRenderer.h"
+#include "Camera.h"
+#include "Framebuffer.h"
+#include "Material.h"
+#include "Scene.h"
+#include "ShadingBatch.h"
+#include "Utils.h"
+
+using namespace dae;
+
+namespace
+{
+	//Spreads the low 10 bits of value so two zero bits follow every bit, for interleaving into a Morton code
+	uint32_t SpreadBits(uint32_t value)
+	{
+		value = (value | (value << 16)) & 0x030000FF;
+		value = (value | (value << 8)) & 0x0300F00F;
+		value = (value | (value << 4)) & 0x030C30C3;
+		value = (value | (value << 2)) & 0x09249249;
+		return value;
+	}
+}
+
+#pragma region Queues
+void WavefrontRenderer::RayQueue::Resize(size_t count)
+{
+	for (std::vector<float>* pChannel : { &originX, &originY, &originZ, &directionX, &directionY, &directionZ, &tMin, &tMax })
+		pChannel->resize(count);
+}
+
+void WavefrontRenderer::HitQueue::Resize(size_t count)
+{
+	t.resize(count);
+	primitive.resize(count);
+}
+
+void WavefrontRenderer::ShadingQueue::Resize(size_t count)
+{
+	for (std::vector<float>* pChannel : { &positionX, &positionY, &positionZ, &normalX, &normalY, &normalZ, &viewDirectionX, &viewDirectionY, &viewDirectionZ, &t })
+		pChannel->resize(count);
+
+	rayIndex.resize(count);
+	materialIndex.resize(count);
+	color.resize(count);
+	environmentColor.resize(count);
+}
+
+void WavefrontRenderer::ShadowQueue::Resize(size_t count)
+{
+	rays.Resize(count);
+	shadingIndex.resize(count);
+	cosine.resize(count);
+	radiance.resize(count);
+	isOccluded.resize(count);
+}
+#pragma endregion
+
+void WavefrontRenderer::Render(const Renderer& renderer, const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame,
+	Renderer::LightingMode lightingMode, BRDF::Precision brdfPrecision, bool shadowsEnabled, Framebuffer& framebuffer)
+{
+	GeneratePrimaryRays(cameraFrame);
+	FindClosestHits(pScene);
+
+	// the shadow rays of each light are emitted in hit order, so binning the hits bins them too
+	if (shadowsEnabled && m_Settings.sortShadowRays)
+		SortHits();
+	else
+		m_HitOrder.clear();
+
+	CompactHits(pScene);
+	EmitShadowRays(renderer, pScene, lightingMode);
+
+	m_OcclusionTestCount = 0;
+	if (shadowsEnabled)
+		ResolveOcclusion(pScene);
+	else
+		std::fill(m_Shadows.isOccluded.begin(), m_Shadows.isOccluded.end(), 0u);
+
+	m_Statistics.shadowRayCount = m_Shadows.GetSize();
+	m_Statistics.occlusionTestCount = m_OcclusionTestCount;
+
+	Accumulate(materials, lightingMode, brdfPrecision);
+	WriteFramebuffer(pScene, framebuffer);
+}
+
+#pragma region Helpers
+template<typename Function>
+void WavefrontRenderer::ForEachChunk(size_t count, const Function& function)
+{
+	const size_t chunkCount = (count + s_ChunkSize - 1) / s_ChunkSize;
+	if (m_ChunkIndices.size() < chunkCount)
+	{
+		m_ChunkIndices.resize(chunkCount);
+		std::iota(m_ChunkIndices.begin(), m_ChunkIndices.end(), 0u);
+	}
+
+	std::for_each(std::execution::par, m_ChunkIndices.begin(), m_ChunkIndices.begin() + chunkCount, [&](uint32_t chunk)
+		{
+			const size_t begin = size_t(chunk) * s_ChunkSize;
+			function(begin, std::min(begin + s_ChunkSize, count));
+		});
+}
+
+template<typename Predicate, typename Resize, typename Emit>
+size_t WavefrontRenderer::Compact(size_t count, size_t outputOffset, const Predicate& predicate, const Resize& resize, const Emit& emit)
+{
+	const size_t chunkCount = (count + s_ChunkSize - 1) / s_ChunkSize;
+	m_ChunkCounts.assign(chunkCount + 1, 0);
+
+	ForEachChunk(count, [&](size_t begin, size_t end)
+		{
+			uint32_t keptCount{};
+			for (size_t i{ begin }; i < end; ++i)
+				keptCount += predicate(i) ? 1 : 0;
+
+			m_ChunkCounts[begin / s_ChunkSize + 1] = keptCount;
+		});
+
+	// shifted by one, so the scan gives the first output slot of every chunk and the total at the end
+	std::inclusive_scan(m_ChunkCounts.begin(), m_ChunkCounts.end(), m_ChunkCounts.begin());
+	const size_t total = m_ChunkCounts.back();
+
+	resize(outputOffset + total);
+
+	ForEachChunk(count, [&](size_t begin, size_t end)
+		{
+			size_t output = outputOffset + m_ChunkCounts[begin / s_ChunkSize];
+			for (size_t i{ begin }; i < end; ++i)
+			{
+				if (predicate(i))
+					emit(i, output++);
+			}
+		});
+
+	return total;
+}
+#pragma endregion
+
+#pragma region Stages
+void WavefrontRenderer::GeneratePrimaryRays(const CameraFrame& cameraFrame)
+{
+	const size_t rayCount = size_t(cameraFrame.width) * cameraFrame.height;
+	m_PrimaryRays.Resize(rayCount);
+
+	ForEachChunk(rayCount, [&](size_t begin, size_t end)
+		{
+			for (size_t i{ begin }; i < end; ++i)
+			{
+				const int px = static_cast<int>(i % cameraFrame.width);
+				const int py = static_cast<int>(i / cameraFrame.width);
+				const Ray ray = cameraFrame.GetViewRay(px + 0.5f, py + 0.5f);
+
+				m_PrimaryRays.originX[i] = ray.origin.x;
+				m_PrimaryRays.originY[i] = ray.origin.y;
+				m_PrimaryRays.originZ[i] = ray.origin.z;
+				m_PrimaryRays.directionX[i] = ray.direction.x;
+				m_PrimaryRays.directionY[i] = ray.direction.y;
+				m_PrimaryRays.directionZ[i] = ray.direction.z;
+				m_PrimaryRays.tMin[i] = ray.min;
+				m_PrimaryRays.tMax[i] = ray.max;
+			}
+		});
+}
+
+void WavefrontRenderer::FindClosestHits(const Scene* pScene)
+{
+	const RayQueue& rays = m_PrimaryRays;
+	HitQueue& hits = m_PrimaryHits;
+	hits.Resize(rays.GetSize());
+
+	const auto& spheres = pScene->GetSphereGeometries();
+	const auto& planes = pScene->GetPlaneGeometries();
+	const auto& meshes = pScene->GetTriangleMeshGeometries();
+
+	// primitives get one id range each: spheres, planes, then the triangles of every mesh
+	const uint32_t firstPlaneId = static_cast<uint32_t>(spheres.size());
+	m_TriangleOffsets.resize(meshes.size() + 1);
+	m_TriangleOffsets[0] = firstPlaneId + static_cast<uint32_t>(planes.size());
+	for (size_t meshIndex{}; meshIndex < meshes.size(); ++meshIndex)
+		m_TriangleOffsets[meshIndex + 1] = m_TriangleOffsets[meshIndex] + static_cast<uint32_t>(meshes[meshIndex].indices.size() / 3);
+
+	ForEachChunk(rays.GetSize(), [&](size_t begin, size_t end)
+		{
+			const size_t count = end - begin;
+			const float* __restrict originX = rays.originX.data() + begin;
+			const float* __restrict originY = rays.originY.data() + begin;
+			const float* __restrict originZ = rays.originZ.data() + begin;
+			const float* __restrict directionX = rays.directionX.data() + begin;
+			const float* __restrict directionY = rays.directionY.data() + begin;
+			const float* __restrict directionZ = rays.directionZ.data() + begin;
+			const float* __restrict tMin = rays.tMin.data() + begin;
+			const float* __restrict tMax = rays.tMax.data() + begin;
+			float* __restrict hitT = hits.t.data() + begin;
+			uint32_t* __restrict hitPrimitive = hits.primitive.data() + begin;
+
+			std::fill(hitT, hitT + count, FLT_MAX);
+			std::fill(hitPrimitive, hitPrimitive + count, s_NoPrimitive);
+
+			// same primitive order and strict comparisons as Scene::GetClosestHit, so ties resolve identically,
+			// the inner loops select instead of branching so they vectorize
+			for (uint32_t sphereIndex{}; sphereIndex < spheres.size(); ++sphereIndex)
+			{
+				const Sphere& sphere = spheres[sphereIndex];
+				const float sqrRadius = sphere.radius * sphere.radius;
+
+				for (size_t i{}; i < count; ++i)
+				{
+					const float diffX = originX[i] - sphere.origin.x;
+					const float diffY = originY[i] - sphere.origin.y;
+					const float diffZ = originZ[i] - sphere.origin.z;
+
+					const float B = (2 * directionX[i]) * diffX + (2 * directionY[i]) * diffY + (2 * directionZ[i]) * diffZ;
+					const float C = (diffX * diffX + diffY * diffY + diffZ * diffZ) - sqrRadius;
+					const float discriminant = B * B - 4 * C;
+					// GeometryUtils::HitTest_Sphere takes the root in double and rounds t once it is in range, the hit
+					// positions key the environment samples, so they have to match Standard's to the bit
+					const double t = (-B - sqrt(double(discriminant))) / 2;
+
+					const bool isHit = (discriminant >= 0.00001f) & (t >= tMin[i]) & (t <= tMax[i]) & (float(t) < hitT[i]);
+					hitT[i] = isHit ? float(t) : hitT[i];
+					hitPrimitive[i] = isHit ? sphereIndex : hitPrimitive[i];
+				}
+			}
+
+			for (uint32_t planeIndex{}; planeIndex < planes.size(); ++planeIndex)
+			{
+				const Plane& plane = planes[planeIndex];
+				const uint32_t primitiveId = firstPlaneId + planeIndex;
+
+				for (size_t i{}; i < count; ++i)
+				{
+					const float numerator = (plane.origin.x - originX[i]) * plane.normal.x + (plane.origin.y - originY[i]) * plane.normal.y + (plane.origin.z - originZ[i]) * plane.normal.z;
+					const float denominator = directionX[i] * plane.normal.x + directionY[i] * plane.normal.y + directionZ[i] * plane.normal.z;
+					const float t = numerator / denominator;
+
+					const bool isHit = (t >= tMin[i]) & (t <= tMax[i]) & (t < hitT[i]);
+					hitT[i] = isHit ? t : hitT[i];
+					hitPrimitive[i] = isHit ? primitiveId : hitPrimitive[i];
+				}
+			}
+
+			for (size_t meshIndex{}; meshIndex < meshes.size(); ++meshIndex)
+			{
+				const TriangleMesh& mesh = meshes[meshIndex];
+				const bool cullsBackFaces = mesh.cullMode == TriangleCullMode::BackFaceCulling;
+				const bool cullsFrontFaces = mesh.cullMode == TriangleCullMode::FrontFaceCulling;
+
+				for (uint32_t triangleIndex{}; triangleIndex < mesh.indices.size() / 3; ++triangleIndex)
+				{
+					const Vector3 v0 = mesh.transformedPositions[mesh.indices[triangleIndex * 3]];
+					const Vector3 v1 = mesh.transformedPositions[mesh.indices[triangleIndex * 3 + 1]];
+					const Vector3 v2 = mesh.transformedPositions[mesh.indices[triangleIndex * 3 + 2]];
+					const Vector3 normal = mesh.transformedNormals[triangleIndex];
+					// n . (edge x q) == q . (n x edge), so each edge test becomes a single dot product
+					const Vector3 edgeNormalA = Vector3::Cross(normal, v1 - v0);
+					const Vector3 edgeNormalB = Vector3::Cross(normal, v2 - v1);
+					const Vector3 edgeNormalC = Vector3::Cross(normal, v0 - v2);
+					const uint32_t primitiveId = m_TriangleOffsets[meshIndex] + triangleIndex;
+
+					for (size_t i{}; i < count; ++i)
+					{
+						const float dot = normal.x * directionX[i] + normal.y * directionY[i] + normal.z * directionZ[i];
+						const bool isCulled = (cullsFrontFaces & (dot < 0)) | (cullsBackFaces & (dot > 0));
+
+						const float t = ((v0.x - originX[i]) * normal.x + (v0.y - originY[i]) * normal.y + (v0.z - originZ[i]) * normal.z) / dot;
+						const float pX = originX[i] + t * directionX[i];
+						const float pY = originY[i] + t * directionY[i];
+						const float pZ = originZ[i] + t * directionZ[i];
+
+						const bool isHit = !isCulled & (t >= tMin[i]) & (t <= tMax[i]) & (t < hitT[i])
+							& IsInsideEdge(edgeNormalA, v0, pX, pY, pZ) & IsInsideEdge(edgeNormalB, v1, pX, pY, pZ) & IsInsideEdge(edgeNormalC, v2, pX, pY, pZ);
+						hitT[i] = isHit ? t : hitT[i];
+						hitPrimitive[i] = isHit ? primitiveId : hitPrimitive[i];
+					}
+				}
+			}
+		});
+}
+
+void WavefrontRenderer::SortHits()
+{
+	const RayQueue& rays = m_PrimaryRays;
+	const HitQueue& hits = m_PrimaryHits;
+	const size_t rayCount = rays.GetSize();
+
+	const auto getPosition = [&](size_t i)
+		{
+			return Vector3{ rays.originX[i] + hits.t[i] * rays.directionX[i], rays.originY[i] + hits.t[i] * rays.directionY[i],
+				rays.originZ[i] + hits.t[i] * rays.directionZ[i] };
+		};
+
+	Bounds hitBounds{ FLT_MAX, FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (size_t i{}; i < rayCount; ++i)
+	{
+		if (hits.primitive[i] == s_NoPrimitive)
+			continue;
+
+		const Vector3 position = getPosition(i);
+		hitBounds.minX = std::min(hitBounds.minX, position.x);
+		hitBounds.minY = std::min(hitBounds.minY, position.y);
+		hitBounds.minZ = std::min(hitBounds.minZ, position.z);
+		hitBounds.maxX = std::max(hitBounds.maxX, position.x);
+		hitBounds.maxY = std::max(hitBounds.maxY, position.y);
+		hitBounds.maxZ = std::max(hitBounds.maxZ, position.z);
+	}
+
+	const float scaleX = s_BinGridSize / std::max(hitBounds.maxX - hitBounds.minX, FLT_EPSILON);
+	const float scaleY = s_BinGridSize / std::max(hitBounds.maxY - hitBounds.minY, FLT_EPSILON);
+	const float scaleZ = s_BinGridSize / std::max(hitBounds.maxZ - hitBounds.minZ, FLT_EPSILON);
+
+	// rays that missed get the key one past the last bin, so they end up after every hit and are cut off
+	m_BinKeys.resize(rayCount);
+	ForEachChunk(rayCount, [&](size_t begin, size_t end)
+		{
+			constexpr uint32_t maxCell{ s_BinGridSize - 1 };
+
+			for (size_t i{ begin }; i < end; ++i)
+			{
+				if (hits.primitive[i] == s_NoPrimitive)
+				{
+					m_BinKeys[i] = s_BinCount;
+					continue;
+				}
+
+				const Vector3 position = getPosition(i);
+				m_BinKeys[i] = SpreadBits(std::min(static_cast<uint32_t>((position.x - hitBounds.minX) * scaleX), maxCell))
+					| (SpreadBits(std::min(static_cast<uint32_t>((position.y - hitBounds.minY) * scaleY), maxCell)) << 1)
+					| (SpreadBits(std::min(static_cast<uint32_t>((position.z - hitBounds.minZ) * scaleZ), maxCell)) << 2);
+			}
+		});
+
+	// stable counting sort, so rays within a cell keep their pixel order
+	m_BinOffsets.assign(s_BinCount + 2, 0);
+	for (size_t i{}; i < rayCount; ++i)
+		++m_BinOffsets[m_BinKeys[i] + 1];
+
+	std::inclusive_scan(m_BinOffsets.begin(), m_BinOffsets.end(), m_BinOffsets.begin());
+
+	m_HitOrder.resize(rayCount);
+	for (size_t i{}; i < rayCount; ++i)
+		m_HitOrder[m_BinOffsets[m_BinKeys[i]]++] = static_cast<uint32_t>(i);
+
+	m_HitOrder.resize(m_BinOffsets[s_BinCount - 1]);
+}
+
+void WavefrontRenderer::CompactHits(const Scene* pScene)
+{
+	const RayQueue& rays = m_PrimaryRays;
+	const HitQueue& hits = m_PrimaryHits;
+	ShadingQueue& shading = m_Shading;
+
+	const auto& spheres = pScene->GetSphereGeometries();
+	const auto& planes = pScene->GetPlaneGeometries();
+	const auto& meshes = pScene->GetTriangleMeshGeometries();
+
+	// either every ray in pixel order, or only the rays that hit in bin order
+	const bool isBinned = !m_HitOrder.empty();
+
+	Compact(isBinned ? m_HitOrder.size() : rays.GetSize(), 0,
+		[&](size_t input) { return isBinned || hits.primitive[input] != s_NoPrimitive; },
+		[&](size_t count) { shading.Resize(count); },
+		[&](size_t input, size_t output)
+		{
+			const size_t i = isBinned ? m_HitOrder[input] : input;
+			const Vector3 origin{ rays.originX[i], rays.originY[i], rays.originZ[i] };
+			const Vector3 direction{ rays.directionX[i], rays.directionY[i], rays.directionZ[i] };
+			const Vector3 position = origin + hits.t[i] * direction;
+
+			const uint32_t primitiveId = hits.primitive[i];
+			Vector3 normal{};
+			uint32_t materialIndex{};
+
+			if (primitiveId < spheres.size())
+			{
+				const Sphere& sphere = spheres[primitiveId];
+				normal = (position - sphere.origin) / sphere.radius;
+				materialIndex = sphere.materialIndex;
+			}
+			else if (primitiveId < m_TriangleOffsets[0])
+			{
+				const Plane& plane = planes[primitiveId - spheres.size()];
+				normal = plane.normal;
+				materialIndex = plane.materialIndex;
+			}
+			else
+			{
+				const size_t meshIndex = std::upper_bound(m_TriangleOffsets.begin(), m_TriangleOffsets.end(), primitiveId) - m_TriangleOffsets.begin() - 1;
+				normal = meshes[meshIndex].transformedNormals[primitiveId - m_TriangleOffsets[meshIndex]];
+				materialIndex = meshes[meshIndex].GetMaterialIndex(primitiveId - m_TriangleOffsets[meshIndex]);
+			}
+
+			shading.positionX[output] = position.x;
+			shading.positionY[output] = position.y;
+			shading.positionZ[output] = position.z;
+			shading.normalX[output] = normal.x;
+			shading.normalY[output] = normal.y;
+			shading.normalZ[output] = normal.z;
+			shading.viewDirectionX[output] = direction.x;
+			shading.viewDirectionY[output] = direction.y;
+			shading.viewDirectionZ[output] = direction.z;
+			shading.t[output] = hits.t[i];
+			shading.rayIndex[output] = static_cast<uint32_t>(i);
+			shading.materialIndex[output] = materialIndex;
+			shading.color[output] = ColorRGB{};
+			shading.environmentColor[output] = ColorRGB{};
+		});
+}
+
+void WavefrontRenderer::EmitShadowRays(const Renderer& renderer, const Scene* pScene, Renderer::LightingMode lightingMode)
+{
+	const ShadingQueue& shading = m_Shading;
+	ShadowQueue& shadows = m_Shadows;
+	const auto& lights = pScene->GetLights();
+
+	// lights behind or edge on to a hit get no shadow ray, like in Renderer::Shade, the rest are packed light after light
+	m_LightOffsets.assign(1, 0);
+
+	for (const Light& light : lights)
+	{
+		const auto getDirection = [&](size_t i, float& distance)
+			{
+				Vector3 direction = LightUtils::GetDirectionToLight(light, { shading.positionX[i], shading.positionY[i], shading.positionZ[i] });
+				distance = direction.Normalize();
+				return direction;
+			};
+
+		const size_t offset = m_LightOffsets.back();
+		const size_t emittedCount = Compact(shading.GetSize(), offset,
+			[&](size_t i)
+			{
+				float distance{};
+				const Vector3 direction = getDirection(i, distance);
+				return shading.normalX[i] * direction.x + shading.normalY[i] * direction.y + shading.normalZ[i] * direction.z > 0;
+			},
+			[&](size_t count) { shadows.Resize(count); },
+			[&](size_t i, size_t output)
+			{
+				float distance{};
+				const Vector3 direction = getDirection(i, distance);
+
+				shadows.rays.originX[output] = shading.positionX[i] + shading.normalX[i] * 0.1f;
+				shadows.rays.originY[output] = shading.positionY[i] + shading.normalY[i] * 0.1f;
+				shadows.rays.originZ[output] = shading.positionZ[i] + shading.normalZ[i] * 0.1f;
+				shadows.rays.directionX[output] = direction.x;
+				shadows.rays.directionY[output] = direction.y;
+				shadows.rays.directionZ[output] = direction.z;
+				shadows.rays.tMin[output] = 0.0001f;
+				shadows.rays.tMax[output] = distance;
+				shadows.shadingIndex[output] = static_cast<uint32_t>(i);
+				shadows.cosine[output] = shading.normalX[i] * direction.x + shading.normalY[i] * direction.y + shading.normalZ[i] * direction.z;
+				shadows.radiance[output] = LightUtils::GetRadiance(light, { shading.positionX[i], shading.positionY[i], shading.positionZ[i] });
+			});
+
+		m_LightOffsets.push_back(offset + emittedCount);
+	}
+
+	// like indirect light, the environment only lights the final image, see Renderer::Shade
+	m_EnvironmentOffsets.assign(1, m_LightOffsets.back());
+	const EnvironmentMap& environment = pScene->GetEnvironment();
+	const uint32_t environmentSampleCount = !environment.IsEmpty() && lightingMode == Renderer::LightingMode::Combined ? renderer.GetEnvironmentSampleCount() : 0;
+
+	for (uint32_t sampleIndex{}; sampleIndex < environmentSampleCount; ++sampleIndex)
+	{
+		const auto getSample = [&](size_t i, Vector3& direction, ColorRGB& radiance, float& cosine)
+			{
+				const HitRecord hitRecord{ { shading.positionX[i], shading.positionY[i], shading.positionZ[i] },
+					{ shading.normalX[i], shading.normalY[i], shading.normalZ[i] }, shading.t[i], true, shading.materialIndex[i] };
+				return renderer.SampleEnvironment(environment, hitRecord, sampleIndex, direction, radiance, cosine);
+			};
+
+		const size_t offset = m_EnvironmentOffsets.back();
+		const size_t emittedCount = Compact(shading.GetSize(), offset,
+			[&](size_t i)
+			{
+				Vector3 direction{};
+				ColorRGB radiance{};
+				float cosine{};
+				return getSample(i, direction, radiance, cosine);
+			},
+			[&](size_t count) { shadows.Resize(count); },
+			[&](size_t i, size_t output)
+			{
+				Vector3 direction{};
+				getSample(i, direction, shadows.radiance[output], shadows.cosine[output]);
+
+				shadows.rays.originX[output] = shading.positionX[i] + shading.normalX[i] * 0.1f;
+				shadows.rays.originY[output] = shading.positionY[i] + shading.normalY[i] * 0.1f;
+				shadows.rays.originZ[output] = shading.positionZ[i] + shading.normalZ[i] * 0.1f;
+				shadows.rays.directionX[output] = direction.x;
+				shadows.rays.directionY[output] = direction.y;
+				shadows.rays.directionZ[output] = direction.z;
+				shadows.rays.tMin[output] = 0.0001f;
+				shadows.rays.tMax[output] = FLT_MAX;
+				shadows.shadingIndex[output] = static_cast<uint32_t>(i);
+			});
+
+		m_EnvironmentOffsets.push_back(offset + emittedCount);
+	}
+
+	shadows.Resize(m_EnvironmentOffsets.back());
+}
+
+void WavefrontRenderer::ResolveOcclusion(const Scene* pScene)
+{
+	const RayQueue& rays = m_Shadows.rays;
+
+	const auto& spheres = pScene->GetSphereGeometries();
+	const auto& planes = pScene->GetPlaneGeometries();
+	const auto& meshes = pScene->GetTriangleMeshGeometries();
+
+	m_TriangleBounds.resize(m_TriangleOffsets.back() - m_TriangleOffsets.front());
+	for (size_t meshIndex{}; meshIndex < meshes.size(); ++meshIndex)
+	{
+		const TriangleMesh& mesh = meshes[meshIndex];
+		Bounds* pBounds = m_TriangleBounds.data() + (m_TriangleOffsets[meshIndex] - m_TriangleOffsets.front());
+
+		for (size_t triangleIndex{}; triangleIndex < mesh.indices.size() / 3; ++triangleIndex)
+		{
+			const Vector3& v0 = mesh.transformedPositions[mesh.indices[triangleIndex * 3]];
+			const Vector3& v1 = mesh.transformedPositions[mesh.indices[triangleIndex * 3 + 1]];
+			const Vector3& v2 = mesh.transformedPositions[mesh.indices[triangleIndex * 3 + 2]];
+
+			pBounds[triangleIndex] = Bounds{ std::min({ v0.x, v1.x, v2.x }), std::min({ v0.y, v1.y, v2.y }), std::min({ v0.z, v1.z, v2.z }),
+				std::max({ v0.x, v1.x, v2.x }), std::max({ v0.y, v1.y, v2.y }), std::max({ v0.z, v1.z, v2.z }) };
+		}
+	}
+
+	// any hit is enough, so every primitive simply ORs into the mask; meshes keep their cull mode like Scene::DoesHit
+	ForEachChunk(rays.GetSize(), [&](size_t begin, size_t end)
+		{
+			const size_t count = end - begin;
+			const float* __restrict originX = rays.originX.data() + begin;
+			const float* __restrict originY = rays.originY.data() + begin;
+			const float* __restrict originZ = rays.originZ.data() + begin;
+			const float* __restrict directionX = rays.directionX.data() + begin;
+			const float* __restrict directionY = rays.directionY.data() + begin;
+			const float* __restrict directionZ = rays.directionZ.data() + begin;
+			const float* __restrict tMin = rays.tMin.data() + begin;
+			const float* __restrict tMax = rays.tMax.data() + begin;
+			uint32_t* __restrict isOccluded = m_Shadows.isOccluded.data() + begin;
+
+			std::fill(isOccluded, isOccluded + count, 0u);
+
+			// bounds of every shadow ray segment in the chunk, primitives outside them cannot occlude any of its rays
+			Bounds chunkBounds{ FLT_MAX, FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (size_t i{}; i < count; ++i)
+			{
+				const float endX = originX[i] + directionX[i] * tMax[i];
+				const float endY = originY[i] + directionY[i] * tMax[i];
+				const float endZ = originZ[i] + directionZ[i] * tMax[i];
+
+				chunkBounds.minX = std::min({ chunkBounds.minX, originX[i], endX });
+				chunkBounds.minY = std::min({ chunkBounds.minY, originY[i], endY });
+				chunkBounds.minZ = std::min({ chunkBounds.minZ, originZ[i], endZ });
+				chunkBounds.maxX = std::max({ chunkBounds.maxX, originX[i], endX });
+				chunkBounds.maxY = std::max({ chunkBounds.maxY, originY[i], endY });
+				chunkBounds.maxZ = std::max({ chunkBounds.maxZ, originZ[i], endZ });
+			}
+
+			size_t testCount{ planes.size() * count };
+
+			for (const Plane& plane : planes)
+			{
+				for (size_t i{}; i < count; ++i)
+				{
+					const float numerator = (plane.origin.x - originX[i]) * plane.normal.x + (plane.origin.y - originY[i]) * plane.normal.y + (plane.origin.z - originZ[i]) * plane.normal.z;
+					const float denominator = directionX[i] * plane.normal.x + directionY[i] * plane.normal.y + directionZ[i] * plane.normal.z;
+					const float t = numerator / denominator;
+
+					isOccluded[i] |= uint32_t(!((t < tMin[i]) | (t > tMax[i])));
+				}
+			}
+
+			for (const Sphere& sphere : spheres)
+			{
+				const Bounds sphereBounds{ sphere.origin.x - sphere.radius, sphere.origin.y - sphere.radius, sphere.origin.z - sphere.radius,
+					sphere.origin.x + sphere.radius, sphere.origin.y + sphere.radius, sphere.origin.z + sphere.radius };
+				if (!sphereBounds.Overlaps(chunkBounds))
+					continue;
+
+				testCount += count;
+				const float sqrRadius = sphere.radius * sphere.radius;
+
+				for (size_t i{}; i < count; ++i)
+				{
+					const float diffX = originX[i] - sphere.origin.x;
+					const float diffY = originY[i] - sphere.origin.y;
+					const float diffZ = originZ[i] - sphere.origin.z;
+
+					const float B = (2 * directionX[i]) * diffX + (2 * directionY[i]) * diffY + (2 * directionZ[i]) * diffZ;
+					const float C = (diffX * diffX + diffY * diffY + diffZ * diffZ) - sqrRadius;
+					const float discriminant = B * B - 4 * C;
+					const float t = (-B - sqrtf(discriminant)) / 2;
+
+					isOccluded[i] |= uint32_t((discriminant >= 0.00001f) & !((t < tMin[i]) | (t > tMax[i])));
+				}
+			}
+
+			for (size_t meshIndex{}; meshIndex < meshes.size(); ++meshIndex)
+			{
+				const TriangleMesh& mesh = meshes[meshIndex];
+				const Bounds* pTriangleBounds = m_TriangleBounds.data() + (m_TriangleOffsets[meshIndex] - m_TriangleOffsets.front());
+				const bool cullsBackFaces = mesh.cullMode == TriangleCullMode::BackFaceCulling;
+				const bool cullsFrontFaces = mesh.cullMode == TriangleCullMode::FrontFaceCulling;
+
+				for (size_t triangleIndex{}; triangleIndex < mesh.indices.size() / 3; ++triangleIndex)
+				{
+					if (!pTriangleBounds[triangleIndex].Overlaps(chunkBounds))
+						continue;
+
+					testCount += count;
+					const Vector3 v0 = mesh.transformedPositions[mesh.indices[triangleIndex * 3]];
+					const Vector3 v1 = mesh.transformedPositions[mesh.indices[triangleIndex * 3 + 1]];
+					const Vector3 v2 = mesh.transformedPositions[mesh.indices[triangleIndex * 3 + 2]];
+					const Vector3 normal = mesh.transformedNormals[triangleIndex];
+					// n . (edge x q) == q . (n x edge), so each edge test becomes a single dot product
+					const Vector3 edgeNormalA = Vector3::Cross(normal, v1 - v0);
+					const Vector3 edgeNormalB = Vector3::Cross(normal, v2 - v1);
+					const Vector3 edgeNormalC = Vector3::Cross(normal, v0 - v2);
+
+					for (size_t i{}; i < count; ++i)
+					{
+						const float dot = normal.x * directionX[i] + normal.y * directionY[i] + normal.z * directionZ[i];
+						const bool isCulled = (cullsFrontFaces & (dot < 0)) | (cullsBackFaces & (dot > 0));
+
+						const float t = ((v0.x - originX[i]) * normal.x + (v0.y - originY[i]) * normal.y + (v0.z - originZ[i]) * normal.z) / dot;
+						const float pX = originX[i] + t * directionX[i];
+						const float pY = originY[i] + t * directionY[i];
+						const float pZ = originZ[i] + t * directionZ[i];
+
+						isOccluded[i] |= uint32_t(!isCulled & (t >= tMin[i]) & (t <= tMax[i])
+							& IsInsideEdge(edgeNormalA, v0, pX, pY, pZ) & IsInsideEdge(edgeNormalB, v1, pX, pY, pZ) & IsInsideEdge(edgeNormalC, v2, pX, pY, pZ));
+					}
+				}
+			}
+
+			m_OcclusionTestCount += testCount;
+		});
+}
+
+void WavefrontRenderer::Accumulate(const std::vector<Material>& materials, Renderer::LightingMode lightingMode, BRDF::Precision brdfPrecision)
+{
+	const ShadowQueue& shadows = m_Shadows;
+	ShadingQueue& shading = m_Shading;
+
+	const auto getMaterialType = [&](size_t i) { return materials[shading.materialIndex[shadows.shadingIndex[i]]].type; };
+
+	// the fast BRDFs are evaluated a ShadingBatch at a time, the other modes do not evaluate a BRDF or need it exact.
+	// Lambert and solid colors stay per hit, their BRDF is a constant of the material that a batch would only gather
+	const bool isBatched = brdfPrecision == BRDF::Precision::Fast
+		&& (lightingMode == Renderer::LightingMode::BRDF || lightingMode == Renderer::LightingMode::Combined);
+
+	// one range at a time: every hit appears at most once per light or environment sample, so chunks never write the
+	// same color, and the per pixel sums keep the light and sample order of Renderer::Shade
+	const auto accumulateRange = [&](size_t offset, size_t count, std::vector<ColorRGB>& colors)
+		{
+			ForEachChunk(count, [&](size_t begin, size_t end)
+				{
+					// neighboring hits mostly share a material type, so the type is switched on once per run of them
+					for (size_t runBegin{ offset + begin }; runBegin < offset + end;)
+					{
+						const MaterialType type = getMaterialType(runBegin);
+						size_t runEnd{ runBegin + 1 };
+						while (runEnd < offset + end && getMaterialType(runEnd) == type)
+							++runEnd;
+
+						Material::Dispatch(type, [&](auto typeConstant)
+							{
+								constexpr MaterialType shadedType = decltype(typeConstant)::value;
+
+								if constexpr (ShadingBatch::IsBatched(shadedType))
+								{
+									if (isBatched)
+									{
+										AccumulateBatched<shadedType>(materials, lightingMode, colors, runBegin, runEnd);
+										return;
+									}
+								}
+
+								for (size_t i{ runBegin }; i < runEnd; ++i)
+								{
+									if (shadows.isOccluded[i])
+										continue;
+
+									const uint32_t s = shadows.shadingIndex[i];
+
+									const HitRecord hitRecord{ { shading.positionX[s], shading.positionY[s], shading.positionZ[s] },
+										{ shading.normalX[s], shading.normalY[s], shading.normalZ[s] }, shading.t[s], true, shading.materialIndex[s] };
+									const Vector3 lightDirection{ shadows.rays.directionX[i], shadows.rays.directionY[i], shadows.rays.directionZ[i] };
+									const Vector3 viewDirection{ shading.viewDirectionX[s], shading.viewDirectionY[s], shading.viewDirectionZ[s] };
+
+									colors[s] += Renderer::GetLightContribution<shadedType>(lightingMode, materials[hitRecord.materialIndex], hitRecord,
+										lightDirection, viewDirection, shadows.radiance[i], shadows.cosine[i], brdfPrecision);
+								}
+							});
+
+						runBegin = runEnd;
+					}
+				});
+		};
+
+	for (size_t lightIndex{}; lightIndex + 1 < m_LightOffsets.size(); ++lightIndex)
+		accumulateRange(m_LightOffsets[lightIndex], m_LightOffsets[lightIndex + 1] - m_LightOffsets[lightIndex], shading.color);
+
+	if (m_EnvironmentOffsets.size() < 2)
+		return;
+
+	for (size_t sampleIndex{}; sampleIndex + 1 < m_EnvironmentOffsets.size(); ++sampleIndex)
+		accumulateRange(m_EnvironmentOffsets[sampleIndex], m_EnvironmentOffsets[sampleIndex + 1] - m_EnvironmentOffsets[sampleIndex], shading.environmentColor);
+
+	ForEachChunk(shading.GetSize(), [&](size_t begin, size_t end)
+		{
+			for (size_t i{ begin }; i < end; ++i)
+				shading.color[i] += shading.environmentColor[i];
+		});
+}
+
+template<MaterialType shadedType>
+void WavefrontRenderer::AccumulateBatched(const std::vector<Material>& materials, Renderer::LightingMode lightingMode, std::vector<ColorRGB>& colors, size_t begin, size_t end)
+{
+	const ShadowQueue& shadows = m_Shadows;
+	const ShadingQueue& shading = m_Shading;
+
+	ShadingBatch batch{};
+	uint32_t shadingIndices[ShadingBatch::maxSize]{};
+	ColorRGB radiances[ShadingBatch::maxSize]{};
+	float cosines[ShadingBatch::maxSize]{};
+
+	const auto shadeBatch = [&]()
+	{
+		batch.Shade<shadedType>();
+		for (uint32_t lane{}; lane < batch.count; ++lane)
+		{
+			const ColorRGB brdf = batch.GetBRDF(lane);
+			const ColorRGB& radiance = radiances[lane];
+			colors[shadingIndices[lane]] += lightingMode == Renderer::LightingMode::Combined ? radiance * brdf * cosines[lane] : brdf;
+		}
+		batch.count = 0;
+	};
+
+	for (size_t i{ begin }; i < end; ++i)
+	{
+		if (shadows.isOccluded[i])
+			continue;
+
+		const uint32_t s = shadows.shadingIndex[i];
+
+		shadingIndices[batch.count] = s;
+		radiances[batch.count] = shadows.radiance[i];
+		cosines[batch.count] = shadows.cosine[i];
+		batch.Add<shadedType>(materials[shading.materialIndex[s]], { shading.normalX[s], shading.normalY[s], shading.normalZ[s] },
+			{ shadows.rays.directionX[i], shadows.rays.directionY[i], shadows.rays.directionZ[i] },
+			{ shading.viewDirectionX[s], shading.viewDirectionY[s], shading.viewDirectionZ[s] });
+
+		if (batch.IsFull())
+			shadeBatch();
+	}
+
+	// the last batch of the run is usually partial
+	if (batch.count > 0)
+		shadeBatch();
+}
+
+void WavefrontRenderer::WriteFramebuffer(const Scene* pScene, Framebuffer& framebuffer)
+{
+	const RayQueue& rays = m_PrimaryRays;
+	const EnvironmentMap& environment = pScene->GetEnvironment();
+	ColorRGB* pPixels = framebuffer.GetPixels();
+
+	// rays that hit nothing show the environment, every other pixel is written from its shading point below
+	ForEachChunk(rays.GetSize(), [&](size_t begin, size_t end)
+		{
+			for (size_t i{ begin }; i < end; ++i)
+			{
+				if (m_PrimaryHits.primitive[i] == s_NoPrimitive)
+					pPixels[i] = environment.GetRadiance({ rays.directionX[i], rays.directionY[i], rays.directionZ[i] });
+			}
+		});
+
+	ForEachChunk(m_Shading.GetSize(), [&](size_t begin, size_t end)
+		{
+			for (size_t i{ begin }; i < end; ++i)
+				pPixels[m_Shading.rayIndex[i]] = m_Shading.color[i];
+		});
+}
+#pragma endregion
@@ -0,0 +1,171 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "Renderer.h"
+
+namespace dae
+{
+	class Framebuffer;
+
+	/**
+	 * \brief Renders a frame as a sequence of stages over queues instead of one branchy loop per pixel:
+	 * generate primary rays, find closest hits, compact hits, emit shadow rays, resolve occlusion, accumulate.
+	 * Shadow rays go to every light and, in Combined lighting, to the scene's environment map, sampled like
+	 * Renderer::ShadeEnvironment; rays that hit nothing show the environment.
+	 * Queues are stored as structure of arrays and every stage is a flat loop over fixed size chunks that runs
+	 * in parallel. Hits can be binned by Morton ordered cell before compaction, which makes every later queue
+	 * spatially coherent. Intersection loops over primitives on the outside and rays on the inside, so one primitive
+	 * stays in registers while a chunk of rays streams past it.
+	 */
+	class WavefrontRenderer final
+	{
+	public:
+		struct Settings
+		{
+			//Bin the hits by Morton ordered cell before emitting shadow rays from them, so every chunk of shadow
+			//rays starts in a small region of space and its bounds reject most primitives
+			bool sortShadowRays{ true };
+		};
+
+		struct Statistics
+		{
+			size_t shadowRayCount{};
+			size_t occlusionTestCount{}; //ray-primitive tests that were not skipped by the chunk bounds
+
+			float GetTestsPerShadowRay() const { return shadowRayCount > 0 ? occlusionTestCount / float(shadowRayCount) : 0.f; }
+		};
+
+		WavefrontRenderer() = default;
+		~WavefrontRenderer() = default;
+
+		WavefrontRenderer(const WavefrontRenderer&) = delete;
+		WavefrontRenderer(WavefrontRenderer&&) noexcept = delete;
+		WavefrontRenderer& operator=(const WavefrontRenderer&) = delete;
+		WavefrontRenderer& operator=(WavefrontRenderer&&) noexcept = delete;
+
+		//renderer samples the environment, so its rays start from the same directions as Standard's
+		void Render(const Renderer& renderer, const Scene* pScene, const std::vector<Material>& materials, const CameraFrame& cameraFrame,
+			Renderer::LightingMode lightingMode, BRDF::Precision brdfPrecision, bool shadowsEnabled, Framebuffer& framebuffer);
+
+		Settings& GetSettings() { return m_Settings; }
+		const Statistics& GetStatistics() const { return m_Statistics; }
+
+	private:
+		//Rays small enough that a chunk of them stays in the L1/L2 while every primitive is tested
+		static constexpr uint32_t s_ChunkSize{ 2048 };
+
+		static constexpr uint32_t s_NoPrimitive{ UINT32_MAX };
+
+		//Hits are binned per cell of a grid this many cells wide over their positions
+		static constexpr uint32_t s_BinGridSize{ 32 };
+		static constexpr uint32_t s_BinCount{ s_BinGridSize * s_BinGridSize * s_BinGridSize };
+
+		struct RayQueue
+		{
+			std::vector<float> originX{}, originY{}, originZ{};
+			std::vector<float> directionX{}, directionY{}, directionZ{};
+			std::vector<float> tMin{}, tMax{};
+
+			void Resize(size_t count);
+			size_t GetSize() const { return originX.size(); }
+		};
+
+		//Closest hit of every primary ray, filled primitive by primitive
+		struct HitQueue
+		{
+			std::vector<float> t{};
+			std::vector<uint32_t> primitive{}; //id of the hit primitive, see m_TriangleOffsets
+
+			void Resize(size_t count);
+		};
+
+		//Primary hits that need shading, compacted
+		struct ShadingQueue
+		{
+			std::vector<float> positionX{}, positionY{}, positionZ{};
+			std::vector<float> normalX{}, normalY{}, normalZ{};
+			std::vector<float> viewDirectionX{}, viewDirectionY{}, viewDirectionZ{};
+			std::vector<float> t{};
+			std::vector<uint32_t> rayIndex{};
+			std::vector<uint32_t> materialIndex{};
+			std::vector<ColorRGB> color{};
+			std::vector<ColorRGB> environmentColor{}; //summed apart and added last, like Renderer::ShadeEnvironment's
+
+			void Resize(size_t count);
+			size_t GetSize() const { return positionX.size(); }
+		};
+
+		//Shadow rays toward every light that faces the hit, stored light after light, then the environment's sample after sample
+		struct ShadowQueue
+		{
+			RayQueue rays{};
+			std::vector<uint32_t> shadingIndex{};
+			std::vector<float> cosine{};
+			std::vector<ColorRGB> radiance{}; //arriving at the hit if the ray is not occluded
+			std::vector<uint32_t> isOccluded{}; //as wide as a float lane, so the occlusion loops vectorize
+
+			void Resize(size_t count);
+			size_t GetSize() const { return rays.GetSize(); }
+		};
+
+		struct Bounds
+		{
+			float minX{}, minY{}, minZ{};
+			float maxX{}, maxY{}, maxZ{};
+
+			bool Overlaps(const Bounds& other) const
+			{
+				return minX <= other.maxX && maxX >= other.minX && minY <= other.maxY && maxY >= other.minY && minZ <= other.maxZ && maxZ >= other.minZ;
+			}
+		};
+
+		Settings m_Settings{};
+		Statistics m_Statistics{};
+
+		RayQueue m_PrimaryRays{};
+		HitQueue m_PrimaryHits{};
+		ShadingQueue m_Shading{};
+		ShadowQueue m_Shadows{};
+		std::vector<uint32_t> m_BinKeys{};
+		std::vector<uint32_t> m_BinOffsets{};
+		std::vector<uint32_t> m_HitOrder{}; //primary rays that hit, in bin order
+		std::vector<Bounds> m_TriangleBounds{};
+		std::atomic<size_t> m_OcclusionTestCount{};
+
+		//Primitive ids: spheres first, then planes, then the triangles of every mesh starting at its offset
+		std::vector<uint32_t> m_TriangleOffsets{};
+		std::vector<size_t> m_LightOffsets{}; //first shadow ray of each light, plus the end
+		std::vector<size_t> m_EnvironmentOffsets{}; //first environment shadow ray of each sample index, plus the end
+		std::vector<uint32_t> m_ChunkCounts{};
+		std::vector<uint32_t> m_ChunkIndices{};
+
+		void GeneratePrimaryRays(const CameraFrame& cameraFrame);
+		void FindClosestHits(const Scene* pScene);
+		void SortHits();
+		void CompactHits(const Scene* pScene);
+		void EmitShadowRays(const Renderer& renderer, const Scene* pScene, Renderer::LightingMode lightingMode);
+		void ResolveOcclusion(const Scene* pScene);
+		void Accumulate(const std::vector<Material>& materials, Renderer::LightingMode lightingMode, BRDF::Precision brdfPrecision);
+		//Accumulate's loop over the shadow rays [begin, end) of one range that reach materials of shadedType, a ShadingBatch at a time
+		template<MaterialType shadedType>
+		void AccumulateBatched(const std::vector<Material>& materials, Renderer::LightingMode lightingMode, std::vector<ColorRGB>& colors, size_t begin, size_t end);
+		void WriteFramebuffer(const Scene* pScene, Framebuffer& framebuffer);
+
+		//Edge test of GeometryUtils::HitTest_Triangle for a point on the triangle's plane, with the edge normal precomputed
+		static bool IsInsideEdge(const Vector3& edgeNormal, const Vector3& start, float pX, float pY, float pZ)
+		{
+			return (pX - start.x) * edgeNormal.x + (pY - start.y) * edgeNormal.y + (pZ - start.z) * edgeNormal.z >= 0;
+		}
+
+		//Calls function(begin, end) for every chunk of [0, count), in parallel
+		template<typename Function>
+		void ForEachChunk(size_t count, const Function& function);
+
+		//Stable parallel stream compaction: counts the kept elements per chunk, resizes the output to
+		//outputOffset + total and calls emit(input, output) for every element the predicate keeps
+		template<typename Predicate, typename Resize, typename Emit>
+		size_t Compact(size_t count, size_t outputOffset, const Predicate& predicate, const Resize& resize, const Emit& emit);
+	};
+}
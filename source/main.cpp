@@ -9,6 +9,9 @@
 
 //Project includes
 #include "Timer.h"
+#include "FrameEncoder.h"
+#include "FramePipeline.h"
+#include "Presenter.h"
 #include "Renderer.h"
 #include "Scene.h"
 
@@ -43,7 +46,10 @@ int main(int argc, char* args[])
 
 	//Initialize "framework"
 	const auto pTimer = new Timer();
-	const auto pRenderer = new Renderer(pWindow);
+	const auto pRenderer = new Renderer(width, height);
+	const auto pPresenter = new Presenter(pWindow);
+	const auto pEncoder = new FrameEncoder();
+	const auto pPipeline = new FramePipeline(*pPresenter, *pEncoder);
 
 	const auto pScene = new Scene_W4_Reference();
 	pScene->Initialize();
@@ -53,8 +59,13 @@ int main(int argc, char* args[])
 	float printTimer = 0.f;
 	bool isLooping = true;
 	bool takeScreenshot = false;
+	bool isCapturingSequence = false;
 	while (isLooping)
 	{
+		//--------- Present ---------
+		//Shows the last submitted frame once the pipeline's thread resolved it, SDL windows only take calls from this thread
+		pPipeline->Present();
+
 		//--------- Get input events ---------
 		SDL_Event e;
 		while (SDL_PollEvent(&e))
@@ -71,6 +82,22 @@ int main(int argc, char* args[])
 					pRenderer->ToggleShadows();
 				else if (e.key.keysym.scancode == SDL_SCANCODE_F3)
 					pRenderer->CycleLightingMode();
+				else if (e.key.keysym.scancode == SDL_SCANCODE_F4)
+					pRenderer->CycleRenderMode();
+				else if (e.key.keysym.scancode == SDL_SCANCODE_F5)
+					pPipeline->GetResolverSettings().CycleToneMapping();
+				else if (e.key.keysym.scancode == SDL_SCANCODE_F6)
+					pPipeline->GetResolverSettings().ToggleSRGBEncode();
+				else if (e.key.keysym.scancode == SDL_SCANCODE_F7)
+					isCapturingSequence = !isCapturingSequence;
+				else if (e.key.keysym.scancode == SDL_SCANCODE_F8)
+					pRenderer->CycleSamplerType();
+				else if (e.key.keysym.scancode == SDL_SCANCODE_F9)
+					pRenderer->CycleLightSelection();
+				else if (e.key.keysym.scancode == SDL_SCANCODE_F10)
+					pRenderer->ToggleVisibilityCache();
+				else if (e.key.keysym.scancode == SDL_SCANCODE_F11)
+					pRenderer->CycleIndirectMode();
 
 				break;
 			}
@@ -80,7 +107,16 @@ int main(int argc, char* args[])
 		pScene->Update(pTimer);
 
 		//--------- Render ---------
+		//Resolving and saving happen on the pipeline's thread while the next frame renders
 		pRenderer->Render(pScene);
+		FramePipeline::Capture capture{ FramePipeline::Capture::None };
+		if (takeScreenshot)
+			capture = FramePipeline::Capture::Screenshot;
+		else if (isCapturingSequence)
+			capture = FramePipeline::Capture::SequenceFrame;
+
+		pPipeline->Submit(pRenderer->GetFramebuffer(), capture);
+		takeScreenshot = false;
 
 		//--------- Timer ---------
 		pTimer->Update();
@@ -89,22 +125,21 @@ int main(int argc, char* args[])
 		{
 			printTimer = 0.f;
 			std::cout << "dFPS: " << pTimer->GetdFPS() << std::endl;
-		}
 
-		//Save screenshot after full render
-		if (takeScreenshot)
-		{
-			if (!pRenderer->SaveBufferToImage())
-				std::cout << "Screenshot saved!" << std::endl;
-			else
-				std::cout << "Something went wrong. Screenshot not saved!" << std::endl;
-			takeScreenshot = false;
+			if (pRenderer->GetAverageSamplesPerPixel() > 1.f)
+				std::cout << "Average samples per pixel: " << pRenderer->GetAverageSamplesPerPixel() << std::endl;
+
+			if (pRenderer->GetResolutionScale() < 1.f)
+				std::cout << "Resolution scale: " << pRenderer->GetResolutionScale() << std::endl;
 		}
 	}
 	pTimer->Stop();
 
 	//Shutdown "framework"
 	delete pScene;
+	delete pPipeline;
+	delete pEncoder;
+	delete pPresenter;
 	delete pRenderer;
 	delete pTimer;
 
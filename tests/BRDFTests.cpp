@@ -0,0 +1,20 @@
+//Standard includes
+#include <iostream>
+
+//Project includes
+#include "BRDFs.h"
+
+using namespace dae;
+
+//Fails when a BRDF::Fast approximation drifts past its error bound, BRDF::Precision::Fast would then shade visibly differently
+int main()
+{
+	if (!BRDF::Fast::AreWithinErrorBounds())
+	{
+		std::cerr << "A fast BRDF approximation exceeds its error bound of " << BRDF::Fast::RELATIVE_ERROR << " relative, " << BRDF::Fast::POW_RELATIVE_ERROR << " for Pow" << std::endl;
+		return 1;
+	}
+
+	std::cout << "Fast BRDF approximations are within their error bounds" << std::endl;
+	return 0;
+}
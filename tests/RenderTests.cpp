@@ -0,0 +1,53 @@
+//Standard includes
+#include <iostream>
+
+//Project includes
+#include "Renderer.h"
+#include "Scene.h"
+
+using namespace dae;
+
+namespace
+{
+	//Average luminance of the bottom quarter of the frame, the Outdoor camera only sees ground there
+	float GetGroundMean(Renderer::IndirectMode indirectMode)
+	{
+		Scene_Outdoor scene{};
+		scene.Initialize();
+
+		Renderer renderer{ 80, 60 };
+		renderer.SetIndirectMode(indirectMode);
+		renderer.Render(&scene);
+
+		const Framebuffer& framebuffer = renderer.GetFramebuffer();
+		float sum{};
+		int count{};
+		for (int py{ framebuffer.GetHeight() * 3 / 4 }; py < framebuffer.GetHeight(); ++py)
+		{
+			for (int px{}; px < framebuffer.GetWidth(); ++px)
+			{
+				const ColorRGB& color = framebuffer.At(px, py);
+				sum += (color.r + color.g + color.b) / 3.f;
+				++count;
+			}
+		}
+
+		return sum / static_cast<float>(count);
+	}
+}
+
+//Fails when turning indirect light on counts the sky a second time, the ground is lit by the sky directly and only by bounces indirectly
+int main()
+{
+	const float directMean = GetGroundMean(Renderer::IndirectMode::Off);
+	const float indirectMean = GetGroundMean(Renderer::IndirectMode::Sampled);
+	std::cout << "Outdoor ground mean: " << directMean << " direct, " << indirectMean << " with indirect light" << std::endl;
+
+	if (indirectMean < directMean || indirectMean > directMean * 1.25f)
+	{
+		std::cerr << "Indirect light should add only the light bounced off the scene to the ground" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
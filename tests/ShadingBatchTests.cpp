@@ -0,0 +1,105 @@
+//Standard includes
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+//Project includes
+#include "BRDFs.h"
+#include "ShadingBatch.h"
+
+using namespace dae;
+
+namespace
+{
+	struct ShadingPoint
+	{
+		Material material;
+		Vector3 normal;
+		Vector3 lightDirection;
+		Vector3 viewDirection;
+	};
+
+	//Shading points that light and view from above the surface at varied angles, one material each
+	std::vector<ShadingPoint> CreatePoints(const std::vector<Material>& materials)
+	{
+		std::vector<ShadingPoint> points{};
+		for (size_t i{}; i < materials.size(); ++i)
+		{
+			const float angle = 0.2f + 0.15f * i;
+			const Vector3 normal = Vector3{ 0.1f * i, 1.f, -0.05f * i }.Normalized();
+			const Vector3 lightDirection = Vector3{ sinf(angle), cosf(angle), 0.3f }.Normalized();
+			const Vector3 viewDirection = Vector3{ 0.2f * sinf(2.f * angle), -1.f, 0.4f - 0.1f * i }.Normalized();
+			points.push_back({ materials[i], normal, lightDirection, viewDirection });
+		}
+		return points;
+	}
+
+	//Fills a batch with fewer than maxSize points, so the last register is partial, and compares it with Material::Shade
+	template<MaterialType shadedType>
+	bool DoesBatchMatchShade(const std::vector<Material>& materials)
+	{
+		static_assert(ShadingBatch::IsBatched(shadedType));
+
+		const std::vector<ShadingPoint> points = CreatePoints(materials);
+		if (points.size() >= ShadingBatch::maxSize)
+			return false;
+
+		ShadingBatch batch{};
+		for (const ShadingPoint& point : points)
+			batch.Add<shadedType>(point.material, point.normal, point.lightDirection, point.viewDirection);
+		batch.Shade<shadedType>();
+
+		bool isMatching{ true };
+		for (uint32_t i{}; i < points.size(); ++i)
+		{
+			const ShadingPoint& point = points[i];
+			HitRecord hitRecord{};
+			hitRecord.normal = point.normal;
+
+			const ColorRGB expected = point.material.Shade<shadedType>(hitRecord, point.lightDirection, point.viewDirection, BRDF::Precision::Fast);
+			const ColorRGB actual = batch.GetBRDF(i);
+
+			const auto isClose = [](float a, float b) { return fabsf(a - b) <= BRDF::Fast::RELATIVE_ERROR * fabsf(b) + BRDF::Fast::ABSOLUTE_ERROR; };
+			if (!isClose(actual.r, expected.r) || !isClose(actual.g, expected.g) || !isClose(actual.b, expected.b))
+			{
+				std::cerr << "Point " << i << " of type " << int(shadedType) << ": batch (" << actual.r << ", " << actual.g << ", " << actual.b
+					<< ") but Material::Shade (" << expected.r << ", " << expected.g << ", " << expected.b << ")" << std::endl;
+				isMatching = false;
+			}
+		}
+
+		return isMatching;
+	}
+}
+
+//Fails when ShadingBatch shades a point differently from Material::Shade with BRDF::Precision::Fast
+int main()
+{
+	const std::vector<Material> phongMaterials{
+		Material::LambertPhong({ 0.9f, 0.2f, 0.1f }, 0.5f, 0.5f, 1.f),
+		Material::LambertPhong(colors::White, 1.f, 0.3f, 5.f),
+		Material::LambertPhong({ 0.2f, 0.6f, 0.9f }, 0.7f, 0.8f, 20.f),
+		Material::LambertPhong(colors::White, 0.5f, 0.5f, 60.f),
+		Material::LambertPhong({ 0.4f, 0.4f, 0.4f }, 0.2f, 1.f, 128.f)
+	};
+
+	const std::vector<Material> cookTorranceMaterials{
+		Material::CookTorrence({ 0.972f, 0.960f, 0.915f }, 1.f, 0.1f),
+		Material::CookTorrence({ 0.75f, 0.75f, 0.75f }, 0.f, 1.f),
+		Material::CookTorrence({ 0.955f, 0.638f, 0.538f }, 1.f, 0.6f),
+		Material::CookTorrence({ 0.2f, 0.5f, 0.8f }, 0.f, 0.3f),
+		Material::CookTorrence({ 0.913f, 0.922f, 0.924f }, 1.f, 0.05f),
+		Material::CookTorrence({ 0.9f, 0.1f, 0.1f }, 0.f, 0.6f)
+	};
+
+	const bool isPhongMatching = DoesBatchMatchShade<MaterialType::LambertPhong>(phongMaterials);
+	const bool isCookTorranceMatching = DoesBatchMatchShade<MaterialType::CookTorrence>(cookTorranceMaterials);
+	if (!isPhongMatching || !isCookTorranceMatching)
+	{
+		std::cerr << "ShadingBatch does not match Material::Shade with fast BRDFs" << std::endl;
+		return 1;
+	}
+
+	std::cout << "ShadingBatch matches Material::Shade with fast BRDFs" << std::endl;
+	return 0;
+}